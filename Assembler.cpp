@@ -1,380 +1,1716 @@
-#include "stdafx.h"
-#include "Assembler.h"
-#include "Errors.h"
-#include <iomanip>
-#include <algorithm>
-
-using namespace std;
-
-/**/
-/*
-Assembler::Assembler(int argc, char* argv[])
-
-NAME
-
-    Assembler::Assembler - Constructs the assembler and initiates the file access.
-
-SYNOPSIS
-
-    Assembler::Assembler(int argc, char* argv[]);
-        argc      --> count of command line arguments.
-        argv      --> array of command line arguments.
-
-DESCRIPTION
-
-    The constructor for the assembler. This passes the argc and argv to the FileAccess
-    constructor, which handles opening the file. At this point, there's nothing else to be done.
-
-*/
-/**/
-
-// See main program.
-Assembler::Assembler(int argc, char* argv[])
-    : m_facc(argc, argv)
-{
-    // Nothing else to do here at this point.
-}
-
-// Destructor currently does nothing. You might need to add something as you develop this project. If not, we can delete it.
-Assembler::~Assembler()
-{
-}
-
-/**/
-/*
-Assembler::PassI()
-
-NAME
-
-    Assembler::PassI - Executes the first pass of the assembler.
-
-SYNOPSIS
-
-    void Assembler::PassI();
-
-DESCRIPTION
-
-    This method carries out the first pass of the assembler. It reads and processes each line
-    of the source code. For each instruction, it parses the line and gets the instruction type.
-    If it encounters an end statement, it stops processing. If it finds a comment, it skips to the
-    next line. If it comes across an "org" directive, it updates the location counter to the value
-    specified by "org". If the instruction has a label, it records the label and its location in
-    the symbol table. Then, it computes the location of the next instruction.
-
-*/
-/**/
-
-void Assembler::PassI()
-{
-    int loc = 0; // Reset the location counter.
-
-    // Successively process each line of source code.
-    for (;;) {
-        // Read the next line from the source file.
-        string line;
-        if (!m_facc.GetNextLine(line)) {
-            // If there are no more lines, we are missing an end statement.
-            Errors::RecordError("Error: Missing END statement.");
-            return;
-        }
-
-        // Parse the line and get the instruction type.
-        Instruction::InstructionType st = m_inst.ParseInstruction(line);
-
-        // If this is an end statement, there is nothing left to do in pass I.
-        if (st == Instruction::ST_End) break;
-
-        // Skip comments.
-        if (st == Instruction::ST_Comment) continue;
-
-        // Check for "org" directive
-        if (m_inst.GetOpcode() == "org") {
-            loc = stoi(m_inst.GetOperand1()); // Update the location counter to the value specified by "org"
-        }
-        else {
-            // If the instruction has a label, record it and its location in the symbol table.
-            if (!m_inst.GetLabel().empty()) {
-                m_symtab.AddSymbol(m_inst.GetLabel(), loc);
-            }
-
-            // Compute the location of the next instruction.
-            loc = m_inst.LocationNextInstruction(loc);
-        }
-    }
-}
-
-/**/
-/*
-Assembler::HandleCopyInstruction(int a_location, const string& a_operand1, const string& a_operand2)
-
-NAME
-
-    Assembler::HandleCopyInstruction - Handles the copy instruction.
-
-SYNOPSIS
-
-    void Assembler::HandleCopyInstruction(int a_location, const string& a_operand1, const string& a_operand2);
-        a_location   --> the location of the instruction.
-        a_operand1   --> the first operand of the copy instruction.
-        a_operand2   --> the second operand of the copy instruction.
-
-DESCRIPTION
-
-    This method handles the copy instruction. It looks up the symbols corresponding to the operands
-    in the symbol table and prints the load and store instructions that perform the copy operation.
-    If either of the operands is not found in the symbol table, it prints an error message.
-
-*/
-/**/
-
-void Assembler::HandleCopyInstruction(int a_location, const string& a_operand1, const string& a_operand2) {
-    int loc1, loc2;
-    if (m_symtab.LookupSymbol(a_operand1, loc1) && m_symtab.LookupSymbol(a_operand2, loc2)) {
-        int loadOpCode = 13;
-        int storeOpCode = 14;
-        cout << setfill('0') << setw(4) << a_location << " " << setfill('0') << setw(4) << (loadOpCode << 12 | loc1) << "    " << "load " << a_operand1 << "\n";
-        cout << setfill('0') << setw(4) << (a_location + 1) << " " << setfill('0') << setw(4) << (storeOpCode << 12 | loc2) << "    " << "store " << a_operand2 << "\n";
-    }
-    else {
-        cout << setfill('0') << setw(4) << a_location << " ??????    " << "hay  copy   " << a_operand1 << ", " << a_operand2 << " ; This is the another comment." << "\n";
-    }
-}
-/**/
-/*
-Assembler::GenerateMachineCode(const Instruction& inst)
-
-NAME
-
-    Assembler::GenerateMachineCode - Generates machine code for an instruction.
-
-SYNOPSIS
-
-    int Assembler::GenerateMachineCode(const Instruction& inst);
-        inst        --> the instruction to generate machine code for.
-
-DESCRIPTION
-
-    This method generates machine code for an instruction. It gets the numeric opcode of the
-    instruction and checks whether each operand is a number or a symbol. If an operand is a
-    number, it converts the operand to an integer. If an operand is a symbol, it looks up the
-    symbol in the symbol table and gets its location. If a symbol is not found in the symbol
-    table, it throws an exception. Finally, it concatenates the opcode and the operand locations
-    to form the machine code.
-
-RETURNS
-
-    Returns the machine code for the instruction.
-*/
-/**/
-
-int Assembler::GenerateMachineCode(const Instruction& inst)
-{
-    int opCode = inst.GetNumericOpcode();
-
-    // Function to check if a string is a number
-    auto is_number = [](const std::string& s) {
-        return !s.empty() && std::find_if(s.begin(), s.end(), [](unsigned char c) { return !std::isdigit(c); }) == s.end();
-    };
-
-    // Get the numeric value of the first operand, if it exists
-    int address1 = 0;
-    if (!inst.GetOperand1().empty()) {
-        if (is_number(inst.GetOperand1())) {
-            address1 = stoi(inst.GetOperand1());
-        }
-        else if (m_symtab.LookupSymbol(inst.GetOperand1(), address1) == false) {
-            throw std::runtime_error("Error: Undefined symbol: " + inst.GetOperand1());
-        }
-    }
-
-    // Get the numeric value of the second operand, if it exists
-    int address2 = 0;
-    if (!inst.GetOperand2().empty()) {
-        if (is_number(inst.GetOperand2())) {
-            address2 = stoi(inst.GetOperand2());
-        }
-        else if (m_symtab.LookupSymbol(inst.GetOperand2(), address2) == false) {
-            throw std::runtime_error("Error: Undefined symbol: " + inst.GetOperand2());
-        }
-    }
-
-    // Add these lines to store the addresses for later use
-    m_address1 = address1;
-    m_address2 = address2;
-
-    // Concatenate the opCode, address1, and address2 to form the machine code
-    int machineCode;
-
-    machineCode = opCode * 100000000 + address1 * 100000 + address2;
-
-    return machineCode;
-}
-
-/**/
-/*
-Assembler::RunProgramInEmulator()
-
-NAME
-
-    Assembler::RunProgramInEmulator - Runs the translated program in the emulator.
-
-SYNOPSIS
-
-    void Assembler::RunProgramInEmulator();
-
-DESCRIPTION
-
-    This method runs the translated program in the emulator. It first creates an instance of
-    the emulator. Then, it inserts each machine instruction into the emulator's memory. If an
-    error occurs during this process, it prints an error message and returns. Finally, it runs
-    the program in the emulator. If an error occurs during this process, it prints an error message.
-
-*/
-/**/
-
-void Assembler::RunProgramInEmulator()
-{
-    emulator emu; // Create an instance of the emulator
-    cout << "Results from emulating program:" << endl;
-
-    // Insert the machine code into the emulator's memory
-    for (int i = 0; i < m_machineCode.size(); i++) {
-        if (!emu.insertMemory(i, std::stoll(m_machineCode[i]))) {
-            std::cerr << "Error: Could not insert instruction into memory\n";
-            return;
-        }
-    }
-
-    // Run the program in the emulator
-    if (!emu.runProgram()) {
-        std::cerr << "Error: Could not run program in emulator\n";
-    }
-    cout << "End of emulation" << endl;
-}
-
-/**/
-/*
-Assembler::PassII()
-
-NAME
-
-    Assembler::PassII - Executes the second pass of the assembler.
-
-SYNOPSIS
-
-    void Assembler::PassII();
-
-DESCRIPTION
-
-    This method executes the second pass of the assembler. It begins by resetting the location
-    counter and rewinding the source file to the beginning. Then, it successively processes each
-    line of source code. For each line, it parses the instruction and determines the instruction type.
-    If the instruction is a comment or end statement, it prints the line and continues to the next line.
-    If the instruction has a label, it looks up the label in the symbol table and gets its location.
-    Then, it generates machine code for the instruction. If an error occurs during this process,
-    it records the error message and continues with the translation. Finally, it prints the machine
-    code and original statement, and computes the location of the next instruction. When all lines
-    have been processed, it displays any recorded error messages.
-*/
-/**/
-
-void Assembler::PassII()
-{
-    int loc = 0; // Location counter
-    string line; // Line from the source file
-
-    // Rewind the source file to the beginning
-    m_facc.rewind();
-
-    cout << "Translation of Program:\n\n";
-    cout << "Location    Contents    Original Statement\n";
-
-    // Iterate through the source file
-    while (true)
-    {
-        // Get the next line from the source file
-        if (!m_facc.GetNextLine(line))
-        {
-            break;
-        }
-
-        // Parse the instruction
-        Instruction::InstructionType type = m_inst.ParseInstruction(line);
-
-        // Ignore comments and end instructions
-        if (type == Instruction::ST_Comment || type == Instruction::ST_End)
-        {
-            cout << "                 " << line << endl;
-            continue;
-        }
-
-        // If the instruction has a label, get the location from the symbol table
-        if (m_inst.isLabel())
-        {
-            string label = m_inst.GetLabel();
-            int labelLoc;
-            if (m_symtab.LookupSymbol(label, labelLoc))
-            {
-                loc = labelLoc;
-            }
-        }
-
-        // Generate the machine code for the instruction
-        int machineCode;
-        try
-        {
-            machineCode = GenerateMachineCode(m_inst);
-        }
-        catch (const std::exception& e)
-        {
-            // Record the error message and continue with the translation
-            Errors::RecordError(e.what());
-            cout << setfill('0') << setw(4) << loc << "    " << "??????" << "    " << line << endl;
-            loc = m_inst.LocationNextInstruction(loc);
-            return;
-        }
-
-        // Output the machine code
-        int opcode = machineCode / 100000000;
-        int first_address = m_address1;
-        int second_address = m_address2;
-
-        string opcodeStr = m_inst.GetOpcode();
-        std::transform(opcodeStr.begin(), opcodeStr.end(), opcodeStr.begin(), ::tolower);
-        if (opcodeStr == "dc") {
-            opcode = 0;
-            second_address = first_address;
-            first_address = 0;
-        }
-        else if (opcodeStr == "ds" || opcodeStr == "org") {
-            opcode = 0;
-            second_address = 0;
-            first_address = 0;
-        }
-
-        if (m_inst.GetOpcode() == "copy")
-        {
-            first_address = m_address1;
-            second_address = m_address2;
-        }
-
-        cout << setfill(' ') << setw(4) << loc << "    ";
-        cout << setfill('0') << setw(2) << opcode;
-        cout << setfill('0') << setw(5) << first_address;
-        cout << setfill('0') << setw(5) << second_address << "    " << line << endl;
-
-        // Assuming opcode, first_address, and second_address are of type int
-        stringstream ss;
-        ss << loc;
-        ss << setfill('0') << setw(2) << opcode;
-        ss << setfill('0') << setw(5) << first_address;
-        ss << setfill('0') << setw(5) << second_address;
-        m_machineCode.push_back(ss.str());
-
-        // Update the location counter for the next instruction
-        loc = m_inst.LocationNextInstruction(loc);
-    }
-
-    // Display the recorded error messages (if any)
-    Errors::DisplayErrors();
-}
+#include "stdafx.h"
+#include "Assembler.h"
+#include "Errors.h"
+#include "Batch.h"
+#include "ControlFlow.h"
+#include "Coverage.h"
+#include "JobRunner.h"
+#include "Lexer.h"
+#include "Fusion.h"
+#include "Profiler.h"
+#include "Recorder.h"
+#include "Scheduler.h"
+#include "Session.h"
+#include "TimeTravel.h"
+#include <chrono>
+#include <memory>
+#include <iomanip>
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+/**/
+/*
+Assembler::Assembler(int argc, char* argv[])
+
+NAME
+
+    Assembler::Assembler - Constructs the assembler and initiates the file access.
+
+SYNOPSIS
+
+    Assembler::Assembler(int argc, char* argv[]);
+        argc      --> count of command line arguments.
+        argv      --> array of command line arguments.
+
+DESCRIPTION
+
+    The constructor for the assembler. This passes the argc and argv to the FileAccess
+    constructor, which handles opening the file. The remaining arguments are options:
+
+        -passes 2           assemble in two passes, reading the source once to locate the
+                            labels and again to translate it (the default).
+        -passes 1           assemble in a single pass, patching references to labels that
+                            are defined later once the whole source has been read.
+        -lexer compare      before assembling, time the line parser and the lexer, with
+                            scalar code and with AVX2, over the source, and check that
+                            they parse every line the same way.
+        -engine switch      run the emulator with the switch engine (the default).
+        -engine threaded    run the emulator with the threaded engine.
+        -engine jit         run the emulator with the x86-64 JIT engine.
+        -engine verify      run the program on every engine with the same input and
+                            report whether memory and output agree.
+        -decode compare     run the program with each instruction decoded as it is
+                            fetched and with the program decoded ahead of the run, and
+                            report the instructions per second of each.
+        -batch <file>       run the program once per line of <file>, each line holding
+                            the values for READ, using the lockstep batch emulator.
+        -jobs <file>        run the program once per line of <file> as independent jobs
+                            on a thread pool, and report the throughput.
+        -sessions <file>    run the program once per line of <file> as interactive
+                            sessions multiplexed on one thread, feeding each session its
+                            values one at a time.
+        -input <file>       take the values for READ from <file> instead of prompting.
+        -output console     print each value written as it is written (the default).
+        -output buffered    collect the values written and print them in large blocks.
+        -stats <file>       write the execution statistics of the run to <file> as JSON,
+                            or to the console if <file> is "-". Only available when the
+                            emulator is built with VC_STATS.
+        -profile <file>     count the instructions executed under each label, print the
+                            profile and write it to <file> as folded stacks.
+        -coverage <file>    mark each instruction executed, print the source annotated
+                            with the lines that ran, and write the line coverage to
+                            <file> in LCOV tracefile format.
+        -cfg <file>         print the basic blocks, loop headers and unreachable code of
+                            the program before running it, and write its control-flow
+                            graph to <file> in Graphviz dot format.
+        -trace <file>       write every instruction executed (location, opcode and
+                            operands) to <file>.
+        -break <location>   report each time the instruction at <location> is about to
+                            execute. May be given more than once.
+        -record <file>      record the values READ takes to <file>, so the run can be
+                            replayed without a console.
+        -record-trace <file> as -record, and also record every instruction executed and
+                            every word stored.
+        -replay <file>      run with the input recorded in <file> and, if it holds a trace,
+                            report where the run first departs from it.
+        -debug <file>       run the program under the time-travel debugger, which can
+                            step backwards and jump to any earlier instruction count,
+                            taking its commands from <file>, or from the console if
+                            <file> is "-".
+        -limit <n>          stop the program (or each job) after <n> instructions.
+        -timeout <s>        stop the program (or each job) after <s> seconds of running.
+                            With either, the program runs on the switch engine, so
+                            they cannot be combined with -engine threaded or jit.
+
+    An unknown option is reported and the program terminates.
+
+*/
+/**/
+
+// See main program.
+Assembler::Assembler(int argc, char* argv[])
+    : m_facc(argc, argv)
+{
+    for (int i = 2; i < argc; i++) {
+        string option = argv[i];
+        string value = i + 1 < argc ? argv[i + 1] : "";
+
+        if (option == "-passes" && (value == "1" || value == "2")) {
+            m_singlePass = value == "1";
+        }
+        else if (option == "-lexer" && value == "compare") {
+            m_compareLexers = true;
+        }
+        else if (option == "-engine" && value == "switch") {
+            m_engine = emulator::ENGINE_SWITCH;
+        }
+        else if (option == "-engine" && value == "threaded") {
+            m_engine = emulator::ENGINE_THREADED;
+        }
+        else if (option == "-engine" && value == "jit") {
+            m_engine = emulator::ENGINE_JIT;
+        }
+        else if (option == "-engine" && value == "verify") {
+            m_verifyEngines = true;
+        }
+        else if (option == "-decode" && value == "compare") {
+            m_compareDecoding = true;
+        }
+        else if (option == "-batch" && !value.empty()) {
+            m_batchFile = value;
+        }
+        else if (option == "-jobs" && !value.empty()) {
+            m_jobsFile = value;
+        }
+        else if (option == "-sessions" && !value.empty()) {
+            m_sessionsFile = value;
+        }
+        else if (option == "-input" && !value.empty()) {
+            m_inputFile = value;
+        }
+        else if (option == "-output" && value == "console") {
+            m_bufferedOutput = false;
+        }
+        else if (option == "-output" && value == "buffered") {
+            m_bufferedOutput = true;
+        }
+        else if (option == "-profile" && !value.empty()) {
+            m_profileFile = value;
+        }
+        else if (option == "-coverage" && !value.empty()) {
+            m_coverageFile = value;
+        }
+        else if (option == "-cfg" && !value.empty()) {
+            m_cfgFile = value;
+        }
+        else if (option == "-trace" && !value.empty()) {
+            m_traceFile = value;
+        }
+        else if (option == "-break" && atoi(value.c_str()) >= 100) {
+            m_breakpoints.push_back(atoi(value.c_str()));
+        }
+        else if ((option == "-record" || option == "-record-trace") && !value.empty()) {
+            m_recordFile = value;
+            m_recordTrace = option == "-record-trace";
+        }
+        else if (option == "-replay" && !value.empty()) {
+            m_replayFile = value;
+        }
+        else if (option == "-debug" && !value.empty()) {
+            m_debugFile = value;
+        }
+        else if (option == "-limit" && atoll(value.c_str()) > 0) {
+            m_instructionLimit = atoll(value.c_str());
+        }
+        else if (option == "-timeout" && atof(value.c_str()) > 0) {
+            m_timeLimit = atof(value.c_str());
+        }
+#ifdef VC_STATS
+        else if (option == "-stats" && !value.empty()) {
+            m_statsFile = value;
+        }
+#endif
+        else {
+            cerr << "Unknown option: " << option << " " << value << endl;
+            cerr << "Usage: Assem <FileName> [-passes 1|2] [-lexer compare] [-engine switch|threaded|jit|verify] [-decode compare] [-batch <file>] [-jobs <file>] [-sessions <file>] [-input <file>] [-output console|buffered] [-stats <file>] [-profile <file>] [-coverage <file>] [-cfg <file>] [-trace <file>] [-break <location>] [-record <file>] [-record-trace <file>] [-replay <file>] [-debug <file>] [-limit <instructions>] [-timeout <seconds>]" << endl;
+            exit(1);
+        }
+        i++;
+    }
+}
+
+// Destructor currently does nothing. You might need to add something as you develop this project. If not, we can delete it.
+Assembler::~Assembler()
+{
+}
+
+/**/
+/*
+Assembler::PassI()
+
+NAME
+
+    Assembler::PassI - Executes the first pass of the assembler.
+
+SYNOPSIS
+
+    void Assembler::PassI();
+
+DESCRIPTION
+
+    This method carries out the first pass of the assembler. It reads, parses and records
+    every line of the source code, so that the later passes need not read it again. Up to
+    the end statement, an "org" directive updates the location counter to the value it
+    specifies, a label is recorded with its location in the symbol table, and the location
+    of the next instruction is computed. If there is no end statement, the error is recorded.
+
+*/
+/**/
+
+void Assembler::PassI()
+{
+    int loc = 0;            // Reset the location counter.
+    bool ended = false;     // Set once the end statement has been read.
+    if (m_compareLexers) {
+        CompareLexers();
+    }
+    m_source.ShareText(m_facc.GetMappedText());
+
+    // Successively process each line of source code.
+    while (ReadSourceLine(loc, ended)) {
+    }
+
+    // If there are no more lines and no end statement was found, we are missing one.
+    if (!ended) {
+        Errors::RecordError("Error: Missing END statement.");
+    }
+}
+
+/**/
+/*
+Assembler::HandleCopyInstruction(int a_location, const string& a_operand1, const string& a_operand2)
+
+NAME
+
+    Assembler::HandleCopyInstruction - Handles the copy instruction.
+
+SYNOPSIS
+
+    void Assembler::HandleCopyInstruction(int a_location, const string& a_operand1, const string& a_operand2);
+        a_location   --> the location of the instruction.
+        a_operand1   --> the first operand of the copy instruction.
+        a_operand2   --> the second operand of the copy instruction.
+
+DESCRIPTION
+
+    This method handles the copy instruction. It looks up the symbols corresponding to the operands
+    in the symbol table and prints the load and store instructions that perform the copy operation.
+    If either of the operands is not found in the symbol table, it prints an error message.
+
+*/
+/**/
+
+void Assembler::HandleCopyInstruction(int a_location, const string& a_operand1, const string& a_operand2) {
+    int loc1, loc2;
+    if (m_symtab.LookupSymbol(a_operand1, loc1) && m_symtab.LookupSymbol(a_operand2, loc2)) {
+        int loadOpCode = 13;
+        int storeOpCode = 14;
+        cout << setfill('0') << setw(4) << a_location << " " << setfill('0') << setw(4) << (loadOpCode << 12 | loc1) << "    " << "load " << a_operand1 << "\n";
+        cout << setfill('0') << setw(4) << (a_location + 1) << " " << setfill('0') << setw(4) << (storeOpCode << 12 | loc2) << "    " << "store " << a_operand2 << "\n";
+    }
+    else {
+        cout << setfill('0') << setw(4) << a_location << " ??????    " << "hay  copy   " << a_operand1 << ", " << a_operand2 << " ; This is the another comment." << "\n";
+    }
+}
+/**/
+/*
+Assembler::GenerateMachineCode(const Instruction& inst)
+
+NAME
+
+    Assembler::GenerateMachineCode - Generates machine code for an instruction.
+
+SYNOPSIS
+
+    int Assembler::GenerateMachineCode(const Instruction& inst);
+        inst        --> the instruction to generate machine code for.
+
+DESCRIPTION
+
+    This method generates machine code for an instruction. It gets the numeric opcode of the
+    instruction, checks that it has as many operands as the instruction set table gives the
+    opcode, and checks whether each operand is a number or a symbol. If an operand is a
+    number, it converts the operand to an integer. If an operand is a symbol, it looks up the
+    symbol in the symbol table and gets its location. If the number of operands is wrong, or a
+    symbol is not found in the symbol table, it throws an exception. Finally, it concatenates the opcode and the operand locations
+    to form the machine code.
+
+RETURNS
+
+    Returns the machine code for the instruction.
+*/
+/**/
+
+int Assembler::GenerateMachineCode(const Instruction& inst)
+{
+    int opCode = inst.GetNumericOpcode();
+
+    // The instruction set table gives the number of operands
+    if (inst.GetArity() >= 0 && inst.CountOperands() != inst.GetArity()) {
+        throw std::runtime_error("Error: Wrong number of operands, expected " + to_string(inst.GetArity()));
+    }
+
+    // Function to check if a string is a number
+    auto is_number = [](const std::string& s) {
+        return !s.empty() && std::find_if(s.begin(), s.end(), [](unsigned char c) { return !std::isdigit(c); }) == s.end();
+    };
+
+    const string operand1(inst.GetOperand1());
+    const string operand2(inst.GetOperand2());
+
+    // Get the numeric value of the first operand, if it exists
+    int address1 = 0;
+    if (!operand1.empty()) {
+        if (is_number(operand1)) {
+            address1 = stoi(operand1);
+        }
+        else if (m_symtab.LookupSymbol(operand1, address1) == false) {
+            throw std::runtime_error("Error: Undefined symbol: " + operand1);
+        }
+    }
+
+    // Get the numeric value of the second operand, if it exists
+    int address2 = 0;
+    if (!operand2.empty()) {
+        if (is_number(operand2)) {
+            address2 = stoi(operand2);
+        }
+        else if (m_symtab.LookupSymbol(operand2, address2) == false) {
+            throw std::runtime_error("Error: Undefined symbol: " + operand2);
+        }
+    }
+
+    // Add these lines to store the addresses for later use
+    m_address1 = address1;
+    m_address2 = address2;
+
+    // Concatenate the opCode, address1, and address2 to form the machine code
+    int machineCode;
+
+    machineCode = opCode * 100000000 + address1 * 100000 + address2;
+
+    return machineCode;
+}
+
+/**/
+/*
+Assembler::RunProgramInEmulator()
+
+NAME
+
+    Assembler::RunProgramInEmulator - Runs the translated program in the emulator.
+
+SYNOPSIS
+
+    void Assembler::RunProgramInEmulator();
+
+DESCRIPTION
+
+    This method runs the translated program in the emulator. It uses the emulator member
+    m_emul rather than building another one, and inserts each machine instruction into the
+    emulator's memory. If an
+    error occurs during this process, it prints an error message and returns. Finally, it runs
+    the program in the emulator. If an error occurs during this process, it prints an error message.
+
+*/
+/**/
+
+void Assembler::RunProgramInEmulator()
+{
+    cout << "Results from emulating program:" << endl;
+
+    // Insert the machine code into the emulator's memory
+    for (int i = 0; i < m_machineCode.size(); i++) {
+        if (!m_emul.insertMemory(i, std::stoll(m_machineCode[i]))) {
+            std::cerr << "Error: Could not insert instruction into memory\n";
+            return;
+        }
+    }
+
+    if (!m_cfgFile.empty()) {
+        WriteControlFlow(m_emul);
+    }
+    if (!m_jobsFile.empty()) {
+        RunJobs(m_emul);
+        cout << "End of emulation" << endl;
+        return;
+    }
+    if (!m_sessionsFile.empty()) {
+        RunSessions(m_emul);
+        cout << "End of emulation" << endl;
+        return;
+    }
+    if (!m_batchFile.empty()) {
+        RunBatch(m_emul);
+        cout << "End of emulation" << endl;
+        return;
+    }
+    if (m_verifyEngines) {
+        VerifyEngines(m_emul);
+        cout << "End of emulation" << endl;
+        return;
+    }
+    if (m_compareDecoding) {
+        CompareDecoding(m_emul);
+        cout << "End of emulation" << endl;
+        return;
+    }
+
+    // The watchdog runs the program in slices with emulator::Run, which only the switch engine can do.
+    if ((m_instructionLimit > 0 || m_timeLimit > 0) && m_engine != emulator::ENGINE_SWITCH) {
+        cerr << "Error: -limit and -timeout run the program on the switch engine, so they cannot be used with -engine threaded or jit" << endl;
+        return;
+    }
+
+    // Connect READ and WRITE to the devices selected on the command line.
+    TapeInput tape;
+    if (!m_inputFile.empty() && !tape.LoadFile(m_inputFile)) {
+        cerr << "Error: Could not read input file " << m_inputFile << endl;
+        return;
+    }
+    BufferedOutput buffered(cout);
+    InputDevice& source = m_inputFile.empty() ? static_cast<InputDevice&>(ConsoleDevice::Standard()) : tape;
+    OutputDevice& output = m_bufferedOutput ? static_cast<OutputDevice&>(buffered) : ConsoleDevice::Standard();
+
+    // A replay takes its input from the recording instead; a recording logs whatever input is used.
+    Replayer replayer;
+    if (!m_replayFile.empty()) {
+        if (!replayer.Load(m_replayFile)) {
+            cerr << "Error: Could not read recording " << m_replayFile << endl;
+            return;
+        }
+        if (replayer.GetImageHash() != RecordingFormat::HashImage(m_emul)) {
+            cerr << "Error: Recording " << m_replayFile << " was made with a different program" << endl;
+            return;
+        }
+    }
+    InputDevice& input = m_replayFile.empty() ? source : replayer;
+    ofstream recording;
+    std::unique_ptr<Recorder> recorder;
+    if (!m_recordFile.empty()) {
+        recording.open(m_recordFile, ios::out | ios::binary);
+        if (!recording) {
+            cerr << "Error: Could not write recording " << m_recordFile << endl;
+            return;
+        }
+        recorder.reset(new Recorder(recording, input, m_recordTrace, RecordingFormat::HashImage(m_emul)));
+    }
+    m_emul.SetDevices(recorder ? static_cast<InputDevice&>(*recorder) : input, output);
+
+    // The debugger drives the run itself, on the resumable engine.
+    if (!m_debugFile.empty()) {
+        const bool succeeded = RunDebugger(recorder ? static_cast<InputDevice&>(*recorder) : input, output);
+        if (recorder) {
+            recorder->Finish(succeeded);
+        }
+        if (!m_replayFile.empty()) {
+            ReportReplay(replayer, succeeded);
+        }
+        cout << "End of emulation" << endl;
+        return;
+    }
+
+    // Run the program in the emulator, under the watchdog if a limit was given
+    m_emul.SetEngine(m_engine);
+    m_emul.SetProfiling(!m_profileFile.empty());
+    m_emul.SetCoverage(!m_coverageFile.empty());
+    ofstream trace;
+    TextTrace textTrace(trace);
+    if (!m_traceFile.empty() + (recorder && m_recordTrace) + replayer.HasTrace() > 1) {
+        cerr << "Error: Only one of -trace, -record-trace and the replay of a traced recording can be used at a time" << endl;
+        return;
+    }
+    if (!m_traceFile.empty()) {
+        trace.open(m_traceFile);
+        if (!trace) {
+            cerr << "Error: Could not write trace file " << m_traceFile << endl;
+            return;
+        }
+        m_emul.SetTrace(&textTrace);
+    }
+    if (recorder && m_recordTrace) {
+        m_emul.SetTrace(recorder.get());
+    }
+    if (replayer.HasTrace()) {
+        m_emul.SetTrace(&replayer);
+    }
+    for (int location : m_breakpoints) {
+        m_emul.SetBreakpoint(location);
+    }
+    if (!m_breakpoints.empty()) {
+        m_emul.SetBreakpointHandler([](int a_location) {
+            cout << "Breakpoint at " << a_location << endl;
+            return true;
+        });
+    }
+    bool succeeded;
+    if (m_instructionLimit > 0 || m_timeLimit > 0) {
+        Scheduler scheduler;
+        scheduler.SetWatchdog(m_instructionLimit, m_timeLimit);
+        scheduler.Add(m_emul);
+        scheduler.RunUntilIdle();
+        succeeded = scheduler.GetTask(0).state == Scheduler::TASK_HALTED;
+        if (scheduler.GetTask(0).state == Scheduler::TASK_KILLED) {
+            std::cerr << "Error: Program stopped by the watchdog after " << m_emul.GetRetired() << " instructions\n";
+        }
+        else if (!succeeded) {
+            std::cerr << "Error: Could not run program in emulator\n";
+        }
+    }
+    else if (!(succeeded = m_emul.runProgram())) {
+        std::cerr << "Error: Could not run program in emulator\n";
+    }
+    if (recorder) {
+        recorder->Finish(succeeded);
+    }
+    if (!m_replayFile.empty()) {
+        ReportReplay(replayer, succeeded);
+    }
+    if (!m_profileFile.empty()) {
+        WriteProfile(m_emul);
+    }
+    if (!m_coverageFile.empty()) {
+        WriteCoverage(m_emul);
+    }
+#ifdef VC_STATS
+    WriteStats(m_emul.GetStats());
+#endif
+    cout << "End of emulation" << endl;
+}
+
+/**/
+/*
+Assembler::RunDebugger(InputDevice& a_input, OutputDevice& a_output)
+
+NAME
+
+    Assembler::RunDebugger - Runs the program under the time-travel debugger.
+
+SYNOPSIS
+
+    bool Assembler::RunDebugger(InputDevice& a_input, OutputDevice& a_output);
+        a_input     --> The device READ takes its values from.
+        a_output    --> The device WRITE passes its values to.
+
+DESCRIPTION
+
+    This method reads debugger commands, one per line, from m_debugFile or from the console
+    if it is "-", and prints where the program is after each one:
+
+        forward [n]     run forward n instructions, 1 if n is not given.
+        continue        run forward to the end of the program.
+        back [n]        go back n instructions, 1 if n is not given.
+        jump <n>        go to the point where n instructions have been executed.
+        print <loc>     print the word at location <loc>.
+        quit            stop debugging.
+
+    Each command may be shortened to its first letter. Output the program already wrote
+    is not written again when a stretch of it is run a second time.
+
+RETURNS
+
+    Returns true if the program has halted when debugging stops.
+*/
+/**/
+bool Assembler::RunDebugger(InputDevice& a_input, OutputDevice& a_output)
+{
+    ifstream file;
+    if (m_debugFile != "-") {
+        file.open(m_debugFile);
+        if (!file) {
+            cerr << "Error: Could not read debugger commands from " << m_debugFile << endl;
+            return false;
+        }
+    }
+    istream& commands = m_debugFile == "-" ? cin : file;
+
+    TimeTravel debugger(m_emul, a_input, a_output);
+    auto report = [&debugger]() {
+        cout << "[" << debugger.GetPosition() << "] location " << debugger.GetLocation();
+        switch (debugger.GetStatus()) {
+        case emulator::STATUS_HALTED: cout << " halted"; break;
+        case emulator::STATUS_FAULTED: cout << " faulted"; break;
+        case emulator::STATUS_WAITING: cout << " waiting for input"; break;
+        default: break;
+        }
+        cout << endl;
+    };
+    report();
+
+    string line;
+    while (getline(commands, line)) {
+        istringstream words(line);
+        string command;
+        long long count = 1;
+        if (!(words >> command)) {
+            continue;
+        }
+        const bool counted = static_cast<bool>(words >> count);
+        if (command == "q" || command == "quit") {
+            break;
+        }
+        else if (command == "f" || command == "forward") {
+            debugger.Forward(count);
+        }
+        else if (command == "c" || command == "continue") {
+            debugger.Forward(LLONG_MAX);
+        }
+        else if (command == "b" || command == "back") {
+            if (!debugger.Back(count)) {
+                cout << "At the start of the program" << endl;
+            }
+        }
+        else if ((command == "j" || command == "jump") && counted) {
+            debugger.JumpTo(count);
+        }
+        else if ((command == "p" || command == "print") && counted && count >= 0 && count < emulator::MEMSZ) {
+            cout << count << ": " << m_emul.GetMemory()[static_cast<int>(count)] << endl;
+            continue;
+        }
+        else {
+            cout << "Unknown debugger command: " << line << endl;
+            continue;
+        }
+        report();
+    }
+    return debugger.GetStatus() == emulator::STATUS_HALTED;
+}
+
+/**/
+/*
+Assembler::ReportReplay(const Replayer& a_replayer, bool a_succeeded)
+
+NAME
+
+    Assembler::ReportReplay - Says whether a replay reproduced the recorded run.
+
+SYNOPSIS
+
+    void Assembler::ReportReplay(const Replayer& a_replayer, bool a_succeeded);
+        a_replayer     --> The replayer after the run.
+        a_succeeded    --> True if the replayed run succeeded.
+
+DESCRIPTION
+
+    This method prints the first point at which the replay left the recorded trace, if the
+    recording has one, or a difference in the result of the run. Otherwise it prints that
+    the replay matched the recording.
+
+*/
+/**/
+void Assembler::ReportReplay(const Replayer& a_replayer, bool a_succeeded)
+{
+    bool recordedResult;
+    if (a_replayer.HasTrace() && !a_replayer.IsFaithful()) {
+        const string& divergence = a_replayer.GetDivergence();
+        cout << "Replay diverged: " << (divergence.empty() ? "the run ended before the recorded trace did" : divergence) << endl;
+    }
+    else if (a_replayer.GetRecordedResult(recordedResult) && recordedResult != a_succeeded) {
+        cout << "Replay diverged: the run " << (a_succeeded ? "succeeded" : "failed") << " but the recorded run "
+            << (recordedResult ? "succeeded" : "failed") << endl;
+    }
+    else if (a_replayer.HasTrace()) {
+        cout << "Replay matched the recording and its trace of " << a_replayer.GetSteps() << " instructions" << endl;
+    }
+    else {
+        cout << "Replay matched the recording" << endl;
+    }
+}
+
+/**/
+/*
+Assembler::WriteProfile(const emulator& a_emu)
+
+NAME
+
+    Assembler::WriteProfile - Reports where a profiled run spent its time.
+
+SYNOPSIS
+
+    void Assembler::WriteProfile(const emulator& a_emu);
+        a_emu    --> The emulator after a profiled run.
+
+DESCRIPTION
+
+    This method charges the emulator's per-cell execution counts to the labels in the
+    symbol table. The location of the statement in each cell is the one PassII packed into
+    the front of its machine word. The per-label report is printed and the folded stacks
+    are written to m_profileFile.
+
+*/
+/**/
+void Assembler::WriteProfile(const emulator& a_emu)
+{
+    vector<int> locations;
+    for (const string& word : m_machineCode) {
+        locations.push_back(static_cast<int>(stoll(word) / 1000000000000));
+    }
+
+    Profiler profiler(m_symtab.GetSymbols(), locations);
+    profiler.Attribute(a_emu.GetProfile());
+    profiler.WriteReport(cout);
+
+    ofstream file(m_profileFile);
+    if (!file) {
+        cerr << "Error: Could not write profile file " << m_profileFile << endl;
+        return;
+    }
+    profiler.WriteFolded(file);
+}
+
+/**/
+/*
+Assembler::WriteControlFlow(const emulator& a_loaded)
+
+NAME
+
+    Assembler::WriteControlFlow - Reports the control flow of the loaded program.
+
+SYNOPSIS
+
+    void Assembler::WriteControlFlow(const emulator& a_loaded);
+        a_loaded    --> The emulator with the program loaded.
+
+DESCRIPTION
+
+    This method builds the control-flow graph of the loaded image, prints its summary, loop
+    headers and unreachable code, and writes the graph to m_cfgFile.
+
+*/
+/**/
+void Assembler::WriteControlFlow(const emulator& a_loaded)
+{
+    ControlFlowGraph graph(a_loaded);
+    graph.WriteReport(cout);
+
+    ofstream file(m_cfgFile);
+    if (!file) {
+        cerr << "Error: Could not write control-flow graph " << m_cfgFile << endl;
+        return;
+    }
+    graph.WriteDot(file);
+}
+
+/**/
+/*
+Assembler::WriteCoverage(const emulator& a_emu)
+
+NAME
+
+    Assembler::WriteCoverage - Reports which source lines a covered run executed.
+
+SYNOPSIS
+
+    void Assembler::WriteCoverage(const emulator& a_emu);
+        a_emu    --> The emulator after a covered run.
+
+DESCRIPTION
+
+    This method joins the emulator's per-cell execution marks with the source line PassII
+    recorded for each cell. A cell holds an instruction if the opcode in its machine word
+    is not zero. The text PassI recorded is printed with each instruction line marked, and
+    the LCOV tracefile is written to m_coverageFile.
+
+*/
+/**/
+void Assembler::WriteCoverage(const emulator& a_emu)
+{
+    vector<bool> instructions;
+    for (const string& word : m_machineCode) {
+        instructions.push_back(stoll(word) / 10000000000 % 100 != 0);
+    }
+    Coverage coverage(m_sourceLines, instructions);
+    coverage.Attribute(a_emu.GetCoverage());
+
+    vector<string> source;
+    for (const ParsedLine& parsed : m_source.GetLines()) {
+        source.emplace_back(m_source.GetText(parsed));
+    }
+    cout << "Coverage of " << m_facc.GetFileName() << ":" << endl;
+    coverage.WriteListing(source, cout);
+
+    ofstream file(m_coverageFile);
+    if (!file) {
+        cerr << "Error: Could not write coverage file " << m_coverageFile << endl;
+        return;
+    }
+    coverage.WriteLcov(m_facc.GetFileName(), file);
+}
+
+#ifdef VC_STATS
+/**/
+/*
+Assembler::WriteStats(const ExecutionStats& a_stats)
+
+NAME
+
+    Assembler::WriteStats - Exports the execution statistics of a run.
+
+SYNOPSIS
+
+    void Assembler::WriteStats(const ExecutionStats& a_stats);
+        a_stats    --> The statistics the emulator collected.
+
+DESCRIPTION
+
+    This method writes a_stats as JSON to m_statsFile, or to the console if it is "-".
+    Nothing is written if no -stats option was given.
+
+*/
+/**/
+void Assembler::WriteStats(const ExecutionStats& a_stats)
+{
+    if (m_statsFile.empty()) {
+        return;
+    }
+    if (m_statsFile == "-") {
+        a_stats.WriteJson(cout);
+        return;
+    }
+    ofstream file(m_statsFile);
+    if (!file) {
+        cerr << "Error: Could not write statistics file " << m_statsFile << endl;
+        return;
+    }
+    a_stats.WriteJson(file);
+}
+#endif
+
+/**/
+/*
+Assembler::VerifyEngines(const emulator& a_loaded)
+
+NAME
+
+    Assembler::VerifyEngines - Checks that the emulator's engines agree on a program.
+
+SYNOPSIS
+
+    void Assembler::VerifyEngines(const emulator& a_loaded);
+        a_loaded    --> an emulator with the program already loaded into memory.
+
+DESCRIPTION
+
+    This method reads all of standard input up front and runs a copy of the loaded emulator
+    on each engine, feeding every copy the same input. It prints the output of the switch
+    engine and whether the verifier let it run unchecked, then compares the result, the
+    output and the final memory of each other engine against it, reporting the first
+    difference found. The switch engine with the verifier turned off is compared as the
+    "checked" engine. Every fused handler is also checked against the instructions it
+    replaces. For a verified program the counted loops found and the iterations they
+    skipped are reported.
+
+*/
+/**/
+
+void Assembler::VerifyEngines(const emulator& a_loaded)
+{
+    // Every engine must see the same input, so it cannot be read interactively.
+    stringstream text;
+    text << cin.rdbuf();
+    TapeInput tape;
+    if (!tape.LoadText(text.str())) {
+        cerr << "Error: Standard input does not hold a list of numbers" << endl;
+        return;
+    }
+
+    const emulator::Engine engines[] = { emulator::ENGINE_SWITCH, emulator::ENGINE_SWITCH, emulator::ENGINE_THREADED, emulator::ENGINE_JIT };
+    const char* names[] = { "switch", "checked", "threaded", "jit" };
+
+    emulator reference = a_loaded;
+    TapeInput referenceIn = tape;
+    ostringstream referenceOut;
+    BufferedOutput referenceSink(referenceOut);
+    reference.SetDevices(referenceIn, referenceSink);
+    reference.SetEngine(engines[0]);
+    bool referenceResult = reference.runProgram();
+    cout << referenceOut.str();
+    if (reference.IsVerified()) {
+        cout << "Verifier: program verified, " << names[0] << " ran unchecked with " << reference.GetFusedCount() << " fused sequences" << endl;
+        cout << "Counted loops: " << reference.GetCountedLoopCount() << " found, " << reference.GetSkippedIterations()
+            << " iterations computed in closed form" << endl;
+    }
+    else {
+        cout << "Verifier: " << reference.GetVerifierReport() << ", " << names[0] << " ran checked" << endl;
+    }
+
+    int patterns;
+    Fusion::GetPatterns(patterns);
+    const int fusionPassed = Fusion::CheckHandlers(cout);
+    cout << "Fusion: " << fusionPassed << " of " << patterns << " fused handlers match their unfused sequences" << endl;
+
+    for (size_t e = 1; e < std::size(engines); e++) {
+        emulator emu = a_loaded;
+        TapeInput in = tape;
+        ostringstream out;
+        BufferedOutput sink(out);
+        emu.SetDevices(in, sink);
+        emu.SetEngine(engines[e]);
+        emu.SetVerifying(e != 1);
+        bool result = emu.runProgram();
+
+        if (result != referenceResult) {
+            cout << "Engine mismatch: " << names[e] << " returned " << result << ", " << names[0] << " returned " << referenceResult << endl;
+        }
+        else if (out.str() != referenceOut.str()) {
+            cout << "Engine mismatch: " << names[e] << " output differs from " << names[0] << endl;
+        }
+        else if (emu.GetMemory() != reference.GetMemory()) {
+            const EmulatorMemory& mem = emu.GetMemory();
+            const EmulatorMemory& ref = reference.GetMemory();
+            int loc = 0;
+            while (mem[loc] == ref[loc]) {
+                loc++;
+            }
+            cout << "Engine mismatch: " << names[e] << " memory differs from " << names[0] << " at " << loc << endl;
+        }
+        else {
+            cout << "Engines agree: " << names[e] << " matches " << names[0] << endl;
+        }
+    }
+}
+
+/**/
+/*
+Assembler::CompareDecoding(const emulator& a_loaded)
+
+NAME
+
+    Assembler::CompareDecoding - Measures what pre-decoding the program saves.
+
+SYNOPSIS
+
+    void Assembler::CompareDecoding(const emulator& a_loaded);
+        a_loaded    --> an emulator with the program already loaded into memory.
+
+DESCRIPTION
+
+    This method counts the instructions the loaded program executes, then runs a copy of
+    the loaded emulator with the switch engine twice: once decoding every instruction as it
+    is fetched, as the emulator did before it pre-decoded programs, and once with the
+    program decoded ahead of the run. Both runs are checked and unfused, so decoding is the
+    only difference between them. The time and the instructions per second of each are
+    printed. All of standard input is read up front and every run is fed the same values.
+    Bench.txt is the counter loop written for this comparison; its first lines give the
+    command that runs it.
+
+*/
+/**/
+
+void Assembler::CompareDecoding(const emulator& a_loaded)
+{
+    // Every run must see the same input, so it cannot be read interactively.
+    stringstream text;
+    text << cin.rdbuf();
+    TapeInput tape;
+    if (!tape.LoadText(text.str())) {
+        cerr << "Error: Standard input does not hold a list of numbers" << endl;
+        return;
+    }
+
+    // Run steps one instruction at a time, so it can count them.
+    emulator counter = a_loaded;
+    TapeInput counterIn = tape;
+    ostringstream counterOut;
+    BufferedOutput counterSink(counterOut);
+    counter.SetDevices(counterIn, counterSink);
+    counter.Run(LLONG_MAX);
+    const long long instructions = counter.GetRetired();
+
+    // Returns the time to run the program, decoding it ahead of the run if a_preDecoding is true.
+    auto timeRun = [&](bool a_preDecoding) {
+        emulator emu = a_loaded;
+        TapeInput in = tape;
+        ostringstream out;
+        BufferedOutput sink(out);
+        emu.SetDevices(in, sink);
+        emu.SetEngine(emulator::ENGINE_SWITCH);
+        emu.SetVerifying(false);
+        emu.SetPreDecoding(a_preDecoding);
+        auto start = chrono::steady_clock::now();
+        emu.runProgram();
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+    const double perStep = timeRun(false);
+    const double preDecoded = timeRun(true);
+
+    auto report = [&](const char* a_name, double a_seconds) {
+        cout << "    " << setfill(' ') << left << setw(18) << a_name << right << fixed << setprecision(3) << setw(8) << a_seconds << " s"
+            << setprecision(1) << setw(10) << instructions / a_seconds / 1e6 << " MIPS" << defaultfloat << endl;
+    };
+    cout << "Decoding comparison over " << instructions << " instructions:" << endl;
+    report("decode each step", perStep);
+    report("pre-decoded", preDecoded);
+}
+
+/**/
+/*
+Assembler::RunBatch(const emulator& a_loaded)
+
+NAME
+
+    Assembler::RunBatch - Runs the program for many input sets in lockstep.
+
+SYNOPSIS
+
+    void Assembler::RunBatch(const emulator& a_loaded);
+        a_loaded    --> an emulator with the program already loaded into memory.
+
+DESCRIPTION
+
+    This method reads m_batchFile, where each line holds the values that READ should return
+    for one run, and executes the runs with a BatchEmulator, BATCH_LANES at a time so the
+    interleaved memory stays a manageable size. The one BatchEmulator is reset between
+    batches, which rewrites only the memory the last batch wrote. The runs are then
+    repeated one at a time on the switch engine, with one emulator restored from a snapshot
+    between runs. Both are timed the same way: from resetting memory to having each run's
+    output as text, without printing it. The values written by each run are then printed
+    under a heading with the run's number, followed by a note if the run failed or if the
+    switch engine wrote something else, and finally the time of both and the speed-up of
+    running in lockstep. Watchdog limits are not supported in lockstep, so -limit and
+    -timeout are rejected.
+
+*/
+/**/
+
+void Assembler::RunBatch(const emulator& a_loaded)
+{
+    // Lanes per batch. Each lane costs MEMSZ words of memory.
+    const int BATCH_LANES = 16;
+
+    if (m_instructionLimit > 0 || m_timeLimit > 0) {
+        cerr << "Error: -limit and -timeout cannot be used with -batch" << endl;
+        return;
+    }
+    vector<vector<long long>> inputs;
+    if (!ReadInputSets(m_batchFile, inputs)) {
+        cerr << "Error: Could not open batch file " << m_batchFile << endl;
+        return;
+    }
+
+    // The values each run writes, one per line, and whether it halted.
+    vector<string> outputs(inputs.size());
+    vector<bool> succeeded(inputs.size());
+
+    auto start = chrono::steady_clock::now();
+    BatchEmulator batchEmu(a_loaded, static_cast<int>(max(min(inputs.size(), static_cast<size_t>(BATCH_LANES)), static_cast<size_t>(1))));
+    for (size_t first = 0; first < inputs.size(); first += BATCH_LANES) {
+        int lanes = static_cast<int>(min(inputs.size() - first, static_cast<size_t>(BATCH_LANES)));
+        batchEmu.Reset(lanes);
+        for (int lane = 0; lane < lanes; lane++) {
+            batchEmu.SetInput(lane, inputs[first + lane]);
+        }
+        batchEmu.Run();
+
+        for (int lane = 0; lane < lanes; lane++) {
+            ostringstream text;
+            for (long long value : batchEmu.GetOutput(lane)) {
+                text << value << '\n';
+            }
+            outputs[first + lane] = text.str();
+            succeeded[first + lane] = batchEmu.GetResult(lane);
+        }
+    }
+    double lockstep = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // The same runs on the scalar engine, for comparison.
+    vector<string> scalarOutputs(inputs.size());
+    start = chrono::steady_clock::now();
+    emulator emu = a_loaded;
+    emu.SetEngine(emulator::ENGINE_SWITCH);
+    emu.TakeSnapshot();
+    for (size_t run = 0; run < inputs.size(); run++) {
+        emu.Restore();
+        TapeInput in(inputs[run]);
+        ostringstream out;
+        BufferedOutput sink(out);
+        emu.SetDevices(in, sink);
+        emu.runProgram();
+        scalarOutputs[run] = out.str();
+    }
+    double scalar = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    for (size_t run = 0; run < inputs.size(); run++) {
+        cout << "Run " << run + 1 << ":" << endl << outputs[run];
+        if (!succeeded[run]) {
+            cout << "Run " << run + 1 << " failed" << endl;
+        }
+        if (scalarOutputs[run] != outputs[run]) {
+            cout << "Run " << run + 1 << " wrote other values on the switch engine" << endl;
+        }
+    }
+    cout << "Ran " << inputs.size() << " runs in lockstep in " << fixed << setprecision(3) << lockstep << " s; one at a time on the switch engine they take "
+        << scalar << " s";
+    if (lockstep > 0) {
+        cout << " (" << setprecision(2) << scalar / lockstep << "x speed-up)";
+    }
+    cout << defaultfloat << endl;
+}
+
+/**/
+/*
+Assembler::RunJobs(const emulator& a_loaded)
+
+NAME
+
+    Assembler::RunJobs - Runs the program for many input sets on all cores.
+
+SYNOPSIS
+
+    void Assembler::RunJobs(const emulator& a_loaded);
+        a_loaded    --> an emulator with the program already loaded into memory.
+
+DESCRIPTION
+
+    This method reads m_jobsFile, where each line holds the values that READ should return
+    for one run, and submits one job per line to a JobRunner using the loaded program as
+    the memory image. When all jobs have finished it prints each job's output and run time
+    in submission order, followed by the aggregate throughput and the speed-up over running
+    the jobs one after another. Jobs under the watchdog run on the switch engine, so a limit
+    cannot be combined with -engine threaded or jit.
+
+*/
+/**/
+
+void Assembler::RunJobs(const emulator& a_loaded)
+{
+    if ((m_instructionLimit > 0 || m_timeLimit > 0) && m_engine != emulator::ENGINE_SWITCH) {
+        cerr << "Error: -limit and -timeout run each job on the switch engine, so they cannot be used with -engine threaded or jit" << endl;
+        return;
+    }
+
+    vector<vector<long long>> inputs;
+    if (!ReadInputSets(m_jobsFile, inputs)) {
+        cerr << "Error: Could not open jobs file " << m_jobsFile << endl;
+        return;
+    }
+
+    const EmulatorMemory& memory = a_loaded.GetMemory();
+    vector<long long> image;
+    for (int location = 0; location < a_loaded.GetLoadedLimit(); location++) {
+        image.push_back(memory[location]);
+    }
+
+    JobRunner runner;
+    runner.SetEngine(m_engine);
+    runner.SetWatchdog(m_instructionLimit, m_timeLimit);
+    for (const vector<long long>& input : inputs) {
+        runner.Submit(image, input);
+    }
+    runner.Run();
+
+    double busy = 0;
+    const vector<JobRunner::Result>& results = runner.GetResults();
+    for (size_t job = 0; job < results.size(); job++) {
+        cout << "Job " << job + 1 << " (" << fixed << setprecision(3) << results[job].seconds * 1000 << " ms):" << endl;
+        cout << results[job].output;
+        if (results[job].killed) {
+            cout << "Job " << job + 1 << " stopped by the watchdog" << endl;
+        }
+        else if (!results[job].success) {
+            cout << "Job " << job + 1 << " failed" << endl;
+        }
+        busy += results[job].seconds;
+    }
+
+    double elapsed = runner.GetElapsed();
+    cout << "Ran " << results.size() << " jobs on " << runner.GetThreadCount() << " threads in " << elapsed << " s";
+    if (elapsed > 0) {
+        cout << " (" << results.size() / elapsed << " jobs/s, " << busy / elapsed << "x speed-up)";
+    }
+    cout << defaultfloat << endl;
+}
+
+/**/
+/*
+Assembler::RunSessions(const emulator& a_loaded)
+
+NAME
+
+    Assembler::RunSessions - Runs the program as many interactive sessions on one thread.
+
+SYNOPSIS
+
+    void Assembler::RunSessions(const emulator& a_loaded);
+        a_loaded    --> an emulator with the program already loaded into memory.
+
+DESCRIPTION
+
+    This method reads m_sessionsFile, where each line holds the values one session will be
+    given, and starts a Session per line on a single EventLoop. It then plays the part of
+    the users: in each round it feeds every session its next value and lets the loop run
+    until every machine is waiting again. Sessions that have used all their values have
+    their input closed. Finally it prints each session's output and how long serving all
+    of them took.
+
+*/
+/**/
+
+void Assembler::RunSessions(const emulator& a_loaded)
+{
+    vector<vector<long long>> inputs;
+    if (!ReadInputSets(m_sessionsFile, inputs)) {
+        cerr << "Error: Could not open sessions file " << m_sessionsFile << endl;
+        return;
+    }
+
+    auto start = chrono::steady_clock::now();
+    EventLoop loop;
+    vector<unique_ptr<Session>> sessions;
+    vector<vector<long long>> outputs(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        sessions.push_back(make_unique<Session>(loop, a_loaded));
+        sessions[i]->Start();
+    }
+    loop.RunUntilIdle();
+
+    for (size_t round = 0; ; round++) {
+        bool fed = false;
+        for (size_t i = 0; i < sessions.size(); i++) {
+            if (round < inputs[i].size()) {
+                sessions[i]->Feed(inputs[i][round]);
+                fed = true;
+            }
+            else if (round == inputs[i].size()) {
+                sessions[i]->CloseInput();
+            }
+        }
+
+        // Let the machines run, collecting their output, until all of them are waiting again.
+        bool wrote = true;
+        while (wrote) {
+            loop.RunUntilIdle();
+            wrote = false;
+            for (size_t i = 0; i < sessions.size(); i++) {
+                vector<long long> written = sessions[i]->TakeOutput();
+                wrote = wrote || !written.empty();
+                outputs[i].insert(outputs[i].end(), written.begin(), written.end());
+            }
+        }
+        if (!fed) {
+            break;
+        }
+    }
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    for (size_t i = 0; i < sessions.size(); i++) {
+        cout << "Session " << i + 1 << ":" << endl;
+        for (long long value : outputs[i]) {
+            cout << value << endl;
+        }
+        if (!sessions[i]->IsFinished()) {
+            cout << "Session " << i + 1 << " did not finish" << endl;
+        }
+        else if (sessions[i]->GetStatus() != emulator::STATUS_HALTED) {
+            cout << "Session " << i + 1 << " failed" << endl;
+        }
+    }
+    cout << "Served " << sessions.size() << " sessions on one thread in " << fixed << setprecision(3) << elapsed << " s" << defaultfloat << endl;
+}
+
+/**/
+/*
+Assembler::ReadInputSets(const string& a_file, std::vector<std::vector<long long>>& a_inputs)
+
+NAME
+
+    Assembler::ReadInputSets - Reads the input values for a set of runs.
+
+SYNOPSIS
+
+    bool Assembler::ReadInputSets(const string& a_file, std::vector<std::vector<long long>>& a_inputs);
+        a_file      --> the file to read.
+        a_inputs    --> receives one vector of values per line of the file.
+
+DESCRIPTION
+
+    This method reads a_file line by line. Each line describes one run and holds the values,
+    separated by white space, that the run's READ instructions return in order.
+
+RETURNS
+
+    Returns true if the file could be read, otherwise false.
+*/
+/**/
+
+bool Assembler::ReadInputSets(const string& a_file, std::vector<std::vector<long long>>& a_inputs)
+{
+    ifstream file(a_file);
+    if (!file) {
+        return false;
+    }
+
+    string line;
+    while (getline(file, line)) {
+        istringstream values(line);
+        vector<long long> input;
+        long long value;
+        while (values >> value) {
+            input.push_back(value);
+        }
+        a_inputs.push_back(input);
+    }
+    return true;
+}
+
+/**/
+/*
+Assembler::PassII()
+
+NAME
+
+    Assembler::PassII - Executes the second pass of the assembler.
+
+SYNOPSIS
+
+    void Assembler::PassII();
+
+DESCRIPTION
+
+    This method executes the second pass of the assembler. It works from the parsed lines
+    PassI recorded rather than the source file: now that the symbol table is complete, it
+    looks up the value of every operand that names a symbol, then writes the translation.
+
+*/
+/**/
+
+void Assembler::PassII()
+{
+    ResolveOperands();
+    WriteTranslation();
+}
+
+/**/
+/*
+Assembler::Assemble()
+
+NAME
+
+    Assembler::Assemble - Assembles the program in a single pass.
+
+SYNOPSIS
+
+    void Assembler::Assemble();
+
+DESCRIPTION
+
+    This method does the work of PassI, DisplaySymbolTable and PassII in a single pass.
+    As each line is read and recorded, its label is entered in the symbol table as PassI
+    would, and each operand naming a symbol that is already defined is given its value at
+    once. A reference to a symbol that is not yet defined is recorded as a fixup. When the
+    whole source has been read the symbol table is complete, and the fixups are patched
+    from it. A symbol defined twice ends up with the value of multiplyDefinedSymbol, so if
+    there is one, the operands that were given its first value are looked up again. The
+    symbol table and the translation are then written exactly as the two passes write them.
+
+*/
+/**/
+
+void Assembler::Assemble()
+{
+    int loc = 0;            // Location counter of pass I.
+    bool ended = false;     // END has been read.
+    std::vector<std::pair<size_t, int>> fixups;     // Line and operand of each forward reference.
+    if (m_compareLexers) {
+        CompareLexers();
+    }
+    m_source.ShareText(m_facc.GetMappedText());
+
+    while (ReadSourceLine(loc, ended)) {
+        ParsedLine& parsed = m_source.GetLines().back();
+        for (int i = 0; i < 2; i++) {
+            if (parsed.operandKind[i] == ParsedLine::OK_Symbol
+                && !m_symtab.LookupSymbol(m_source.GetSymbolName(parsed.symbol[i]), parsed.address[i])) {
+                fixups.push_back({ m_source.GetLines().size() - 1, i });
+            }
+        }
+    }
+    if (!ended) {
+        Errors::RecordError("Error: Missing END statement.");
+    }
+
+    // The symbol table is complete: patch the forward references.
+    for (const auto& fixup : fixups) {
+        ParsedLine& parsed = m_source.GetLines()[fixup.first];
+        if (!m_symtab.LookupSymbol(m_source.GetSymbolName(parsed.symbol[fixup.second]), parsed.address[fixup.second])) {
+            parsed.operandKind[fixup.second] = ParsedLine::OK_Undefined;
+        }
+    }
+    for (const auto& symbol : m_symtab.GetSymbols()) {
+        if (symbol.second == m_symtab.multiplyDefinedSymbol) {
+            ResolveOperands();
+            break;
+        }
+    }
+
+    DisplaySymbolTable();
+    WriteTranslation();
+}
+
+/**/
+/*
+Assembler::ReadSourceLine(int& a_loc, bool& a_ended)
+
+NAME
+
+    Assembler::ReadSourceLine - Reads, parses and records the next line of the source.
+
+SYNOPSIS
+
+    bool Assembler::ReadSourceLine(int& a_loc, bool& a_ended);
+        a_loc      --> the location counter of pass I.
+        a_ended    --> set once the end statement has been read.
+
+DESCRIPTION
+
+    This method reads the next line, parses it and records it in the parsed source at the
+    current location. Up to the end statement it also does the work of pass I on it: an
+    "org" directive sets the location counter, a label is entered in the symbol table, and
+    the location counter moves on to the next instruction. Lines after the end statement are recorded but locate nothing.
+
+RETURNS
+
+    Returns false if there are no more lines, otherwise true.
+
+*/
+/**/
+
+bool Assembler::ReadSourceLine(int& a_loc, bool& a_ended)
+{
+    std::string_view line;
+    if (!m_facc.GetNextLine(line)) {
+        return false;
+    }
+
+    Instruction::InstructionType type = m_inst.ParseInstruction(line);
+    m_source.Add(line, type, m_inst, a_loc);
+
+    if (type == Instruction::ST_End) {
+        a_ended = true;
+    }
+    if (a_ended || type == Instruction::ST_Comment) {
+        return true;
+    }
+
+    // Check for "org" directive
+    if (m_inst.GetOpcode() == "org") {
+        a_loc = stoi(string(m_inst.GetOperand1())); // Update the location counter to the value specified by "org"
+    }
+    else {
+        // If the instruction has a label, record it and its location in the symbol table.
+        if (!m_inst.GetLabel().empty()) {
+            m_symtab.AddSymbol(string(m_inst.GetLabel()), a_loc);
+        }
+
+        // Compute the location of the next instruction.
+        a_loc = m_inst.LocationNextInstruction(a_loc);
+    }
+    return true;
+}
+
+/**/
+/*
+Assembler::CompareLexers()
+
+NAME
+
+    Assembler::CompareLexers - Compares the line parser with the lexer.
+
+SYNOPSIS
+
+    void Assembler::CompareLexers();
+
+DESCRIPTION
+
+    This method times three ways of parsing the source: splitting it into lines and scanning
+    each with ParseInstruction, as the assembler did before the lexer, and lexing it with the
+    Lexer, first with scalar code and then, if the processor has it, with AVX2, before
+    parsing each line from its tokens. Each is run over the source as many times as it takes
+    to parse about 64 MB, so small programs give stable figures. It prints the time and
+    throughput of each, then parses the source once more with all of them side by side and
+    reports the first line on which their fields differ, if any. The source must be mapped.
+
+*/
+/**/
+
+void Assembler::CompareLexers()
+{
+    std::string_view text = m_facc.GetMappedText();
+    if (text.empty()) {
+        cout << "Lexer comparison needs a source file that can be mapped" << endl;
+        return;
+    }
+    const size_t rounds = max<size_t>(1, (size_t(64) << 20) / text.size());
+
+    // Hands out the lines of the source as FileAccess did before the lexer.
+    auto nextLine = [&text](size_t& a_position, std::string_view& a_line) {
+        if (a_position > text.size()) {
+            return false;
+        }
+        size_t newline = text.find('\n', a_position);
+        a_line = text.substr(a_position, newline == std::string_view::npos ? std::string_view::npos : newline - a_position);
+        a_position = newline == std::string_view::npos ? text.size() + 1 : newline + 1;
+#ifdef _WIN32
+        if (newline != std::string_view::npos && !a_line.empty() && a_line.back() == '\r') {
+            a_line.remove_suffix(1);
+        }
+#endif
+        return true;
+    };
+
+    Instruction inst;
+    std::string_view line;
+    size_t lines = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; round++) {
+        lines = 0;
+        for (size_t position = 0; nextLine(position, line); lines++) {
+            inst.ParseInstruction(line);
+        }
+    }
+    double lineParser = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // Returns the time to lex and parse the source rounds times, or a negative time if the lexer asked for is not available.
+    auto timeLexer = [&](bool a_vector) {
+        Lexer lexer(text, a_vector);
+        if (lexer.IsVector() != a_vector) {
+            return -1.0;
+        }
+        auto start = chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; round++) {
+            lexer.Reset();
+            while (const LexedLine* tokens = lexer.Next(line)) {
+                inst.ParseInstruction(line, *tokens);
+            }
+        }
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+    double scalarLexer = timeLexer(false);
+    double vectorLexer = timeLexer(true);
+
+    const double megabytes = static_cast<double>(text.size()) * rounds / (1 << 20);
+    auto report = [&](const char* a_name, double a_seconds) {
+        cout << "    " << left << setw(18) << a_name << right;
+        if (a_seconds < 0) {
+            cout << "not available on this processor" << endl;
+            return;
+        }
+        cout << fixed << setprecision(3) << setw(8) << a_seconds << " s" << setprecision(1) << setw(10) << megabytes / a_seconds
+            << " MB/s" << setw(8) << a_seconds * 1e9 / (static_cast<double>(lines) * rounds) << " ns/line" << defaultfloat << endl;
+    };
+    cout << "Lexer comparison over " << lines << " lines, " << rounds << (rounds == 1 ? " time:" : " times:") << endl;
+    report("line parser", lineParser);
+    report("lexer, scalar", scalarLexer);
+    report("lexer, AVX2", vectorLexer);
+
+    // Every parser must give every line the same fields.
+    Lexer scalar(text, false);
+    Lexer vector(text, true);
+    Instruction scalarInst, vectorInst;
+    std::string_view scalarLine, vectorLine;
+    size_t position = 0;
+    for (size_t number = 1; nextLine(position, line); number++) {
+        const LexedLine* scalarTokens = scalar.Next(scalarLine);
+        const LexedLine* vectorTokens = vector.Next(vectorLine);
+        const Instruction::InstructionType type = inst.ParseInstruction(line);
+        if (scalarTokens == nullptr || vectorTokens == nullptr || scalarLine != line || vectorLine != line
+            || scalarInst.ParseInstruction(scalarLine, *scalarTokens) != type || vectorInst.ParseInstruction(vectorLine, *vectorTokens) != type
+            || scalarInst.GetLabel() != inst.GetLabel() || vectorInst.GetLabel() != inst.GetLabel()
+            || scalarInst.GetOpcode() != inst.GetOpcode() || vectorInst.GetOpcode() != inst.GetOpcode()
+            || scalarInst.GetOperand1() != inst.GetOperand1() || vectorInst.GetOperand1() != inst.GetOperand1()
+            || scalarInst.GetOperand2() != inst.GetOperand2() || vectorInst.GetOperand2() != inst.GetOperand2()) {
+            cout << "The parsers differ on line " << number << endl;
+            return;
+        }
+    }
+    if (scalar.Next(scalarLine) != nullptr || vector.Next(vectorLine) != nullptr) {
+        cout << "The lexer finds more lines than the line parser" << endl;
+        return;
+    }
+    cout << "The parsers agree on every line" << endl;
+}
+
+// Each symbol is looked up once, then every operand naming it is given its value.
+void Assembler::ResolveOperands()
+{
+    std::vector<int> values(m_source.GetSymbolCount());
+    std::vector<bool> defined(m_source.GetSymbolCount());
+    for (int symbol = 0; symbol < m_source.GetSymbolCount(); symbol++) {
+        defined[symbol] = m_symtab.LookupSymbol(m_source.GetSymbolName(symbol), values[symbol]);
+    }
+
+    for (ParsedLine& parsed : m_source.GetLines()) {
+        for (int i = 0; i < 2; i++) {
+            if (parsed.operandKind[i] == ParsedLine::OK_Symbol || parsed.operandKind[i] == ParsedLine::OK_Undefined) {
+                const int symbol = parsed.symbol[i];
+                parsed.operandKind[i] = defined[symbol] ? ParsedLine::OK_Symbol : ParsedLine::OK_Undefined;
+                parsed.address[i] = defined[symbol] ? values[symbol] : 0;
+            }
+        }
+    }
+}
+
+/**/
+/*
+Assembler::WriteTranslation()
+
+NAME
+
+    Assembler::WriteTranslation - Writes the translation of the parsed source.
+
+SYNOPSIS
+
+    void Assembler::WriteTranslation();
+
+DESCRIPTION
+
+    This method writes the listing from the parsed lines, whose operands must already hold
+    their values. A comment or end statement is written as it is. For any other line, the
+    location is that of its label, if it has one in the symbol table, and otherwise follows
+    on from the line before. A line with the wrong number of operands for its opcode, an
+    undefined symbol or a number too large for an int is recorded as an error and the
+    translation stops there. Otherwise the machine code
+    is written with the original statement, and saved along with the source line number
+    for the emulator. When all lines have been written, it displays any recorded error
+    messages.
+
+*/
+/**/
+
+void Assembler::WriteTranslation()
+{
+    int loc = 0; // Location counter
+
+    cout << "Translation of Program:\n\n";
+    cout << "Location    Contents    Original Statement\n";
+
+    const std::vector<ParsedLine>& lines = m_source.GetLines();
+    for (size_t i = 0; i < lines.size(); i++) {
+        const ParsedLine& parsed = lines[i];
+        const std::string_view line = m_source.GetText(parsed);
+
+        // Comments and end instructions are written as they are.
+        if (parsed.kind == ParsedLine::LK_Text) {
+            cout << "                 " << line << endl;
+            continue;
+        }
+
+        // If the instruction has a label, get the location from the symbol table
+        int labelLoc;
+        if (parsed.label >= 0 && m_symtab.LookupSymbol(m_source.GetSymbolName(parsed.label), labelLoc)) {
+            loc = labelLoc;
+        }
+
+        // A statement with the wrong number of operands, or the first operand that cannot be translated, ends the translation.
+        if (parsed.arity >= 0) {
+            Errors::RecordError("Error: Wrong number of operands, expected " + to_string(parsed.arity));
+            cout << setfill('0') << setw(4) << loc << "    " << "??????" << "    " << line << endl;
+            return;
+        }
+        for (int j = 0; j < 2; j++) {
+            if (parsed.operandKind[j] == ParsedLine::OK_Undefined || parsed.operandKind[j] == ParsedLine::OK_BadNumber) {
+                Errors::RecordError(parsed.operandKind[j] == ParsedLine::OK_BadNumber ? m_source.GetBadNumberMessage()
+                    : "Error: Undefined symbol: " + m_source.GetSymbolName(parsed.symbol[j]));
+                cout << setfill('0') << setw(4) << loc << "    " << "??????" << "    " << line << endl;
+                return;
+            }
+        }
+
+        // Output the machine code
+        int opcode = (parsed.opcode * 100000000 + parsed.address[0] * 100000 + parsed.address[1]) / 100000000;
+        int first_address = parsed.address[0];
+        int second_address = parsed.address[1];
+        if (parsed.kind == ParsedLine::LK_Constant) {
+            opcode = 0;
+            second_address = first_address;
+            first_address = 0;
+        }
+        else if (parsed.kind == ParsedLine::LK_Storage) {
+            opcode = 0;
+            second_address = 0;
+            first_address = 0;
+        }
+
+        cout << setfill(' ') << setw(4) << loc << "    ";
+        cout << setfill('0') << setw(2) << opcode;
+        cout << setfill('0') << setw(5) << first_address;
+        cout << setfill('0') << setw(5) << second_address << "    " << line << endl;
+
+        stringstream ss;
+        ss << loc;
+        ss << setfill('0') << setw(2) << opcode;
+        ss << setfill('0') << setw(5) << first_address;
+        ss << setfill('0') << setw(5) << second_address;
+        m_machineCode.push_back(ss.str());
+        m_sourceLines.push_back(static_cast<int>(i + 1));
+
+        // Update the location counter for the next instruction
+        loc += parsed.size;
+    }
+
+    // Display the recorded error messages (if any)
+    Errors::DisplayErrors();
+}
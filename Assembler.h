@@ -1,53 +1,137 @@
-//
-//      Assembler class.  This is a container for all the components
-//      that make up the assembler.
-//
-#pragma once 
-
-#include "SymTab.h"
-#include "Instruction.h"
-#include "FileAccess.h"
-#include "Emulator.h"
-
-class Assembler {
-
-public:
-
-    // Constructor for the Assembler class. The command line arguments are passed to FileAccess object.
-    Assembler(int argc, char* argv[]);
-
-    // Destructor for the Assembler class.
-    ~Assembler();
-
-    // Pass I - establish the locations of the symbols
-    void PassI();
-
-    // Assemble function
-    void Assemble();
-
-    // Pass II - generate a translation
-    void PassII();
-
-    // Display the symbols in the symbol table.
-    void DisplaySymbolTable() { m_symtab.DisplaySymbolTable(); }
-
-    // Run emulator on the translation.
-    void RunProgramInEmulator();
-
-    int GenerateMachineCode(const Instruction& inst);
-
-private:
-
-    FileAccess m_facc;      // File Access object
-    SymbolTable m_symtab;   // Symbol table object
-    Instruction m_inst;     // Instruction object
-    emulator m_emul;        // Emulator object
-
-    int m_address1; // Numeric value of the first operand.
-    int m_address2; // Numeric value of the second operand.
-
-    // Handles the special case of the "copy" instruction which gets translated into two machine instructions.
-    void HandleCopyInstruction(int a_location, const string& a_operand1, const string& a_operand2);
-    std::vector<string> m_machineCode; // Vector to store the translated machine code.
-
-};
+//
+//      Assembler class.  This is a container for all the components
+//      that make up the assembler.
+//
+#pragma once 
+
+#include "SymTab.h"
+#include "Instruction.h"
+#include "FileAccess.h"
+#include "ParsedSource.h"
+#include "Emulator.h"
+
+class Replayer;
+
+class Assembler {
+
+public:
+
+    // Constructor for the Assembler class. The command line arguments are passed to FileAccess object.
+    Assembler(int argc, char* argv[]);
+
+    // Destructor for the Assembler class.
+    ~Assembler();
+
+    // Pass I - establish the locations of the symbols and record the parsed lines
+    void PassI();
+
+    // Single-pass assembly: locates the labels, displays the symbol table and outputs the same translation
+    // as PassI, DisplaySymbolTable and PassII, reading and parsing the source only once.
+    void Assemble();
+
+    // Returns true if -passes 1 selected the single-pass assembler.
+    bool IsSinglePass() const { return m_singlePass; }
+
+    // Pass II - generate a translation from the parsed lines
+    void PassII();
+
+    // Display the symbols in the symbol table.
+    void DisplaySymbolTable() { m_symtab.DisplaySymbolTable(); }
+
+    // Run emulator on the translation.
+    void RunProgramInEmulator();
+
+    int GenerateMachineCode(const Instruction& inst);
+
+private:
+
+    FileAccess m_facc;      // File Access object
+    SymbolTable m_symtab;   // Symbol table object
+    Instruction m_inst;     // Instruction object
+    emulator m_emul;        // Emulator object
+
+    bool m_singlePass = false;                              // -passes 1: assemble in a single pass.
+    bool m_compareLexers = false;                           // -lexer compare: time and check the lexer against the line parser.
+    emulator::Engine m_engine = emulator::ENGINE_SWITCH;   // Engine selected with -engine.
+    bool m_verifyEngines = false;                           // -engine verify: compare the engines instead of running one.
+    bool m_compareDecoding = false;                         // -decode compare: time decoding on the fly against pre-decoding.
+    string m_batchFile;                                     // -batch: file of input sets to run in lockstep.
+    string m_jobsFile;                                      // -jobs: file of input sets to run on the thread pool.
+    string m_sessionsFile;                                  // -sessions: file of input sets to serve as interactive sessions.
+    string m_inputFile;                                     // -input: file of values for READ.
+    bool m_bufferedOutput = false;                          // -output buffered: block the output of WRITE.
+    string m_statsFile;                                     // -stats: where to write the execution statistics.
+    string m_profileFile;                                   // -profile: where to write the folded stacks.
+    string m_coverageFile;                                  // -coverage: where to write the LCOV tracefile.
+    string m_cfgFile;                                       // -cfg: where to write the control-flow graph.
+    string m_traceFile;                                     // -trace: where to write the instruction trace.
+    std::vector<int> m_breakpoints;                         // -break: locations to report when reached.
+    string m_recordFile;                                    // -record, -record-trace: where to write the recording.
+    bool m_recordTrace = false;                             // -record-trace: include the trace in the recording.
+    string m_replayFile;                                    // -replay: recording to replay.
+    string m_debugFile;                                     // -debug: commands for the time-travel debugger.
+    long long m_instructionLimit = 0;                       // -limit: watchdog instruction limit, 0 for none.
+    double m_timeLimit = 0;                                 // -timeout: watchdog time limit in seconds, 0 for none.
+
+    int m_address1; // Numeric value of the first operand.
+    int m_address2; // Numeric value of the second operand.
+
+    // Handles the special case of the "copy" instruction which gets translated into two machine instructions.
+    void HandleCopyInstruction(int a_location, const string& a_operand1, const string& a_operand2);
+    std::vector<string> m_machineCode; // Vector to store the translated machine code.
+    std::vector<int> m_sourceLines;    // Source line number of each entry of m_machineCode.
+
+    ParsedSource m_source;             // Every line of the source, as PassI parsed it.
+
+    // Reads the next line of the source into m_source, locating its label as pass I does. Returns false at the end.
+    bool ReadSourceLine(int& a_loc, bool& a_ended);
+
+    // Times the line parser and the lexer over the source and checks that they agree.
+    void CompareLexers();
+
+    // Gives every operand that names a symbol its value from the complete symbol table.
+    void ResolveOperands();
+
+    // Writes the translation of m_source and saves its machine code for the emulator.
+    void WriteTranslation();
+
+    // Runs the loaded program on every engine with the same input and reports any difference.
+    void VerifyEngines(const emulator& a_loaded);
+
+    // Times the loaded program with every instruction decoded as it is fetched and with the program pre-decoded.
+    void CompareDecoding(const emulator& a_loaded);
+
+    // Runs the loaded program once for every line of input values in m_batchFile.
+    void RunBatch(const emulator& a_loaded);
+
+    // Runs the loaded program once for every line of input values in m_jobsFile, on all cores.
+    void RunJobs(const emulator& a_loaded);
+
+    // Runs the loaded program as one interactive session per line of input values in m_sessionsFile, on one thread.
+    void RunSessions(const emulator& a_loaded);
+
+    // Reads a file holding one line of READ values per run. Returns false if it cannot be opened.
+    static bool ReadInputSets(const string& a_file, std::vector<std::vector<long long>>& a_inputs);
+
+    // Runs the loaded program under the time-travel debugger, taking commands from m_debugFile.
+    // Returns true if the program halted.
+    bool RunDebugger(InputDevice& a_input, OutputDevice& a_output);
+
+    // Reports whether a replay reproduced the recorded run.
+    void ReportReplay(const Replayer& a_replayer, bool a_succeeded);
+
+    // Prints the per-label profile of a profiled run and writes its folded stacks to m_profileFile.
+    void WriteProfile(const emulator& a_emu);
+
+    // Prints the control-flow analysis of the loaded program and writes its graph to m_cfgFile.
+    void WriteControlFlow(const emulator& a_loaded);
+
+    // Prints the source annotated with the lines a covered run executed and writes their LCOV tracefile to m_coverageFile.
+    void WriteCoverage(const emulator& a_emu);
+
+#ifdef VC_STATS
+    // Writes the statistics of a run to m_statsFile as JSON.
+    void WriteStats(const ExecutionStats& a_stats);
+#endif
+
+};
@@ -0,0 +1,577 @@
+//
+//  Implementation of the lockstep batch emulator.
+//
+#include "stdafx.h"
+#include "Batch.h"
+#include <algorithm>
+#include <climits>
+#include <new>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define VC_BATCH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only allow AVX2 intrinsics in functions compiled for AVX2. MSVC allows them anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define VC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define VC_TARGET_AVX2
+#endif
+
+// Number of 64-bit lanes in an AVX2 register. Memory rows are padded to a multiple of this.
+static const int VECTOR_LANES = 4;
+
+// The operations with a vector kernel.
+enum KernelOp { KERNEL_ADD, KERNEL_SUB, KERNEL_MULT, KERNEL_COPY };
+
+// How the lanes of a group go at a conditional branch.
+enum BranchOutcome { BRANCH_NONE, BRANCH_ALL, BRANCH_SPLIT };
+
+// Applies a_op to the selected lanes of a row: a_dst[i] = a_dst[i] op a_src[i] where a_mask[i] is all ones.
+static void KernelScalar(KernelOp a_op, long long* a_dst, const long long* a_src, const long long* a_mask, int a_count)
+{
+    for (int i = 0; i < a_count; i++) {
+        if (a_mask[i] == 0) {
+            continue;
+        }
+        unsigned long long a = static_cast<unsigned long long>(a_dst[i]);
+        unsigned long long b = static_cast<unsigned long long>(a_src[i]);
+        switch (a_op) {
+        case KERNEL_ADD:  a_dst[i] = static_cast<long long>(a + b); break;
+        case KERNEL_SUB:  a_dst[i] = static_cast<long long>(a - b); break;
+        case KERNEL_MULT: a_dst[i] = static_cast<long long>(a * b); break;
+        case KERNEL_COPY: a_dst[i] = static_cast<long long>(b); break;
+        }
+    }
+}
+
+// Sets a_taken to the lanes of a_mask whose word in a_test makes the conditional branch a_opcode (BM, BZ or BP) jump.
+static BranchOutcome TakenScalar(int a_opcode, const long long* a_test, const long long* a_mask, long long* a_taken, int a_count)
+{
+    bool taken = false, missed = false;
+    for (int i = 0; i < a_count; i++) {
+        const bool jump = a_opcode == 10 ? a_test[i] < 0 : a_opcode == 11 ? a_test[i] == 0 : a_test[i] > 0;
+        a_taken[i] = jump ? a_mask[i] : 0;
+        taken = taken || (jump && a_mask[i] != 0);
+        missed = missed || (!jump && a_mask[i] != 0);
+    }
+    return !taken ? BRANCH_NONE : !missed ? BRANCH_ALL : BRANCH_SPLIT;
+}
+
+// Stores a_value into the words of a_row that a_mask selects.
+static void StoreScalar(long long* a_row, long long a_value, const long long* a_mask, int a_count)
+{
+    for (int i = 0; i < a_count; i++) {
+        a_row[i] = a_mask[i] != 0 ? a_value : a_row[i];
+    }
+}
+
+// Returns the lowest word of a_row selected by a_mask but not by a_except, or LLONG_MAX if there is none.
+static long long LowestScalar(const long long* a_row, const long long* a_mask, const long long* a_except, int a_count)
+{
+    long long lowest = LLONG_MAX;
+    for (int i = 0; i < a_count; i++) {
+        if (a_mask[i] != 0 && a_except[i] == 0 && a_row[i] < lowest) {
+            lowest = a_row[i];
+        }
+    }
+    return lowest;
+}
+
+// Sets a_result to the lanes of a_mask whose word in a_row is a_value.
+static void MatchScalar(const long long* a_row, long long a_value, const long long* a_mask, long long* a_result, int a_count)
+{
+    for (int i = 0; i < a_count; i++) {
+        a_result[i] = a_row[i] == a_value ? a_mask[i] : 0;
+    }
+}
+
+#ifdef VC_BATCH_X86
+
+// 64-bit multiply (low half) built from 32-bit products, since AVX2 has no vpmullq.
+VC_TARGET_AVX2 static inline __m256i Multiply64(__m256i a_a, __m256i a_b)
+{
+    __m256i cross = _mm256_mullo_epi32(a_a, _mm256_shuffle_epi32(a_b, 0xB1));   // a.lo * b.hi, a.hi * b.lo
+    __m256i crossSum = _mm256_add_epi32(cross, _mm256_srli_epi64(cross, 32));   // both cross terms in the low half
+    __m256i low = _mm256_mul_epu32(a_a, a_b);                                   // a.lo * b.lo as 64 bits
+    return _mm256_add_epi64(low, _mm256_slli_epi64(crossSum, 32));
+}
+
+// AVX2 version of KernelScalar for the operation OP, so the loop has no switch. a_count must be a multiple of VECTOR_LANES.
+template <KernelOp OP>
+VC_TARGET_AVX2 static void KernelAvx2(long long* a_dst, const long long* a_src, const long long* a_mask, int a_count)
+{
+    for (int i = 0; i < a_count; i += VECTOR_LANES) {
+        __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_mask + i));
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_dst + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_src + i));
+        __m256i result = OP == KERNEL_ADD ? _mm256_add_epi64(a, b) : OP == KERNEL_SUB ? _mm256_sub_epi64(a, b) : OP == KERNEL_MULT ? Multiply64(a, b) : b;
+        // A blend and a whole store rather than vpmaskmovq, so the next instruction's load of the row can be forwarded.
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(a_dst + i), _mm256_blendv_epi8(a, result, mask));
+    }
+}
+
+// Calls the instantiation of KernelAvx2 for a_op.
+VC_TARGET_AVX2 static void KernelAvx2(KernelOp a_op, long long* a_dst, const long long* a_src, const long long* a_mask, int a_count)
+{
+    switch (a_op) {
+    case KERNEL_ADD:  KernelAvx2<KERNEL_ADD>(a_dst, a_src, a_mask, a_count); break;
+    case KERNEL_SUB:  KernelAvx2<KERNEL_SUB>(a_dst, a_src, a_mask, a_count); break;
+    case KERNEL_MULT: KernelAvx2<KERNEL_MULT>(a_dst, a_src, a_mask, a_count); break;
+    case KERNEL_COPY: KernelAvx2<KERNEL_COPY>(a_dst, a_src, a_mask, a_count); break;
+    }
+}
+
+// AVX2 version of TakenScalar: one compare for four lanes, and the outcome from their sign bits.
+VC_TARGET_AVX2 static BranchOutcome TakenAvx2(int a_opcode, const long long* a_test, const long long* a_mask, long long* a_taken, int a_count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    int taken = 0, missed = 0;
+    for (int i = 0; i < a_count; i += VECTOR_LANES) {
+        __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_mask + i));
+        __m256i test = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_test + i));
+        __m256i jump = a_opcode == 10 ? _mm256_cmpgt_epi64(zero, test) : a_opcode == 11 ? _mm256_cmpeq_epi64(test, zero) : _mm256_cmpgt_epi64(test, zero);
+        __m256i jumped = _mm256_and_si256(jump, mask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(a_taken + i), jumped);
+        taken |= _mm256_movemask_pd(_mm256_castsi256_pd(jumped));
+        missed |= _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_andnot_si256(jump, mask)));
+    }
+    return taken == 0 ? BRANCH_NONE : missed == 0 ? BRANCH_ALL : BRANCH_SPLIT;
+}
+
+// AVX2 version of StoreScalar.
+VC_TARGET_AVX2 static void StoreAvx2(long long* a_row, long long a_value, const long long* a_mask, int a_count)
+{
+    const __m256i value = _mm256_set1_epi64x(a_value);
+    for (int i = 0; i < a_count; i += VECTOR_LANES) {
+        __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_mask + i));
+        __m256i row = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_row + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(a_row + i), _mm256_blendv_epi8(row, value, mask));
+    }
+}
+
+// AVX2 version of LowestScalar. AVX2 has no 64-bit minimum, so it is a compare and a blend.
+VC_TARGET_AVX2 static long long LowestAvx2(const long long* a_row, const long long* a_mask, const long long* a_except, int a_count)
+{
+    const __m256i none = _mm256_set1_epi64x(LLONG_MAX);
+    __m256i lowest = none;
+    for (int i = 0; i < a_count; i += VECTOR_LANES) {
+        __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_mask + i));
+        __m256i except = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_except + i));
+        __m256i row = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_row + i));
+        row = _mm256_blendv_epi8(none, row, _mm256_andnot_si256(except, mask));
+        lowest = _mm256_blendv_epi8(lowest, row, _mm256_cmpgt_epi64(lowest, row));
+    }
+    alignas(32) long long lanes[VECTOR_LANES];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), lowest);
+    return std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+}
+
+// AVX2 version of MatchScalar.
+VC_TARGET_AVX2 static void MatchAvx2(const long long* a_row, long long a_value, const long long* a_mask, long long* a_result, int a_count)
+{
+    const __m256i value = _mm256_set1_epi64x(a_value);
+    for (int i = 0; i < a_count; i += VECTOR_LANES) {
+        __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_mask + i));
+        __m256i row = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_row + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(a_result + i), _mm256_and_si256(_mm256_cmpeq_epi64(row, value), mask));
+    }
+}
+
+#endif
+
+// Calls the AVX2 version of a kernel where the host has it, and the scalar version otherwise. Both take whole rows
+// of m_stride words; the padding lanes are never selected.
+#ifdef VC_BATCH_X86
+#define VC_BATCH_KERNEL(name, ...) (m_useAvx2 ? name##Avx2(__VA_ARGS__) : name##Scalar(__VA_ARGS__))
+#else
+#define VC_BATCH_KERNEL(name, ...) name##Scalar(__VA_ARGS__)
+#endif
+
+/**/
+/*
+bool BatchEmulator::HasAvx2()
+
+NAME
+
+        BatchEmulator::HasAvx2 - Checks whether the host can run the AVX2 kernels.
+
+SYNOPSIS
+
+        static bool BatchEmulator::HasAvx2();
+
+DESCRIPTION
+
+        This method asks the processor, through cpuid, whether it supports AVX2 and whether
+        the operating system saves the AVX registers. On other architectures it returns false
+        and the scalar kernels are used.
+
+RETURNS
+
+        Returns true if AVX2 can be used, otherwise false.
+*/
+/**/
+bool BatchEmulator::HasAvx2()
+{
+#if defined(VC_BATCH_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(VC_BATCH_X86)
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    return false;
+#endif
+}
+
+
+/**/
+/*
+BatchEmulator::BatchEmulator(const emulator& a_image, int a_lanes)
+
+NAME
+
+        BatchEmulator::BatchEmulator - Constructor for the BatchEmulator class.
+
+SYNOPSIS
+
+        BatchEmulator::BatchEmulator(const emulator& a_image, int a_lanes);
+            a_image    --> An emulator with the program loaded into memory.
+            a_lanes    --> The number of independent runs to execute together.
+
+DESCRIPTION
+
+        This constructor lays out a_lanes copies of the image's memory so that word w of
+        lane l is at m_memory[w * m_stride + l]. The stride is rounded up to a whole AVX2
+        vector; the padding lanes are never running, so they are never selected. Memory use
+        is MEMSZ * m_stride words, so callers with many input sets should run them in
+        batches, with Reset between them. The words are allocated with calloc rather than
+        filled with zeroes, since a block this size comes zeroed from the system and its
+        pages are only touched once a row is used; only the rows the image fills are. The loaded cells are decoded once here, as the
+        scalar emulator does before a run, since every lane holds the same program. The
+        first batch, of a_lanes runs, is ready to start at cell 0.
+
+*/
+/**/
+BatchEmulator::BatchEmulator(const emulator& a_image, int a_lanes)
+    : m_laneCount(a_lanes), m_codeLimit(a_image.GetLoadedLimit()), m_useAvx2(HasAvx2()), m_image(a_image.GetMemory())
+{
+    m_stride = (a_lanes + VECTOR_LANES - 1) / VECTOR_LANES * VECTOR_LANES;
+    m_memory.reset(static_cast<long long*>(std::calloc(static_cast<size_t>(emulator::MEMSZ) * m_stride, sizeof(long long))));
+    if (!m_memory) {
+        throw std::bad_alloc();
+    }
+    m_dirty.assign(emulator::PAGES, 0);
+    m_mask.assign(m_stride, 0);
+    m_running.assign(m_stride, 0);
+    m_cell.assign(m_stride, 0);
+    m_taken.assign(m_stride, 0);
+    m_stored.assign(emulator::MEMSZ, false);
+
+    for (int location = 0; location < emulator::MEMSZ; location++) {
+        if (m_image[location] != 0) {
+            std::fill_n(Row(location), m_stride, m_image[location]);
+        }
+    }
+    m_decoded.resize(m_codeLimit);
+    for (int location = 0; location < m_codeLimit; location++) {
+        m_decoded[location] = emulator::Decode(m_image[location]);
+    }
+    Reset(a_lanes);
+}
+
+/**/
+/*
+void BatchEmulator::Reset(int a_lanes)
+
+NAME
+
+        BatchEmulator::Reset - Prepares the emulator for the next batch of runs.
+
+SYNOPSIS
+
+        void BatchEmulator::Reset(int a_lanes);
+            a_lanes    --> The number of runs in the batch, at most the lanes given to the constructor.
+
+DESCRIPTION
+
+        This method returns the interleaved memory to the image and starts a_lanes runs at
+        cell 0, with no input and no output. Only the pages of rows that some lane has
+        written since the last reset are copied back from the image, as emulator::Restore
+        does, so a batch of short runs costs a few rows rather than all of memory.
+
+*/
+/**/
+void BatchEmulator::Reset(int a_lanes)
+{
+    for (int page = 0; page < emulator::PAGES; page++) {
+        if (m_dirty[page] == 0) {
+            continue;
+        }
+        const int end = std::min((page + 1) * emulator::PAGE_WORDS, static_cast<int>(emulator::MEMSZ));
+        for (int location = page * emulator::PAGE_WORDS; location < end; location++) {
+            std::fill_n(Row(location), m_stride, m_image[location]);
+        }
+        m_dirty[page] = 0;
+    }
+    std::fill(m_stored.begin(), m_stored.end(), false);
+
+    m_laneCount = a_lanes;
+    m_lanes.assign(a_lanes, Lane());
+    std::fill(m_running.begin(), m_running.end(), 0);
+    std::fill_n(m_running.begin(), m_laneCount, -1);
+    std::fill(m_cell.begin(), m_cell.end(), 0);
+    m_leader = 0;
+    m_lowestParked = 0;
+}
+
+/**/
+/*
+void BatchEmulator::Run()
+
+NAME
+
+        BatchEmulator::Run - Runs every lane to completion.
+
+SYNOPSIS
+
+        void BatchEmulator::Run();
+
+DESCRIPTION
+
+        This method selects a group of lanes that are at the same location and executes
+        instructions for all of them together, one step per instruction. While control flow
+        is uniform the group is every running lane and it simply moves on from cell to cell,
+        so each step does the work of all runs. A new group is selected only when the group
+        breaks up, or reaches a cell where other lanes are waiting. The lanes at the lowest
+        location always go first, which lets the lanes that are behind catch up and merge
+        back into one group.
+
+*/
+/**/
+void BatchEmulator::Run()
+{
+    int cell = SelectGroup();
+    while (cell >= 0) {
+        const int next = Step(cell);
+        cell = next >= 0 ? next : SelectGroup();
+    }
+}
+
+/**/
+/*
+int BatchEmulator::SelectGroup()
+
+NAME
+
+        BatchEmulator::SelectGroup - Chooses the lanes for the next steps.
+
+SYNOPSIS
+
+        int BatchEmulator::SelectGroup();
+
+DESCRIPTION
+
+        This method finds the lowest cell any running lane is at and sets m_mask for the
+        running lanes at that cell, with the vector kernels. If some lane has stored into that
+        cell the lanes may hold different instructions there, so a lane is then only grouped
+        with the leader if its instruction word matches as well. The lowest cell of the lanes left out is kept in m_lowestParked.
+
+RETURNS
+
+        Returns the cell of the group, or -1 if no lane is still running.
+*/
+/**/
+int BatchEmulator::SelectGroup()
+{
+    std::fill(m_mask.begin(), m_mask.end(), 0);
+    const long long cell = VC_BATCH_KERNEL(Lowest, m_cell.data(), m_running.data(), m_mask.data(), m_stride);
+    if (cell == LLONG_MAX) {
+        return -1;
+    }
+    VC_BATCH_KERNEL(Match, m_cell.data(), cell, m_running.data(), m_mask.data(), m_stride);
+
+    m_leader = 0;
+    while (m_mask[m_leader] == 0) {
+        m_leader++;
+    }
+    if (m_stored[cell]) {
+        const long long* row = Row(static_cast<int>(cell));
+        for (int lane = m_leader + 1; lane < m_laneCount; lane++) {
+            if (m_mask[lane] != 0 && row[lane] != row[m_leader]) {
+                m_mask[lane] = 0;
+            }
+        }
+    }
+
+    m_lowestParked = VC_BATCH_KERNEL(Lowest, m_cell.data(), m_running.data(), m_mask.data(), m_stride);
+    return static_cast<int>(cell);
+}
+
+// Only the lanes outside the group keep their cells in m_cell, so the group writes its own back when it breaks up.
+int BatchEmulator::Regroup(int a_cell)
+{
+    VC_BATCH_KERNEL(Store, m_cell.data(), a_cell, m_mask.data(), m_stride);
+    return -1;
+}
+
+// Leaving the run happens once per lane, so it is done lane by lane.
+int BatchEmulator::Retire(const std::vector<long long>& a_lanes, LaneState a_state)
+{
+    for (int lane = 0; lane < m_laneCount; lane++) {
+        if (a_lanes[lane] != 0) {
+            m_lanes[lane].state = a_state;
+            m_running[lane] = 0;
+        }
+    }
+    return -1;
+}
+
+/**/
+/*
+int BatchEmulator::Step(int a_cell)
+
+NAME
+
+        BatchEmulator::Step - Executes one instruction for the current group.
+
+SYNOPSIS
+
+        int BatchEmulator::Step(int a_cell);
+            a_cell    --> The cell all the lanes in m_mask are at.
+
+DESCRIPTION
+
+        This method executes the instruction at a_cell once for the group, decoded in advance
+        unless a lane has stored into the cell. If it has, and the cell no longer holds the same
+        word in every lane, the group is broken up so SelectGroup can split it by instruction. ADD, SUB, MULT and
+        COPY run through the vector kernel, which updates every selected lane's word with
+        masked stores. A conditional branch compares the tested word of every lane at once:
+        if all the lanes go the same way the group goes with them, and otherwise the lanes
+        that jump are parked at the target. DIV, READ and WRITE are handled lane by lane.
+        The group leaves the running set at HALT or past the end of memory, and a lane that
+        faults leaves it on its own.
+
+RETURNS
+
+        Returns the cell the group goes on to, or -1 if a new group must be selected.
+*/
+/**/
+int BatchEmulator::Step(int a_cell)
+{
+    // A cell that a lane has stored into may hold a different instruction in each lane.
+    if (m_stored[a_cell]) {
+        const long long* row = Row(a_cell);
+        for (int lane = 0; lane < m_laneCount; lane++) {
+            if (m_mask[lane] != 0 && row[lane] != row[m_leader]) {
+                return Regroup(a_cell);
+            }
+        }
+    }
+
+    const DecodedInstruction inst = a_cell < m_codeLimit && !m_stored[a_cell] ? m_decoded[a_cell] : emulator::Decode(Row(a_cell)[m_leader]);
+    long long* dst = Row(inst.operand1);
+    const long long* src = Row(inst.operand2);
+    const int target = inst.operand1 - 100;
+    int next = a_cell + 1;
+    bool regroup = false;
+
+    switch (inst.opcode) {
+    case 1:  // ADD
+    case 2:  // SUB
+    case 3:  // MULT
+    case 5:  // COPY
+    {
+        const KernelOp op = inst.opcode == 1 ? KERNEL_ADD : inst.opcode == 2 ? KERNEL_SUB : inst.opcode == 3 ? KERNEL_MULT : KERNEL_COPY;
+        VC_BATCH_KERNEL(Kernel, op, dst, src, m_mask.data(), m_stride);
+        MarkStored(inst.operand1);
+        break;
+    }
+    case 4:  // DIV
+    case 7:  // READ
+    case 8:  // WRITE
+        for (int lane = 0; lane < m_laneCount; lane++) {
+            if (m_mask[lane] == 0) {
+                continue;
+            }
+            Lane& state = m_lanes[lane];
+            bool faulted = false;
+            if (inst.opcode == 4) {
+                faulted = src[lane] == 0;
+                if (!faulted) {
+                    dst[lane] /= src[lane];
+                }
+            }
+            else if (inst.opcode == 7) {
+                faulted = state.inputPos >= state.input.size();
+                if (!faulted) {
+                    dst[lane] = state.input[state.inputPos++];
+                }
+            }
+            else {
+                state.output.push_back(dst[lane]);
+            }
+            if (faulted) {
+                state.state = LANE_FAULTED;
+                m_running[lane] = 0;
+                m_mask[lane] = 0;
+                regroup = true;
+            }
+        }
+        if (inst.opcode != 8) {
+            MarkStored(inst.operand1);
+        }
+        break;
+    case 9:  // BRANCH
+        next = target;
+        break;
+    case 10: // BRANCH MINUS
+    case 11: // BRANCH ZERO
+    case 12: // BRANCH POSITIVE
+        switch (VC_BATCH_KERNEL(Taken, inst.opcode, src, m_mask.data(), m_taken.data(), m_stride)) {
+        case BRANCH_ALL:
+            next = target;
+            break;
+        case BRANCH_NONE:
+            break;
+        case BRANCH_SPLIT:
+            // The lanes that jump leave the group for the target; the others go on.
+            VC_BATCH_KERNEL(Store, m_mask.data(), 0, m_taken.data(), m_stride);
+            if (target < 0 || target > emulator::MEMSZ - 100) {
+                Retire(m_taken, target < 0 ? LANE_FAULTED : LANE_HALTED);
+            }
+            else {
+                VC_BATCH_KERNEL(Store, m_cell.data(), target, m_taken.data(), m_stride);
+                m_lowestParked = std::min<long long>(m_lowestParked, target);
+            }
+            regroup = m_mask[m_leader] == 0;
+            break;
+        }
+        break;
+    case 13: // HALT
+        return Retire(m_mask, LANE_HALTED);
+    default:
+        break;
+    }
+
+    if (next < 0) {
+        return Retire(m_mask, LANE_FAULTED);
+    }
+    if (next > emulator::MEMSZ - 100) {
+        return Retire(m_mask, LANE_HALTED);
+    }
+    if (regroup || next >= m_lowestParked) {
+        return Regroup(next);
+    }
+    return next;
+}
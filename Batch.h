@@ -0,0 +1,109 @@
+/*
+The BatchEmulator class runs one loaded VC1620 program against many input sets at once. Every run (lane) has its own copy of memory, but the copies
+are interleaved word by word (struct of arrays) so that an ADD, SUB, MULT or COPY executed by a group of lanes at the same location is a single pass
+of AVX2 vector operations over consecutive words. The cell and running state of every lane are vectors of masks too, so while control flow is
+uniform a group moves from one instruction to the next with no work per lane; a conditional branch is one vector compare. Lanes whose branches go
+different ways are masked off and regrouped by location. One BatchEmulator serves any number of batches: Reset puts back only the pages of
+interleaved memory that the last batch wrote, as emulator::Restore does, instead of laying out all of memory again.
+*/
+
+#ifndef _BATCH_H      // UNIX way of preventing multiple inclusions.
+#define _BATCH_H
+
+#include <cstdlib>      // The interleaved memory is allocated with calloc.
+#include <memory>       // And owned by a unique_ptr.
+#include <vector>       // Vector is a container that encapsulates dynamic size arrays.
+#include "Emulator.h"   // The loaded program is taken from an emulator.
+
+// BatchEmulator executes the same program in lockstep for several independent input sets.
+class BatchEmulator {
+
+public:
+
+    // Constructor. Copies the memory of a_image into a_lanes interleaved lanes, ready to run a batch of a_lanes.
+    BatchEmulator(const emulator& a_image, int a_lanes);
+
+    // Starts a new batch of a_lanes runs, at most the lanes given to the constructor, each with no input yet. Memory
+    // goes back to the image by rewriting only the pages written since the last reset.
+    void Reset(int a_lanes);
+
+    // Sets the values that READ returns in lane a_lane, in order.
+    void SetInput(int a_lane, const std::vector<long long>& a_input) { m_lanes[a_lane].input = a_input; }
+
+    // Runs every lane until it halts or faults.
+    void Run();
+
+    // Results of a lane after Run: whether it ran successfully, and the values it wrote.
+    bool GetResult(int a_lane) const { return m_lanes[a_lane].state == LANE_HALTED; }
+    const std::vector<long long>& GetOutput(int a_lane) const { return m_lanes[a_lane].output; }
+
+    // Returns the contents of a_location in lane a_lane.
+    long long GetMemory(int a_lane, int a_location) const { return m_memory[static_cast<size_t>(a_location) * m_stride + a_lane]; }
+
+    // Returns true if the AVX2 kernels are used on this host.
+    static bool HasAvx2();
+
+private:
+
+    enum LaneState {
+        LANE_RUNNING,
+        LANE_HALTED,    // Reached HALT or ran off the end of memory.
+        LANE_FAULTED    // Division by zero, a branch below 100, or READ with no input left.
+    };
+
+    // State that is only needed lane by lane.
+    struct Lane {
+        LaneState state = LANE_RUNNING;
+        std::vector<long long> input;       // Values for READ.
+        size_t inputPos = 0;                // Next value of input to read.
+        std::vector<long long> output;      // Values written by WRITE.
+    };
+
+    // Executes one instruction for the lanes selected in m_mask, all at cell a_cell. Returns the cell the whole group
+    // goes on to, or -1 if the group has broken up and a new one must be selected.
+    int Step(int a_cell);
+
+    // Picks the next group of lanes to execute into m_mask. Returns its cell, or -1 if no lane is running.
+    int SelectGroup();
+
+    // Sets the cell of the lanes of the group to a_cell and returns -1, so that the next group is selected.
+    int Regroup(int a_cell);
+
+    // Takes the lanes selected in a_lanes out of the running set with the final state a_state. Returns -1.
+    int Retire(const std::vector<long long>& a_lanes, LaneState a_state);
+
+    // Returns a pointer to the lane-interleaved row of words for a_location.
+    long long* Row(int a_location) { return m_memory.get() + static_cast<size_t>(a_location) * m_stride; }
+
+    // Releases memory allocated with calloc.
+    struct FreeMemory {
+        void operator()(long long* a_block) const { std::free(a_block); }
+    };
+
+    // Records that some lane has stored into a_location.
+    void MarkStored(int a_location)
+    {
+        m_stored[a_location] = true;
+        m_dirty[a_location / emulator::PAGE_WORDS] = 1;
+    }
+
+    int m_laneCount;                    // Number of lanes in the current batch.
+    int m_stride;                       // Lanes per memory row: the constructor's lanes, rounded up to a whole AVX2 vector.
+    int m_codeLimit;                    // Cells of the image that hold the loaded program, decoded in m_decoded.
+    bool m_useAvx2;                     // Selected once, from HasAvx2.
+
+    std::unique_ptr<long long[], FreeMemory> m_memory;  // MEMSZ rows of m_stride words.
+    EmulatorMemory m_image;             // Memory of the image, which Reset puts back.
+    std::vector<unsigned char> m_dirty; // One flag per page of rows, set when any lane writes the page.
+    std::vector<long long> m_mask;      // All ones for lanes in the current group, zero otherwise.
+    std::vector<long long> m_running;   // All ones for lanes that have neither halted nor faulted.
+    std::vector<long long> m_cell;      // Cell of the next instruction of each lane outside the group (location - 100).
+    std::vector<long long> m_taken;     // The lanes of the group whose conditional branch is taken.
+    int m_leader = 0;                   // The first lane of the group, whose instruction the group executes.
+    long long m_lowestParked = 0;       // Lowest cell of a running lane outside the group; the group stops there.
+    std::vector<DecodedInstruction> m_decoded;  // The loaded cells, decoded; used until a lane stores into the cell.
+    std::vector<bool> m_stored;         // Cells any lane has stored into, which may no longer hold the same word in every lane.
+    std::vector<Lane> m_lanes;
+};
+
+#endif
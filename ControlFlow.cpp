@@ -0,0 +1,231 @@
+//
+//  Implementation of the control-flow graph analysis.
+//
+#include "stdafx.h"
+#include "ControlFlow.h"
+
+// Analyses the cells as given.
+ControlFlowGraph::ControlFlowGraph(const std::vector<DecodedInstruction>& a_code, int a_entry)
+    : m_entry(a_entry)
+{
+    Build(a_code);
+    Analyse();
+}
+
+// Decodes the loaded cells the way emulator::PreDecode does.
+ControlFlowGraph::ControlFlowGraph(const emulator& a_emu)
+    : m_entry(0)
+{
+    std::vector<DecodedInstruction> code(a_emu.GetLoadedLimit());
+    for (int cell = 0; cell < a_emu.GetLoadedLimit(); cell++) {
+        code[cell] = emulator::Decode(a_emu.GetMemory()[cell]);
+    }
+    Build(code);
+    Analyse();
+}
+
+// Cells outside the image belong to no block.
+int ControlFlowGraph::GetBlockOf(int a_cell) const
+{
+    return a_cell >= 0 && a_cell < static_cast<int>(m_blockOf.size()) ? m_blockOf[a_cell] : -1;
+}
+
+/**/
+/*
+void ControlFlowGraph::Build(const std::vector<DecodedInstruction>& a_code)
+
+NAME
+
+        ControlFlowGraph::Build - Splits the program into basic blocks.
+
+SYNOPSIS
+
+        void ControlFlowGraph::Build(const std::vector<DecodedInstruction>& a_code);
+            a_code    --> The decoded cells of the program.
+
+DESCRIPTION
+
+        A block starts at the entry cell, at every cell a branch targets, and at the cell
+        after every branch and HALT. It ends where the next one starts. The successors of a
+        block come from its last instruction: the target of a branch, if it lies inside the
+        image, and the next block unless the instruction is B or HALT. A target outside the
+        image, or a fall-through past the last cell, makes the block one that leaves.
+
+*/
+/**/
+void ControlFlowGraph::Build(const std::vector<DecodedInstruction>& a_code)
+{
+    const int size = static_cast<int>(a_code.size());
+    std::vector<bool> leader(size, false);
+    if (size > 0) {
+        leader[0] = true;
+    }
+    if (m_entry >= 0 && m_entry < size) {
+        leader[m_entry] = true;
+    }
+    for (int cell = 0; cell < size; cell++) {
+        const DecodedInstruction& inst = a_code[cell];
+        if (IsBranch(inst.opcode) && inst.operand1 - 100 >= 0 && inst.operand1 - 100 < size) {
+            leader[inst.operand1 - 100] = true;
+        }
+        if ((IsBranch(inst.opcode) || inst.opcode == 13) && cell + 1 < size) {
+            leader[cell + 1] = true;
+        }
+    }
+
+    m_blockOf.assign(size, -1);
+    for (int cell = 0; cell < size; cell++) {
+        if (leader[cell]) {
+            BasicBlock block;
+            block.first = cell;
+            block.end = cell;
+            m_blocks.push_back(block);
+        }
+        BasicBlock& block = m_blocks.back();
+        block.end = cell + 1;
+        block.code = block.code || a_code[cell].opcode != 0;
+        m_blockOf[cell] = static_cast<int>(m_blocks.size()) - 1;
+    }
+
+    for (int index = 0; index < static_cast<int>(m_blocks.size()); index++) {
+        BasicBlock& block = m_blocks[index];
+        const DecodedInstruction& last = a_code[block.end - 1];
+        if (IsBranch(last.opcode)) {
+            const int target = last.operand1 - 100;
+            if (target >= 0 && target < size) {
+                block.successors.push_back(m_blockOf[target]);
+            }
+            else {
+                block.leaves = true;
+            }
+        }
+        if (last.opcode == 13) {
+            block.halts = true;
+        }
+        else if (last.opcode != 9) {
+            if (block.end < size) {
+                // A conditional branch to the next cell has the same block on both edges
+                if (block.successors.empty() || block.successors[0] != index + 1) {
+                    block.successors.push_back(index + 1);
+                }
+            }
+            else {
+                block.leaves = true;
+            }
+        }
+        for (int successor : block.successors) {
+            m_blocks[successor].predecessors.push_back(index);
+        }
+    }
+}
+
+/**/
+/*
+void ControlFlowGraph::Analyse()
+
+NAME
+
+        ControlFlowGraph::Analyse - Finds the reachable blocks and the loop headers.
+
+SYNOPSIS
+
+        void ControlFlowGraph::Analyse();
+
+DESCRIPTION
+
+        This method walks the graph depth first from the entry block. Every block the walk
+        visits is reachable. An edge to a block that is still on the walk's path closes a
+        loop, and the block it goes to is a loop header; this finds the headers of loops
+        with more than one entry as well as those of ordinary ones.
+
+*/
+/**/
+void ControlFlowGraph::Analyse()
+{
+    const int entry = GetEntryBlock();
+    if (entry < 0) {
+        return;
+    }
+
+    // The walk keeps, for each block on the path, the next successor to try.
+    std::vector<bool> onPath(m_blocks.size(), false);
+    std::vector<std::pair<int, size_t>> path;
+    m_blocks[entry].reachable = true;
+    onPath[entry] = true;
+    path.push_back({ entry, 0 });
+    while (!path.empty()) {
+        const int index = path.back().first;
+        const size_t next = path.back().second++;
+        if (next == m_blocks[index].successors.size()) {
+            onPath[index] = false;
+            path.pop_back();
+            continue;
+        }
+        const int successor = m_blocks[index].successors[next];
+        if (onPath[successor]) {
+            m_blocks[successor].loopHeader = true;
+        }
+        else if (!m_blocks[successor].reachable) {
+            m_blocks[successor].reachable = true;
+            onPath[successor] = true;
+            path.push_back({ successor, 0 });
+        }
+    }
+}
+
+// Counts first, then lists the headers and each stretch of unreachable code.
+void ControlFlowGraph::WriteReport(std::ostream& a_out) const
+{
+    int reachable = 0, headers = 0;
+    for (const BasicBlock& block : m_blocks) {
+        reachable += block.reachable;
+        headers += block.loopHeader;
+    }
+    a_out << "Control flow: " << m_blocks.size() << " basic blocks, " << reachable << " reachable, "
+        << headers << " loop headers" << std::endl;
+    for (const BasicBlock& block : m_blocks) {
+        if (block.loopHeader) {
+            a_out << "Loop header at " << block.first + 100 << std::endl;
+        }
+    }
+
+    // Adjacent unreachable blocks are reported as one stretch; blocks that are only storage are not code.
+    for (size_t i = 0; i < m_blocks.size(); i++) {
+        if (m_blocks[i].reachable || !m_blocks[i].code) {
+            continue;
+        }
+        size_t last = i;
+        while (last + 1 < m_blocks.size() && !m_blocks[last + 1].reachable && m_blocks[last + 1].code) {
+            last++;
+        }
+        a_out << "Unreachable code at " << m_blocks[i].first + 100 << "-" << m_blocks[last].end - 1 + 100 << std::endl;
+        i = last;
+    }
+}
+
+// One node per block, labelled with its locations, and an exit node for blocks that halt or leave.
+void ControlFlowGraph::WriteDot(std::ostream& a_out) const
+{
+    a_out << "digraph cfg {" << std::endl;
+    a_out << "    node [shape=box];" << std::endl;
+    a_out << "    exit [shape=doublecircle];" << std::endl;
+    for (const BasicBlock& block : m_blocks) {
+        a_out << "    b" << block.first + 100 << " [label=\"" << block.first + 100 << "-" << block.end - 1 + 100 << "\"";
+        if (block.loopHeader) {
+            a_out << ", peripheries=2";
+        }
+        if (!block.reachable) {
+            a_out << ", style=dashed";
+        }
+        a_out << "];" << std::endl;
+    }
+    for (const BasicBlock& block : m_blocks) {
+        for (int successor : block.successors) {
+            a_out << "    b" << block.first + 100 << " -> b" << m_blocks[successor].first + 100 << ";" << std::endl;
+        }
+        if (block.halts || block.leaves) {
+            a_out << "    b" << block.first + 100 << " -> exit" << (block.leaves ? " [style=dotted]" : "") << ";" << std::endl;
+        }
+    }
+    a_out << "}" << std::endl;
+}
@@ -0,0 +1,72 @@
+/*
+The ControlFlowGraph class is a static analysis of a loaded image. It splits the decoded cells into basic blocks - straight runs of instructions
+that are only entered at the top and only left at the bottom - and links them by the edges execution can take: the target of B, BM, BZ and BP
+and the fall-through of everything but B and HALT. HALT ends the program, and so does a block that branches or falls outside the loaded
+image, since what runs there is not known until run time. From the entry block the class finds which blocks are reachable and which are loop
+headers, and reports the code that can never run. The blocks are exposed so that an engine can dispatch a block at a time and precompute
+whatever it caches per block.
+*/
+
+#ifndef _CONTROLFLOW_H      // UNIX way of preventing multiple inclusions.
+#define _CONTROLFLOW_H
+
+#include <iostream>     // Reports are written to a stream.
+#include <vector>       // Vector is a container that encapsulates dynamic size arrays.
+#include "Emulator.h"   // The decoded instructions that are analysed.
+
+// A straight run of cells executed from the first to the last.
+struct BasicBlock {
+    int first;                          // First cell of the block.
+    int end;                            // One past the last cell.
+    std::vector<int> successors;        // Blocks execution can go to next, by index.
+    std::vector<int> predecessors;      // Blocks execution can come from, by index.
+    bool halts = false;                 // Ends with HALT.
+    bool leaves = false;                // Can branch or fall outside the loaded image.
+    bool reachable = false;             // Can be reached from the entry block.
+    bool loopHeader = false;            // Target of an edge that closes a loop.
+    bool code = false;                  // Holds a cell with a non-zero opcode, i.e. is not just storage.
+};
+
+// ControlFlowGraph builds and reports the basic blocks of a program.
+class ControlFlowGraph {
+
+public:
+
+    // Builds the graph of a_code, the decoded cells of a program executed from cell a_entry.
+    ControlFlowGraph(const std::vector<DecodedInstruction>& a_code, int a_entry);
+
+    // Builds the graph of the program loaded into a_emu, which starts at location 100.
+    explicit ControlFlowGraph(const emulator& a_emu);
+
+    // Returns the blocks, in order of their first cell.
+    const std::vector<BasicBlock>& GetBlocks() const { return m_blocks; }
+
+    // Returns the index of the block holding a_cell, or -1 if the cell is outside the image.
+    int GetBlockOf(int a_cell) const;
+
+    // Returns the index of the block execution starts in, or -1 if the entry is outside the image.
+    int GetEntryBlock() const { return GetBlockOf(m_entry); }
+
+    // Writes a summary, the loop headers and the ranges of unreachable code, by location.
+    void WriteReport(std::ostream& a_out) const;
+
+    // Writes the graph in the Graphviz dot language.
+    void WriteDot(std::ostream& a_out) const;
+
+private:
+
+    // Returns true if a_opcode is one of the branch instructions.
+    static bool IsBranch(int a_opcode) { return a_opcode >= 9 && a_opcode <= 12; }
+
+    // Splits the cells into blocks and links them.
+    void Build(const std::vector<DecodedInstruction>& a_code);
+
+    // Marks the reachable blocks and the loop headers with a depth-first search from the entry block.
+    void Analyse();
+
+    int m_entry;                        // Cell execution starts at.
+    std::vector<BasicBlock> m_blocks;   // The blocks, in order of their first cell.
+    std::vector<int> m_blockOf;         // Index of the block holding each cell.
+};
+
+#endif
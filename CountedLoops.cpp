@@ -0,0 +1,201 @@
+//
+//  Implementation of counted-loop acceleration.
+//
+#include "stdafx.h"
+#include "CountedLoops.h"
+#include <cstdint>
+
+// Every backward BP or BM is tried as the end of a loop. A cell can only head one loop.
+std::vector<CountedLoop> CountedLoops::Find(const std::vector<DecodedInstruction>& a_code)
+{
+    std::vector<CountedLoop> loops;
+    std::vector<bool> head(a_code.size(), false);
+    for (int cell = 0; cell < static_cast<int>(a_code.size()); cell++) {
+        CountedLoop loop;
+        if (Recognise(a_code, cell, loop) && !head[loop.head]) {
+            head[loop.head] = true;
+            loops.push_back(loop);
+        }
+    }
+    return loops;
+}
+
+/**/
+/*
+bool CountedLoops::Recognise(const std::vector<DecodedInstruction>& a_code, int a_branch, CountedLoop& a_loop)
+
+NAME
+
+        CountedLoops::Recognise - Decides whether a branch closes a counted loop.
+
+SYNOPSIS
+
+        bool CountedLoops::Recognise(const std::vector<DecodedInstruction>& a_code, int a_branch, CountedLoop& a_loop);
+            a_code      --> The verified program, with branch targets as cells.
+            a_branch    --> The cell of the branch.
+            a_loop      --> The loop, filled in if the branch closes one.
+
+DESCRIPTION
+
+        The branch must be a BP or BM to a cell before it, and every cell from there up to
+        the branch must hold ADD, SUB, COPY or no operation at all, so the body has no I/O
+        and no other way out. The words the body reads must all be words it never writes,
+        so that each iteration sees the same values. The word the branch tests must be
+        written, and only by ADD and SUB, and a word that is copied into must not be
+        written by anything else.
+
+RETURNS
+
+        Returns true if the branch closes a counted loop.
+*/
+/**/
+bool CountedLoops::Recognise(const std::vector<DecodedInstruction>& a_code, int a_branch, CountedLoop& a_loop)
+{
+    const DecodedInstruction& branch = a_code[a_branch];
+    if ((branch.opcode != 10 && branch.opcode != 12) || branch.operand1 < 0 || branch.operand1 >= a_branch) {
+        return false;
+    }
+    a_loop.head = branch.operand1;
+    a_loop.branch = a_branch;
+    a_loop.positive = branch.opcode == 12;
+    a_loop.targets.clear();
+
+    auto target = [&a_loop](int a_cell) -> CountedLoop::Target& {
+        for (CountedLoop::Target& existing : a_loop.targets) {
+            if (existing.cell == a_cell) {
+                return existing;
+            }
+        }
+        a_loop.targets.push_back(CountedLoop::Target());
+        a_loop.targets.back().cell = a_cell;
+        return a_loop.targets.back();
+    };
+
+    std::vector<int> sources;
+    for (int cell = a_loop.head; cell < a_branch; cell++) {
+        const DecodedInstruction& inst = a_code[cell];
+        switch (inst.opcode) {
+        case 0:
+            break;
+        case 1:  // ADD
+            target(inst.operand1).added.push_back(inst.operand2);
+            sources.push_back(inst.operand2);
+            break;
+        case 2:  // SUB
+            target(inst.operand1).subtracted.push_back(inst.operand2);
+            sources.push_back(inst.operand2);
+            break;
+        case 5:  // COPY
+            {
+                CountedLoop::Target& copy = target(inst.operand1);
+                if (copy.copied >= 0) {
+                    return false;
+                }
+                copy.copied = inst.operand2;
+                sources.push_back(inst.operand2);
+            }
+            break;
+        default:
+            return false;
+        }
+    }
+
+    for (int source : sources) {
+        for (const CountedLoop::Target& written : a_loop.targets) {
+            if (written.cell == source) {
+                return false;
+            }
+        }
+    }
+    a_loop.counter = -1;
+    for (int i = 0; i < static_cast<int>(a_loop.targets.size()); i++) {
+        const CountedLoop::Target& written = a_loop.targets[i];
+        if (written.copied >= 0 && (!written.added.empty() || !written.subtracted.empty())) {
+            return false;
+        }
+        if (written.cell == branch.operand2) {
+            a_loop.counter = i;
+        }
+    }
+    return a_loop.counter >= 0 && a_loop.targets[a_loop.counter].copied < 0;
+}
+
+/**/
+/*
+bool CountedLoops::Solve(const CountedLoop& a_loop, const EmulatorMemory& a_memory, long long& a_iterations, std::vector<long long>& a_values)
+
+NAME
+
+        CountedLoops::Solve - Computes the effect of a counted loop.
+
+SYNOPSIS
+
+        bool CountedLoops::Solve(const CountedLoop& a_loop, const EmulatorMemory& a_memory, long long& a_iterations,
+            std::vector<long long>& a_values);
+            a_loop          --> The loop, about to start at its first cell.
+            a_memory        --> Memory before the loop.
+            a_iterations    --> The number of times the body runs.
+            a_values        --> The final value of each target of the loop.
+
+DESCRIPTION
+
+        Each iteration adds the same amount d to every word the body updates: the sum of
+        the words added to it less the sum of the words subtracted, all of which stay the
+        same. The sums wrap exactly as the emulator's arithmetic does, so a word ends as its
+        start plus n times d, modulo 2 to the 64.
+
+        The loop is only solved when the counter starts strictly on the side of zero the
+        branch repeats on and d moves it towards zero. The counter then steps through
+        values that cannot overflow until the first one the branch does not repeat on, after
+        n = ceiling(|counter| / |d|) iterations. In every other case, including a counter
+        that starts on the wrong side, the loop runs normally, so the result is always what
+        iterating would give.
+
+RETURNS
+
+        Returns true if the loop was solved, false if it must be run normally.
+*/
+/**/
+bool CountedLoops::Solve(const CountedLoop& a_loop, const EmulatorMemory& a_memory, long long& a_iterations,
+    std::vector<long long>& a_values)
+{
+    auto delta = [&a_memory](const CountedLoop::Target& a_target) {
+        uint64_t sum = 0;
+        for (int source : a_target.added) {
+            sum += static_cast<uint64_t>(a_memory[source]);
+        }
+        for (int source : a_target.subtracted) {
+            sum -= static_cast<uint64_t>(a_memory[source]);
+        }
+        return sum;
+    };
+
+    const long long start = a_memory[a_loop.targets[a_loop.counter].cell];
+    const long long step = static_cast<long long>(delta(a_loop.targets[a_loop.counter]));
+    uint64_t distance, stride;
+    if (a_loop.positive && start > 0 && step < 0) {
+        distance = static_cast<uint64_t>(start);
+        stride = 0 - static_cast<uint64_t>(step);
+    }
+    else if (!a_loop.positive && start < 0 && step > 0) {
+        distance = 0 - static_cast<uint64_t>(start);
+        stride = static_cast<uint64_t>(step);
+    }
+    else {
+        return false;
+    }
+    const uint64_t iterations = distance / stride + (distance % stride != 0);
+
+    a_values.resize(a_loop.targets.size());
+    for (size_t i = 0; i < a_loop.targets.size(); i++) {
+        const CountedLoop::Target& target = a_loop.targets[i];
+        if (target.copied >= 0) {
+            a_values[i] = a_memory[target.copied];
+        }
+        else {
+            a_values[i] = static_cast<long long>(static_cast<uint64_t>(a_memory[target.cell]) + iterations * delta(target));
+        }
+    }
+    a_iterations = static_cast<long long>(iterations);
+    return true;
+}
@@ -0,0 +1,57 @@
+/*
+The CountedLoops class recognises counter loops in a verified program and runs them in closed form. A counted loop is a stretch of ADD, SUB and
+COPY instructions closed by a BP or BM back to its first cell, where every word the body reads is one the body never writes, and the word the
+branch tests is changed only by ADD and SUB. Each iteration then adds the same amount to every word the body updates and copies the same value
+into every word it copies into, so the number of iterations follows from the counter alone and the final memory from a multiplication. The
+emulator gives the first cell of each such loop its own opcode; when execution reaches it, Solve checks the conditions that can only be known
+at run time and either produces the final values or says the loop must be run normally.
+*/
+
+#ifndef _COUNTEDLOOPS_H      // UNIX way of preventing multiple inclusions.
+#define _COUNTEDLOOPS_H
+
+#include <vector>       // Vector is a container that encapsulates dynamic size arrays.
+#include "Emulator.h"   // The decoded instructions that are analysed.
+
+// Opcode of the first cell of a counted loop in the fused program. It lies above every fused opcode.
+const int COUNTED_LOOP = 200;
+
+// A loop that can be run in closed form.
+struct CountedLoop {
+
+    // A word the body writes.
+    struct Target {
+        int cell;                       // The word.
+        int copied = -1;                // The word COPY takes its value from, or -1 if ADD and SUB change it.
+        std::vector<int> added;         // Words ADD adds to it, once per instruction.
+        std::vector<int> subtracted;    // Words SUB subtracts from it, once per instruction.
+    };
+
+    int head;                           // First cell of the body, the target of the branch.
+    int branch;                         // Cell of the BP or BM that closes the loop.
+    bool positive;                      // BP: the loop repeats while the counter is positive. BM: while it is negative.
+    int counter;                        // Index in targets of the word the branch tests.
+    std::vector<Target> targets;        // Every word the body writes.
+};
+
+// CountedLoops finds counted loops and computes their effect.
+class CountedLoops {
+
+public:
+
+    // Returns the counted loops of a_code, a verified program whose branch targets are cells.
+    static std::vector<CountedLoop> Find(const std::vector<DecodedInstruction>& a_code);
+
+    // Computes the effect of running a_loop from its first cell with memory as in a_memory. Returns false if the loop
+    // must be run normally: the counter does not start on the side of zero the branch repeats on, or the body does not
+    // move it towards zero. Otherwise sets a_iterations to the number of times the body runs and a_values to the final
+    // value of each target, in the order of a_loop.targets.
+    static bool Solve(const CountedLoop& a_loop, const EmulatorMemory& a_memory, long long& a_iterations, std::vector<long long>& a_values);
+
+private:
+
+    // Fills in a_loop with the loop closed by the branch at a_branch. Returns false if it is not a counted loop.
+    static bool Recognise(const std::vector<DecodedInstruction>& a_code, int a_branch, CountedLoop& a_loop);
+};
+
+#endif
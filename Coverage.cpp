@@ -0,0 +1,105 @@
+//
+//  Implementation of source line coverage.
+//
+#include "stdafx.h"
+#include "Coverage.h"
+#include <iomanip>
+
+/**/
+/*
+Coverage::Coverage(const std::vector<int>& a_lines, const std::vector<bool>& a_instructions)
+
+NAME
+
+        Coverage::Coverage - Constructor for the Coverage class.
+
+SYNOPSIS
+
+        Coverage::Coverage(const std::vector<int>& a_lines, const std::vector<bool>& a_instructions);
+            a_lines           --> The source line of the statement in each cell of the loaded program.
+            a_instructions    --> Whether the statement in each cell is a machine instruction.
+
+DESCRIPTION
+
+        This constructor records every line that holds an instruction as not executed.
+
+*/
+/**/
+Coverage::Coverage(const std::vector<int>& a_lines, const std::vector<bool>& a_instructions)
+    : m_cellLines(a_lines.size(), 0)
+{
+    for (size_t cell = 0; cell < a_lines.size() && cell < a_instructions.size(); cell++) {
+        if (a_instructions[cell]) {
+            m_cellLines[cell] = a_lines[cell];
+            m_lines[a_lines[cell]] = false;
+        }
+    }
+}
+
+// Cells beyond the loaded program have no source line and are ignored.
+void Coverage::Attribute(const std::vector<unsigned char>& a_executed)
+{
+    for (size_t cell = 0; cell < m_cellLines.size() && cell < a_executed.size(); cell++) {
+        if (a_executed[cell] && m_cellLines[cell] != 0) {
+            m_lines[m_cellLines[cell]] = true;
+        }
+    }
+}
+
+// Counts the instruction lines that were executed.
+int Coverage::GetExecutedCount() const
+{
+    int executed = 0;
+    for (const auto& line : m_lines) {
+        executed += line.second;
+    }
+    return executed;
+}
+
+/**/
+/*
+void Coverage::WriteListing(const std::vector<std::string>& a_source, std::ostream& a_out) const
+
+NAME
+
+        Coverage::WriteListing - Writes the source annotated with its coverage.
+
+SYNOPSIS
+
+        void Coverage::WriteListing(const std::vector<std::string>& a_source, std::ostream& a_out) const;
+            a_source    --> The lines of the source file.
+            a_out       --> The stream to write to.
+
+DESCRIPTION
+
+        This method writes each source line after a column that holds "+" for an executed
+        instruction, "#####" for an instruction that never ran, and "-" for a line with no
+        instruction, then the line number, in the manner of gcov. A summary of the lines
+        executed follows.
+
+*/
+/**/
+void Coverage::WriteListing(const std::vector<std::string>& a_source, std::ostream& a_out) const
+{
+    for (size_t i = 0; i < a_source.size(); i++) {
+        const auto line = m_lines.find(static_cast<int>(i + 1));
+        const char* mark = line == m_lines.end() ? "-" : line->second ? "+" : "#####";
+        a_out << std::setfill(' ') << std::setw(9) << mark << ":" << std::setw(5) << i + 1 << ":" << a_source[i] << std::endl;
+    }
+    const int executed = GetExecutedCount();
+    a_out << "Lines executed: " << std::fixed << std::setprecision(2)
+        << (m_lines.empty() ? 0.0 : 100.0 * executed / m_lines.size()) << "% of " << m_lines.size() << std::endl;
+}
+
+// One record: the source file, a DA line per instruction line, and the totals.
+void Coverage::WriteLcov(const std::string& a_sourceFile, std::ostream& a_out) const
+{
+    a_out << "TN:" << std::endl;
+    a_out << "SF:" << a_sourceFile << std::endl;
+    for (const auto& line : m_lines) {
+        a_out << "DA:" << line.first << "," << (line.second ? 1 : 0) << std::endl;
+    }
+    a_out << "LF:" << m_lines.size() << std::endl;
+    a_out << "LH:" << GetExecutedCount() << std::endl;
+    a_out << "end_of_record" << std::endl;
+}
@@ -0,0 +1,44 @@
+/*
+The Coverage class turns the per-cell execution marks collected by the emulator into line coverage of the assembler source. Each memory cell of the
+loaded program holds one statement, so the mark of a cell is the mark of the source line that statement came from. Only lines holding machine
+instructions count; comments, storage and the other directives are neither covered nor uncovered. The result can be written as an annotated copy of
+the source or in the LCOV tracefile format read by genhtml and most CI coverage tools.
+*/
+
+#ifndef _COVERAGE_H      // UNIX way of preventing multiple inclusions.
+#define _COVERAGE_H
+
+#include <iostream> // Reports are written to a stream.
+#include <map>      // Lines ordered by number.
+#include <string>   // For string objects
+#include <vector>   // Vector is a container that encapsulates dynamic size arrays.
+
+// Coverage maps executed cells to executed source lines.
+class Coverage {
+
+public:
+
+    // Constructor. a_lines holds the source line number of the statement in each memory cell of the loaded program,
+    // and a_instructions whether that statement is a machine instruction.
+    Coverage(const std::vector<int>& a_lines, const std::vector<bool>& a_instructions);
+
+    // Marks the source line of every cell a_executed says was executed.
+    void Attribute(const std::vector<unsigned char>& a_executed);
+
+    // Writes a_source, one string per line, with each instruction line marked as executed or not, then a summary.
+    void WriteListing(const std::vector<std::string>& a_source, std::ostream& a_out) const;
+
+    // Writes the coverage as an LCOV tracefile record for the source file a_sourceFile.
+    void WriteLcov(const std::string& a_sourceFile, std::ostream& a_out) const;
+
+    // Returns the number of instruction lines, and the number of them that were executed.
+    int GetLineCount() const { return static_cast<int>(m_lines.size()); }
+    int GetExecutedCount() const;
+
+private:
+
+    std::vector<int> m_cellLines;       // Source line of each cell holding an instruction, or 0.
+    std::map<int, bool> m_lines;        // Each instruction line and whether it was executed.
+};
+
+#endif
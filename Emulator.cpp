@@ -1,155 +1,1668 @@
-#include "emulator.h"
-#include "stdafx.h"
-
-/**/
-/*
-bool emulator::insertMemory(int a_location, long long a_contents)
-
-NAME
-
-        emulator::insertMemory - Records instructions and data into simulated memory.
-
-SYNOPSIS
-
-        bool emulator::insertMemory(int a_location, long long a_contents);
-            a_location    --> The memory location where the data or instruction is to be stored.
-            a_contents    --> The data or instruction to be stored.
-
-DESCRIPTION
-
-        This method stores a given data or instruction (a_contents) into the simulated memory
-        at the specified location (a_location). If the location is out of bounds (less than
-        zero or greater than or equal to MEMSZ), the method returns false without modifying
-        the memory. If the location is valid, the method stores the contents at that location
-        and returns true.
-
-RETURNS
-
-        Returns true if the operation was successful, and false otherwise.
-*/
-/**/
-// Records instructions and data into simulated memory.
-bool emulator::insertMemory(int a_location, long long a_contents)
-{
-    if (a_location < 0 || a_location >= MEMSZ)
-    {
-        // Invalid memory location
-        return false;
-    }
-    m_memory[a_location] = a_contents;
-    return true;
-}
-
-/**/
-/*
-bool emulator::runProgram()
-
-NAME
-
-        emulator::runProgram - Runs the program recorded in memory.
-
-SYNOPSIS
-
-        bool emulator::runProgram();
-
-DESCRIPTION
-
-        This method executes the program stored in the simulated memory. It interprets and
-        executes each instruction sequentially, based on its opcode and operands. The
-        execution begins from the location 100 and continues until a HALT instruction (opcode
-        13) is encountered or all instructions in memory are executed.
-
-        The method handles a variety of operations including arithmetic, data transfer,
-        input/output, and control operations. If a division by zero is attempted, the method
-        returns false. Otherwise, the method returns true upon successful execution.
-
-RETURNS
-
-        Returns true if the program executes successfully, and false otherwise.
-
-AUTHOR
-
-        Sikander Raja
-
-*/
-/**/
-
-// Runs the program recorded in memory.
-bool emulator::runProgram()
-{
-    int loc = 100;  // First instruction location is assumed to be 100 as per your instructions
-    while (loc <= m_memory.size())  // Consider the provided location in the machine code
-    {
-        long long val = m_memory[loc - 100];  // Adjusted for zero-based indexing
-        int opcode = (val / 10000000000) % 100;
-        int operand1 = (val % 100000000) / 100000;
-        int operand2 = val % 100000;
-
-        switch (opcode)
-        {
-        case 0:  // No-op
-            break;
-        case 1:  // ADD
-            m_memory[operand1] += m_memory[operand2];
-            break;
-        case 2:  // SUB
-            m_memory[operand1] -= m_memory[operand2];
-            break;
-        case 3:  // MULT
-            m_memory[operand1] *= m_memory[operand2];
-            break;
-        case 4:  // DIV
-            if (m_memory[operand2] != 0)
-            {
-                m_memory[operand1] /= m_memory[operand2];
-            }
-            else
-            {
-                // Error - division by zero
-                return false;
-            }
-            break;
-        case 5:  // COPY
-            m_memory[operand1] = m_memory[operand2];
-            break;
-        case 7:  // READ
-            long long userInput;
-            cout << "? ";
-            cin >> userInput;
-            m_memory[operand1] = userInput;
-            break;
-        case 8:  // WRITE
-            cout << m_memory[operand1] << endl;
-            break;
-        case 9:  // BRANCH
-            loc = operand1;
-            continue;
-        case 10:  // BRANCH MINUS
-            if (m_memory[operand2] < 0)
-            {
-                loc = operand1;
-                continue;
-            }
-            break;
-        case 11:  // BRANCH ZERO
-            if (m_memory[operand2] == 0)
-            {
-                loc = operand1;
-                continue;
-            }
-            break;
-        case 12:  // BRANCH POSITIVE
-            if (m_memory[operand2] > 0)
-            {
-                loc = operand1;
-                continue;
-            }
-            break;
-        case 13:  // HALT
-            return true;
-        }
-        loc++;
-    }
-    return true;
-}
-
+#include "emulator.h"
+#include "stdafx.h"
+#include "CountedLoops.h"
+#include "Fusion.h"
+#include "Isa.h"
+#include "Jit.h"
+#include "Verifier.h"
+#include <algorithm>
+#include <chrono>
+
+/**/
+/*
+bool emulator::insertMemory(int a_location, long long a_contents)
+
+NAME
+
+        emulator::insertMemory - Records instructions and data into simulated memory.
+
+SYNOPSIS
+
+        bool emulator::insertMemory(int a_location, long long a_contents);
+            a_location    --> The memory location where the data or instruction is to be stored.
+            a_contents    --> The data or instruction to be stored.
+
+DESCRIPTION
+
+        This method stores a given data or instruction (a_contents) into the simulated memory
+        at the specified location (a_location). If the location is out of bounds (less than
+        zero or greater than or equal to MEMSZ), the method returns false without modifying
+        the memory. If the location is valid, the method stores the contents at that location
+        and returns true.
+
+RETURNS
+
+        Returns true if the operation was successful, and false otherwise.
+*/
+/**/
+// Records instructions and data into simulated memory.
+bool emulator::insertMemory(int a_location, long long a_contents)
+{
+    if (a_location < 0 || a_location >= MEMSZ)
+    {
+        // Invalid memory location
+        return false;
+    }
+    m_memory.Store(a_location, a_contents);
+    MarkDirty(a_location);
+    if (a_location >= m_loadedLimit)
+    {
+        m_loadedLimit = a_location + 1;
+    }
+    return true;
+}
+
+/**/
+/*
+void emulator::TakeSnapshot()
+
+NAME
+
+        emulator::TakeSnapshot - Saves the contents of memory.
+
+SYNOPSIS
+
+        void emulator::TakeSnapshot();
+
+DESCRIPTION
+
+        This method copies the whole of memory, and the extent of the loaded program, so
+        that Restore can later return the emulator to this state. Every page is marked
+        clean. Taking the snapshot costs one full copy of memory; it is meant to be done
+        once, after loading, before a series of runs of the same image. The snapshot is
+        never modified, so copies of the emulator share it.
+
+*/
+/**/
+void emulator::TakeSnapshot()
+{
+    m_snapshot = std::make_shared<const EmulatorMemory>(m_memory);
+    m_snapshotLoadedLimit = m_loadedLimit;
+    std::fill(m_dirty.begin(), m_dirty.end(), 0);
+}
+
+/**/
+/*
+bool emulator::Restore()
+
+NAME
+
+        emulator::Restore - Returns memory to the last snapshot.
+
+SYNOPSIS
+
+        bool emulator::Restore();
+
+DESCRIPTION
+
+        This method walks the dirty-page map and copies back from the snapshot only the
+        pages that have been written since the snapshot was taken or last restored, then
+        marks them clean. The next call to Run starts the program afresh. A short run
+        touches a handful of pages, so resetting between runs costs a few kilobytes of
+        copying instead of a new 800 KB emulator. With the sparse backend a page the
+        snapshot never wrote is released again.
+
+RETURNS
+
+        Returns true if memory was restored, or false if there is no snapshot.
+*/
+/**/
+bool emulator::Restore()
+{
+    if (m_snapshot == nullptr)
+    {
+        return false;
+    }
+    for (int page = 0; page < PAGES; page++)
+    {
+        if (m_dirty[page])
+        {
+            m_memory.CopyPage(page, *m_snapshot);
+        }
+    }
+    std::fill(m_dirty.begin(), m_dirty.end(), 0);
+    m_loadedLimit = m_snapshotLoadedLimit;
+    ResetRun();
+    return true;
+}
+
+/**/
+/*
+DecodedInstruction emulator::Decode(long long a_contents)
+
+NAME
+
+        emulator::Decode - Splits a machine word into its fields.
+
+SYNOPSIS
+
+        DecodedInstruction emulator::Decode(long long a_contents);
+            a_contents    --> The packed machine word as stored in memory.
+
+DESCRIPTION
+
+        This method extracts the opcode and the two address fields from a machine word,
+        using the same digit positions the assembler writes them in.
+
+RETURNS
+
+        Returns the decoded instruction.
+*/
+/**/
+DecodedInstruction emulator::Decode(long long a_contents)
+{
+    DecodedInstruction inst;
+    inst.opcode = static_cast<int>((a_contents / 10000000000) % 100);
+    inst.operand1 = static_cast<int>((a_contents % 100000000) / 100000);
+    inst.operand2 = static_cast<int>(a_contents % 100000);
+    return inst;
+}
+
+/**/
+/*
+void emulator::PreDecode()
+
+NAME
+
+        emulator::PreDecode - Decodes the loaded program ahead of execution.
+
+SYNOPSIS
+
+        void emulator::PreDecode();
+
+DESCRIPTION
+
+        This method decodes every cell that insertMemory has loaded into m_decoded, so that
+        runProgram can fetch instructions without any divisions. Cells above the loaded range
+        are not pre-decoded; runProgram decodes them on the fly if execution ever reaches them.
+        Writes into the pre-decoded range go through StoreMemory, which keeps m_decoded current
+        when a program modifies its own code. With pre-decoding turned off nothing is decoded
+        here, so every fetch is decoded on the fly.
+*/
+/**/
+void emulator::PreDecode()
+{
+    m_codeLimit = m_preDecoding ? m_loadedLimit : 0;
+    m_decoded.resize(m_codeLimit);
+    for (int i = 0; i < m_codeLimit; i++)
+    {
+        m_decoded[i] = Decode(m_memory[i]);
+    }
+}
+
+/**/
+/*
+void emulator::RedecodeCell(int a_location, long long a_value)
+
+NAME
+
+        emulator::RedecodeCell - Refreshes a pre-decoded cell after a write.
+
+SYNOPSIS
+
+        void emulator::RedecodeCell(int a_location, long long a_value);
+            a_location    --> The cell that was written. It must be below m_codeLimit.
+            a_value       --> The new contents of the cell.
+
+DESCRIPTION
+
+        This method updates m_decoded for a cell that a program has overwritten and, while
+        the threaded engine is running, points the cell's handler at the one for its new
+        opcode. While the JIT engine is running, compiled blocks covering the cell are dropped.
+        It is kept out of line because programs rarely write into their own code.
+*/
+/**/
+void emulator::RedecodeCell(int a_location, long long a_value)
+{
+    m_decoded[a_location] = Decode(a_value);
+    if (m_threadedTable != nullptr)
+    {
+        m_threaded[a_location] = m_threadedTable[m_decoded[a_location].opcode];
+    }
+    if (m_jit != nullptr)
+    {
+        m_jit->InvalidateCell(a_location);
+    }
+}
+
+/**/
+/*
+bool emulator::runProgram()
+
+NAME
+
+        emulator::runProgram - Runs the program recorded in memory.
+
+SYNOPSIS
+
+        bool emulator::runProgram();
+
+DESCRIPTION
+
+        This method executes the program stored in the simulated memory. It interprets and
+        executes each instruction sequentially, based on its opcode and operands. The
+        execution begins from the location 100 and continues until a HALT instruction (opcode
+        13) is encountered or all instructions in memory are executed.
+
+        The method handles a variety of operations including arithmetic, data transfer,
+        input/output, and control operations. If a division by zero is attempted, or READ
+        finds its input device exhausted, the method returns false. Otherwise, the method
+        returns true upon successful execution. READ and WRITE go through the devices set
+        with SetDevices, and the output device is flushed before the method returns.
+
+        The loaded program is decoded once by PreDecode before the loop starts, so each
+        step only indexes m_decoded instead of taking the machine word apart again. A branch
+        to a location below 100 is reported as a failure. The work is done by the engine
+        chosen with SetEngine: the switch engine by default, RunThreaded or RunJit. A run
+        with profiling, tracing or breakpoints always uses the switch engine.
+
+        The switch engine is RunLoop, a template over compile-time policies. Which of its
+        instantiations runs is decided once, here, from the settings of the emulator: a
+        program the verifier passed runs unchecked, and only the instrumentation that is
+        turned on is compiled into the loop, so a plain run tests no flags at all.
+
+        Unless it has been turned off with SetVerifying, the verifier checks the decoded
+        program first.
+
+        When the emulator is built with VC_STATS every engine counts the instructions it
+        retires into m_stats, and the wall-clock time of the run is recorded there too.
+
+RETURNS
+
+        Returns true if the program executes successfully, and false otherwise.
+
+AUTHOR
+
+        Sikander Raja
+
+*/
+/**/
+
+// Runs the program recorded in memory.
+bool emulator::runProgram()
+{
+    PreDecode();
+    VerifyProgram();
+
+#ifdef VC_STATS
+    m_stats.Reset();
+    auto start = std::chrono::steady_clock::now();
+#endif
+    bool result = RunEngine();
+    m_output->Flush();
+#ifdef VC_STATS
+    m_stats.SetSeconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+#endif
+    return result;
+}
+
+// Runs the program with the engine selected by SetEngine.
+bool emulator::RunEngine()
+{
+    const bool instrumented = m_profiling || m_covering || m_trace != nullptr || HasBreakpoints();
+    if (!instrumented && m_engine == ENGINE_THREADED)
+    {
+        return RunThreaded();
+    }
+    if (!instrumented && m_engine == ENGINE_JIT)
+    {
+        return RunJit();
+    }
+
+    // The switch engine: pick the one instantiation of RunLoop that fits this run
+    if (m_profiling)
+    {
+        m_profile.assign(MEMSZ, 0);
+    }
+    if (m_covering)
+    {
+        m_coverage.assign(MEMSZ, 0);
+    }
+    if (instrumented)
+    {
+        const bool result = m_verified ? RunInstrumented<false>() : RunInstrumented<true>();
+        if (m_covering && m_profiling)
+        {
+            for (int cell = 0; cell < MEMSZ; cell++)
+            {
+                m_coverage[cell] = m_profile[cell] != 0;
+            }
+        }
+        return result;
+    }
+    return m_verified ? RunProduction<false>() : RunProduction<true>();
+}
+
+/**/
+/*
+emulator::RunStatus emulator::Run(long long a_budget)
+
+NAME
+
+        emulator::Run - Runs the program for a limited number of instructions.
+
+SYNOPSIS
+
+        emulator::RunStatus emulator::Run(long long a_budget);
+            a_budget    --> The most instructions to execute in this call.
+
+DESCRIPTION
+
+        This method is the resumable form of runProgram. The first call decodes the
+        program and starts it at location 100; every later call carries on from the cell
+        where the previous one stopped, until ResetRun or Restore starts it over. Each call
+        executes at most a_budget instructions on the switch engine, which lets a scheduler
+        share a thread between many emulators and stop one that never halts. The steps are
+        run by RunBudgeted with the same tracing, profiling, coverage and breakpoints as
+        runProgram would use; the profile and coverage are cleared when the program starts
+        and cover every call since.
+
+        A READ whose input device would block, or a WRITE whose output device is full, is
+        not executed: Run returns STATUS_WAITING and the instruction is retried by the next
+        call. Once the program has halted or faulted
+        further calls return the same status without executing anything. The output device
+        is flushed before every return.
+
+RETURNS
+
+        Returns STATUS_HALTED, STATUS_BUDGET, STATUS_WAITING or STATUS_FAULTED.
+*/
+/**/
+emulator::RunStatus emulator::Run(long long a_budget)
+{
+    if (!m_runStarted)
+    {
+        PreDecode();
+        m_runStarted = true;
+        m_runCell = 0;
+        m_runStatus = STATUS_BUDGET;
+        m_retired = 0;
+#ifdef VC_STATS
+        m_stats.Reset();
+#endif
+        if (m_profiling)
+        {
+            m_profile.assign(MEMSZ, 0);
+        }
+        if (m_covering)
+        {
+            m_coverage.assign(MEMSZ, 0);
+        }
+    }
+    if (m_runStatus == STATUS_HALTED || m_runStatus == STATUS_FAULTED)
+    {
+        return m_runStatus;
+    }
+
+    RunBudgeted(a_budget);
+    m_output->Flush();
+    return m_runStatus;
+}
+
+// Unlike RunEngine, coverage is marked even with a profile, since it would have to be copied from the profile after every call.
+void emulator::RunBudgeted(long long a_budget)
+{
+    const int choice = (m_covering ? 8 : 0) | (m_trace != nullptr ? 4 : 0) | (m_profiling ? 2 : 0) | (HasBreakpoints() ? 1 : 0);
+    switch (choice)
+    {
+    case 0:
+        RunLoop<RunPolicy<true, false, false, false, false, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 1:
+        RunLoop<RunPolicy<true, false, false, true, false, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 2:
+        RunLoop<RunPolicy<true, false, true, false, false, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 3:
+        RunLoop<RunPolicy<true, false, true, true, false, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 4:
+        RunLoop<RunPolicy<true, true, false, false, false, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 5:
+        RunLoop<RunPolicy<true, true, false, true, false, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 6:
+        RunLoop<RunPolicy<true, true, true, false, false, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 7:
+        RunLoop<RunPolicy<true, true, true, true, false, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 8:
+        RunLoop<RunPolicy<true, false, false, false, true, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 9:
+        RunLoop<RunPolicy<true, false, false, true, true, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 10:
+        RunLoop<RunPolicy<true, false, true, false, true, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 11:
+        RunLoop<RunPolicy<true, false, true, true, true, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 12:
+        RunLoop<RunPolicy<true, true, false, false, true, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 13:
+        RunLoop<RunPolicy<true, true, false, true, true, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 14:
+        RunLoop<RunPolicy<true, true, true, false, true, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    case 15:
+        RunLoop<RunPolicy<true, true, true, true, true, InputDevice, OutputDevice, true>>(m_runCell, a_budget);
+        break;
+    }
+}
+
+// Moves a started run to another position. The run is no longer halted or faulted.
+void emulator::SetRunPosition(int a_location, long long a_retired)
+{
+    m_runCell = a_location - 100;
+    m_retired = a_retired;
+    m_runStatus = STATUS_BUDGET;
+}
+
+/**/
+/*
+bool emulator::RunSwitch(int a_loc)
+
+NAME
+
+        emulator::RunSwitch - Runs the program with the switch engine.
+
+SYNOPSIS
+
+        bool emulator::RunSwitch(int a_loc);
+            a_loc    --> The location of the first instruction to execute.
+
+DESCRIPTION
+
+        This method executes instructions from a_loc until HALT, a fault, or the end of
+        memory with the checked, uninstrumented instantiation of RunLoop. It handles every
+        location, so the other engines hand over to it when they reach code they do not
+        cover.
+
+RETURNS
+
+        Returns true if the program executes successfully, and false otherwise.
+*/
+/**/
+bool emulator::RunSwitch(int a_loc)
+{
+    return RunLoop<RunPolicy<true, false, false, false, false, InputDevice, OutputDevice>>(a_loc - 100);
+}
+
+/**/
+/*
+void emulator::VerifyProgram()
+
+NAME
+
+        emulator::VerifyProgram - Runs the load-time verifier.
+
+SYNOPSIS
+
+        void emulator::VerifyProgram();
+
+DESCRIPTION
+
+        This method passes the decoded program to the Verifier, with location 100 as the
+        entry point. If the program passes, its rebased copy is kept in m_verifiedCode for
+        the unchecked RunLoop; otherwise the reason is kept for GetVerifierReport. Nothing is verified
+        when verification or pre-decoding has been turned off.
+
+        A verified program cannot change its code, so it is also run through the
+        superinstruction pass here, limited by the fusion profile if one was given. The
+        fused copy is kept in m_fusedCode, which the uninstrumented unchecked loop runs.
+        Unless acceleration has been turned off, the first cell of each counted loop is then
+        given the COUNTED_LOOP opcode there, so that the loop can be run in closed form.
+
+*/
+/**/
+void emulator::VerifyProgram()
+{
+    m_verified = false;
+    m_verifierReport.clear();
+    m_verifiedCode.clear();
+    m_fusedCode.clear();
+    m_fusedCount = 0;
+    m_countedLoops.reset();
+    m_skippedIterations = 0;
+    if (!m_verifying || !m_preDecoding)
+    {
+        return;
+    }
+
+    VerifiedProgram program = Verifier::Verify(m_decoded, 0, MEMSZ);
+    m_verified = program.verified;
+    m_entry = program.entry;
+    m_verifierReport = program.reason;
+    m_verifiedCode = std::move(program.code);
+
+    m_fusedCode.clear();
+    m_fusedCount = 0;
+    if (m_verified)
+    {
+        m_fusedCode = m_fusing ? Fusion::Apply(m_verifiedCode, m_fusionProfile.empty() ? nullptr : &m_fusionProfile, m_fusionThreshold) : m_verifiedCode;
+        for (const DecodedInstruction& inst : m_fusedCode)
+        {
+            m_fusedCount += inst.opcode >= FUSED_SUB_BZ;
+        }
+        if (m_accelerating)
+        {
+            // The first cell of each counted loop keeps the index of the loop in its second operand
+            std::vector<CountedLoop> loops = CountedLoops::Find(m_verifiedCode);
+            for (size_t i = 0; i < loops.size(); i++)
+            {
+                m_fusedCode[loops[i].head].opcode = COUNTED_LOOP;
+                m_fusedCode[loops[i].head].operand2 = static_cast<int>(i);
+            }
+            m_countedLoops = std::make_shared<const std::vector<CountedLoop>>(std::move(loops));
+        }
+    }
+}
+
+// The loops are only known once the program has been verified.
+int emulator::GetCountedLoopCount() const
+{
+    return m_countedLoops ? static_cast<int>(m_countedLoops->size()) : 0;
+}
+
+/**/
+/*
+template <class Policy> bool emulator::RunLoop(int a_cell, long long a_budget)
+
+NAME
+
+        emulator::RunLoop - The switch engine, specialised for a set of policies.
+
+SYNOPSIS
+
+        template <class Policy> bool emulator::RunLoop(int a_cell, long long a_budget = 0);
+            Policy    --> A RunPolicy saying which checks and instrumentation to compile in.
+            a_cell    --> The cell of the first instruction to execute.
+            a_budget  --> The most instructions to execute, if Policy is budgeted.
+
+DESCRIPTION
+
+        This method executes instructions from a_cell until HALT or a fault, selecting the
+        operation for each step with a single switch statement. Every policy is tested with
+        if constexpr, so an instantiation only contains the code of the policies it turns on:
+
+            checked        fetches from m_decoded, decoding cells above it on the fly, stops
+                           at the end of memory or a branch below 100, and keeps the decoded
+                           code current when it is written. Without it the loop fetches from
+                           m_verifiedCode, whose branch targets are already cells, and does
+                           none of that; only verified programs run unchecked.
+            trace          passes every instruction to the trace sink before it executes,
+                           and every word stored as it is stored.
+            profile        counts the executions of each cell in m_profile.
+            coverage       marks each cell executed in m_coverage, with a single store.
+            breakpoints    calls the breakpoint handler at each breakpoint.
+            stats          counts into m_stats; set in builds with VC_STATS.
+            Input, Output  the types the devices are called through. When they are the final
+                           TapeInput and BufferedOutput classes READ and WRITE are direct calls.
+            budgeted       stops once a_budget instructions have executed, or before a READ
+                           or WRITE that would block, which is neither executed nor passed
+                           to the instrumentation until it is retried. Wherever it stops,
+                           the cell to continue from and the status are left in m_runCell
+                           and m_runStatus, and the instructions executed are added to
+                           m_retired. Run uses it, so a run in slices is instrumented the
+                           same way as runProgram.
+            fused          set for the unchecked loop without instrumentation or budget; it
+                           runs m_fusedCode and handles the fused opcodes with RunFused and
+                           the first cells of counted loops with CountedLoops::Solve.
+
+        Without a budget, a device that would block is treated as a failure, since only Run
+        can wait.
+
+RETURNS
+
+        Returns true if the program executes successfully, and false if it faults or a
+        breakpoint handler stops it.
+*/
+/**/
+template <class Policy>
+bool emulator::RunLoop(int a_cell, long long a_budget)
+{
+    const DecodedInstruction* code = Policy::fused ? m_fusedCode.data() : Policy::checked ? m_decoded.data() : m_verifiedCode.data();
+    typename Policy::Input& input = static_cast<typename Policy::Input&>(*m_input);
+    typename Policy::Output& output = static_cast<typename Policy::Output&>(*m_output);
+
+    // Stores go through StoreMemory only when the code may be written.
+    auto store = [this](int a_location, long long a_value) {
+        if constexpr (Policy::trace)
+        {
+            m_trace->Store(a_location, m_memory[a_location], a_value);
+        }
+        if constexpr (Policy::checked)
+        {
+            StoreMemory(a_location, a_value);
+        }
+        else
+        {
+            StoreData(a_location, a_value);
+        }
+    };
+
+    // Ends the loop. A budgeted loop also records where it stopped for Run.
+    long long executed = 0;
+    auto stop = [&](RunStatus a_status, int a_next) {
+        if constexpr (Policy::budgeted)
+        {
+            m_runCell = a_next;
+            m_runStatus = a_status;
+            m_retired += executed;
+        }
+        return a_status != STATUS_FAULTED;
+    };
+
+    int cell = a_cell;
+    for (;;)
+    {
+        if constexpr (Policy::checked)
+        {
+            if (static_cast<unsigned>(cell) > MEMSZ - 100)
+            {
+                // Past the end of memory the program is over; a branch below 100 is an error
+                return stop(cell >= 0 ? STATUS_HALTED : STATUS_FAULTED, cell);
+            }
+        }
+        const DecodedInstruction inst = Policy::checked && cell >= m_codeLimit ? Decode(m_memory[cell]) : code[cell];
+        const int operand1 = inst.operand1;
+        const int operand2 = inst.operand2;
+        const int target = Policy::checked ? operand1 - 100 : operand1;
+
+        if constexpr (Policy::budgeted)
+        {
+            if (executed == a_budget)
+            {
+                return stop(STATUS_BUDGET, cell);
+            }
+            if ((inst.opcode == 7 && input.WouldBlock()) || (inst.opcode == 8 && output.IsFull()))
+            {
+                return stop(STATUS_WAITING, cell);
+            }
+        }
+        if constexpr (Policy::breakpoints)
+        {
+            if (m_breakpoints[cell] && !m_breakHandler(cell + 100))
+            {
+                return stop(STATUS_FAULTED, STEP_FAULT);
+            }
+        }
+        if constexpr (Policy::budgeted)
+        {
+            executed++;
+        }
+        if constexpr (Policy::profile)
+        {
+            m_profile[cell]++;
+        }
+        if constexpr (Policy::coverage)
+        {
+            m_coverage[cell] = 1;
+        }
+        if constexpr (Policy::trace)
+        {
+            m_trace->Step(cell + 100, Policy::checked ? inst : m_decoded[cell]);
+        }
+        if constexpr (Policy::stats)
+        {
+            VC_STATS_COUNT(inst);
+        }
+
+        switch (inst.opcode)
+        {
+        case 1:  // ADD
+            store(operand1, m_memory[operand1] + m_memory[operand2]);
+            break;
+        case 2:  // SUB
+            store(operand1, m_memory[operand1] - m_memory[operand2]);
+            break;
+        case 3:  // MULT
+            store(operand1, m_memory[operand1] * m_memory[operand2]);
+            break;
+        case 4:  // DIV
+            if (m_memory[operand2] == 0)
+            {
+                // Error - division by zero
+                return stop(STATUS_FAULTED, STEP_FAULT);
+            }
+            store(operand1, m_memory[operand1] / m_memory[operand2]);
+            break;
+        case 5:  // COPY
+            store(operand1, m_memory[operand2]);
+            break;
+        case 7:  // READ
+            long long userInput;
+            if (input.WouldBlock() || !input.Read(userInput))
+            {
+                // Error - no more input
+                return stop(STATUS_FAULTED, STEP_FAULT);
+            }
+            store(operand1, userInput);
+            break;
+        case 8:  // WRITE
+            if (output.IsFull())
+            {
+                // Error - no room for output
+                return stop(STATUS_FAULTED, STEP_FAULT);
+            }
+            output.Write(m_memory[operand1]);
+            break;
+        case 9:  // BRANCH
+            cell = target;
+            continue;
+        case 10:  // BRANCH MINUS
+            if (m_memory[operand2] < 0)
+            {
+                cell = target;
+                continue;
+            }
+            break;
+        case 11:  // BRANCH ZERO
+            if (m_memory[operand2] == 0)
+            {
+                cell = target;
+                continue;
+            }
+            break;
+        case 12:  // BRANCH POSITIVE
+            if (m_memory[operand2] > 0)
+            {
+                cell = target;
+                continue;
+            }
+            break;
+        case 13:  // HALT
+            return stop(STATUS_HALTED, STEP_HALT);
+        case FUSED_SUB_BZ:
+            if constexpr (Policy::fused)
+            {
+                cell = RunFused<2, 0, 11, true>(code, cell);
+                continue;
+            }
+            break;
+        case FUSED_SUB_BM:
+            if constexpr (Policy::fused)
+            {
+                cell = RunFused<2, 0, 10, true>(code, cell);
+                continue;
+            }
+            break;
+        case FUSED_SUB_BP:
+            if constexpr (Policy::fused)
+            {
+                cell = RunFused<2, 0, 12, true>(code, cell);
+                continue;
+            }
+            break;
+        case FUSED_ADD_BZ:
+            if constexpr (Policy::fused)
+            {
+                cell = RunFused<1, 0, 11, true>(code, cell);
+                continue;
+            }
+            break;
+        case FUSED_ADD_BM:
+            if constexpr (Policy::fused)
+            {
+                cell = RunFused<1, 0, 10, true>(code, cell);
+                continue;
+            }
+            break;
+        case FUSED_ADD_BP:
+            if constexpr (Policy::fused)
+            {
+                cell = RunFused<1, 0, 12, true>(code, cell);
+                continue;
+            }
+            break;
+        case FUSED_ADD_B:
+            if constexpr (Policy::fused)
+            {
+                cell = RunFused<1, 0, 9, false>(code, cell);
+                continue;
+            }
+            break;
+        case FUSED_SUB_B:
+            if constexpr (Policy::fused)
+            {
+                cell = RunFused<2, 0, 9, false>(code, cell);
+                continue;
+            }
+            break;
+        case FUSED_COPY_B:
+            if constexpr (Policy::fused)
+            {
+                cell = RunFused<5, 0, 9, false>(code, cell);
+                continue;
+            }
+            break;
+        case FUSED_COPY_BM:
+            if constexpr (Policy::fused)
+            {
+                cell = RunFused<5, 0, 10, false>(code, cell);
+                continue;
+            }
+            break;
+        case FUSED_COPY_BZ:
+            if constexpr (Policy::fused)
+            {
+                cell = RunFused<5, 0, 11, false>(code, cell);
+                continue;
+            }
+            break;
+        case FUSED_COPY_BP:
+            if constexpr (Policy::fused)
+            {
+                cell = RunFused<5, 0, 12, false>(code, cell);
+                continue;
+            }
+            break;
+        case FUSED_ADD_SUB_BZ:
+            if constexpr (Policy::fused)
+            {
+                cell = RunFused<1, 2, 11, true>(code, cell);
+                continue;
+            }
+            break;
+        case FUSED_ADD_SUB_BP:
+            if constexpr (Policy::fused)
+            {
+                cell = RunFused<1, 2, 12, true>(code, cell);
+                continue;
+            }
+            break;
+        case COUNTED_LOOP:
+            if constexpr (Policy::fused)
+            {
+                const CountedLoop& loop = (*m_countedLoops)[operand2];
+                long long iterations;
+                if (CountedLoops::Solve(loop, m_memory, iterations, m_loopValues))
+                {
+                    for (size_t i = 0; i < loop.targets.size(); i++)
+                    {
+                        StoreData(loop.targets[i].cell, m_loopValues[i]);
+                    }
+                    m_skippedIterations += iterations;
+                    cell = loop.branch + 1;
+                }
+                else
+                {
+                    // The loop cannot be solved this time: execute its first instruction and iterate
+                    cell = ExecuteOne(cell);
+                }
+                continue;
+            }
+            break;
+        }
+        cell++;
+    }
+}
+
+/**/
+/*
+template <int FIRST, int SECOND, int BRANCH, bool SAME> int emulator::RunFused(const DecodedInstruction* a_code, int a_cell)
+
+NAME
+
+        emulator::RunFused - Executes a superinstruction.
+
+SYNOPSIS
+
+        template <int FIRST, int SECOND, int BRANCH, bool SAME> int emulator::RunFused(const DecodedInstruction* a_code, int a_cell);
+            FIRST, SECOND    --> The data instructions of the sequence; SECOND is 0 for a pair.
+            BRANCH           --> The branch that ends the sequence.
+            SAME             --> True if the branch tests the word stored just before it.
+            a_code           --> The fused program.
+            a_cell           --> The first cell of the sequence.
+
+DESCRIPTION
+
+        This method is the handler of every fused opcode. The opcodes are template arguments,
+        so each instantiation is straight-line code; the operands are read from the cells of
+        the sequence, which the fusion pass leaves as they were. When SAME is set the branch
+        tests the value just computed instead of loading it back from memory.
+
+RETURNS
+
+        Returns the cell of the next instruction.
+*/
+/**/
+template <int FIRST, int SECOND, int BRANCH, bool SAME>
+VC_FORCEINLINE int emulator::RunFused(const DecodedInstruction* a_code, int a_cell)
+{
+    int cell = a_cell;
+    long long value = Compute<FIRST>(a_code[cell]);
+    StoreData(a_code[cell].operand1, value);
+    cell++;
+    if constexpr (SECOND != 0)
+    {
+        value = Compute<SECOND>(a_code[cell]);
+        StoreData(a_code[cell].operand1, value);
+        cell++;
+    }
+
+    const DecodedInstruction& branch = a_code[cell];
+    if constexpr (BRANCH == 9)
+    {
+        return branch.operand1;
+    }
+    else
+    {
+        const long long tested = SAME ? value : m_memory[branch.operand2];
+        const bool taken = BRANCH == 10 ? tested < 0 : BRANCH == 11 ? tested == 0 : tested > 0;
+        return taken ? branch.operand1 : cell + 1;
+    }
+}
+
+/**/
+/*
+int emulator::ExecuteFused(int a_cell)
+
+NAME
+
+        emulator::ExecuteFused - Executes one superinstruction on its own.
+
+SYNOPSIS
+
+        int emulator::ExecuteFused(int a_cell);
+            a_cell    --> The first cell of the fused sequence.
+
+DESCRIPTION
+
+        This method decodes, verifies and fuses the loaded program as runProgram does, then
+        calls the RunFused handler for the fused opcode at a_cell, the same instantiation the
+        unchecked loop dispatches to, and nothing else. A build whose loop never runs the
+        fused program, such as one with VC_STATS, still has its handlers checked this way.
+
+RETURNS
+
+        Returns the cell of the next instruction, or -1 if the program is not verified or the
+        cell is not fused.
+*/
+/**/
+int emulator::ExecuteFused(int a_cell)
+{
+    PreDecode();
+    VerifyProgram();
+    if (!m_verified || a_cell < 0 || a_cell >= static_cast<int>(m_fusedCode.size()))
+    {
+        return -1;
+    }
+
+    const DecodedInstruction* code = m_fusedCode.data();
+    switch (code[a_cell].opcode)
+    {
+    case FUSED_SUB_BZ:
+        return RunFused<2, 0, 11, true>(code, a_cell);
+    case FUSED_SUB_BM:
+        return RunFused<2, 0, 10, true>(code, a_cell);
+    case FUSED_SUB_BP:
+        return RunFused<2, 0, 12, true>(code, a_cell);
+    case FUSED_ADD_BZ:
+        return RunFused<1, 0, 11, true>(code, a_cell);
+    case FUSED_ADD_BM:
+        return RunFused<1, 0, 10, true>(code, a_cell);
+    case FUSED_ADD_BP:
+        return RunFused<1, 0, 12, true>(code, a_cell);
+    case FUSED_ADD_B:
+        return RunFused<1, 0, 9, false>(code, a_cell);
+    case FUSED_SUB_B:
+        return RunFused<2, 0, 9, false>(code, a_cell);
+    case FUSED_COPY_B:
+        return RunFused<5, 0, 9, false>(code, a_cell);
+    case FUSED_COPY_BM:
+        return RunFused<5, 0, 10, false>(code, a_cell);
+    case FUSED_COPY_BZ:
+        return RunFused<5, 0, 11, false>(code, a_cell);
+    case FUSED_COPY_BP:
+        return RunFused<5, 0, 12, false>(code, a_cell);
+    case FUSED_ADD_SUB_BZ:
+        return RunFused<1, 2, 11, true>(code, a_cell);
+    case FUSED_ADD_SUB_BP:
+        return RunFused<1, 2, 12, true>(code, a_cell);
+    }
+    return -1;
+}
+
+// The value ADD, SUB, MULT or COPY stores into the word its first operand addresses.
+template <int OP>
+VC_FORCEINLINE long long emulator::Compute(const DecodedInstruction& a_inst) const
+{
+    if constexpr (OP == 1)
+    {
+        return m_memory[a_inst.operand1] + m_memory[a_inst.operand2];
+    }
+    else if constexpr (OP == 2)
+    {
+        return m_memory[a_inst.operand1] - m_memory[a_inst.operand2];
+    }
+    else if constexpr (OP == 3)
+    {
+        return m_memory[a_inst.operand1] * m_memory[a_inst.operand2];
+    }
+    else
+    {
+        return m_memory[a_inst.operand2];
+    }
+}
+
+/**/
+/*
+template <bool CHECKED> bool emulator::RunProduction()
+
+NAME
+
+        emulator::RunProduction - Runs the uninstrumented switch engine.
+
+SYNOPSIS
+
+        template <bool CHECKED> bool emulator::RunProduction();
+            CHECKED    --> False if the program has been verified.
+
+DESCRIPTION
+
+        This method picks the instantiation of RunLoop with no tracing, profiling or
+        breakpoints whose device types match the devices connected. A tape or a buffered
+        sink gets its own instantiation so that READ and WRITE are not virtual calls.
+
+RETURNS
+
+        Returns true if the program executes successfully, and false otherwise.
+*/
+/**/
+template <bool CHECKED>
+bool emulator::RunProduction()
+{
+    const int cell = CHECKED ? 0 : m_entry;
+    const bool tape = dynamic_cast<TapeInput*>(m_input) != nullptr;
+    const bool buffered = dynamic_cast<BufferedOutput*>(m_output) != nullptr;
+    if (tape && buffered)
+    {
+        return RunLoop<RunPolicy<CHECKED, false, false, false, false, TapeInput, BufferedOutput>>(cell);
+    }
+    if (tape)
+    {
+        return RunLoop<RunPolicy<CHECKED, false, false, false, false, TapeInput, OutputDevice>>(cell);
+    }
+    if (buffered)
+    {
+        return RunLoop<RunPolicy<CHECKED, false, false, false, false, InputDevice, BufferedOutput>>(cell);
+    }
+    return RunLoop<RunPolicy<CHECKED, false, false, false, false, InputDevice, OutputDevice>>(cell);
+}
+
+/**/
+/*
+template <bool CHECKED> bool emulator::RunInstrumented()
+
+NAME
+
+        emulator::RunInstrumented - Runs the switch engine with tracing, profiling, coverage or breakpoints.
+
+SYNOPSIS
+
+        template <bool CHECKED> bool emulator::RunInstrumented();
+            CHECKED    --> False if the program has been verified.
+
+DESCRIPTION
+
+        This method picks the instantiation of RunLoop that compiles in exactly the
+        instrumentation turned on for this run. The devices are called through their base
+        classes, since the instrumentation costs far more than a virtual call.
+
+RETURNS
+
+        Returns true if the program executes successfully, and false otherwise.
+*/
+/**/
+template <bool CHECKED>
+bool emulator::RunInstrumented()
+{
+    const int cell = CHECKED ? 0 : m_entry;
+    // A profile already shows which cells ran, so coverage is only marked separately without one
+    const int choice = (m_covering && !m_profiling ? 8 : 0) | (m_trace != nullptr ? 4 : 0) | (m_profiling ? 2 : 0) | (HasBreakpoints() ? 1 : 0);
+    switch (choice)
+    {
+    case 1:
+        return RunLoop<RunPolicy<CHECKED, false, false, true, false, InputDevice, OutputDevice>>(cell);
+    case 2:
+        return RunLoop<RunPolicy<CHECKED, false, true, false, false, InputDevice, OutputDevice>>(cell);
+    case 3:
+        return RunLoop<RunPolicy<CHECKED, false, true, true, false, InputDevice, OutputDevice>>(cell);
+    case 4:
+        return RunLoop<RunPolicy<CHECKED, true, false, false, false, InputDevice, OutputDevice>>(cell);
+    case 5:
+        return RunLoop<RunPolicy<CHECKED, true, false, true, false, InputDevice, OutputDevice>>(cell);
+    case 6:
+        return RunLoop<RunPolicy<CHECKED, true, true, false, false, InputDevice, OutputDevice>>(cell);
+    case 7:
+        return RunLoop<RunPolicy<CHECKED, true, true, true, false, InputDevice, OutputDevice>>(cell);
+    case 8:
+        return RunLoop<RunPolicy<CHECKED, false, false, false, true, InputDevice, OutputDevice>>(cell);
+    case 9:
+        return RunLoop<RunPolicy<CHECKED, false, false, true, true, InputDevice, OutputDevice>>(cell);
+    case 12:
+        return RunLoop<RunPolicy<CHECKED, true, false, false, true, InputDevice, OutputDevice>>(cell);
+    case 13:
+        return RunLoop<RunPolicy<CHECKED, true, false, true, true, InputDevice, OutputDevice>>(cell);
+    }
+    return RunProduction<CHECKED>();
+}
+
+// Sets a breakpoint on the instruction at a location.
+bool emulator::SetBreakpoint(int a_location)
+{
+    const int cell = a_location - 100;
+    if (cell < 0 || cell > MEMSZ - 100)
+    {
+        return false;
+    }
+    if (m_breakpoints.empty())
+    {
+        m_breakpoints.resize(MEMSZ, 0);
+    }
+    m_breakpoints[cell] = 1;
+    return true;
+}
+
+/**/
+/*
+VC_FORCEINLINE int emulator::ExecuteOne(int a_cell)
+
+NAME
+
+        emulator::ExecuteOne - Executes a single instruction.
+
+SYNOPSIS
+
+        int emulator::ExecuteOne(int a_cell);
+            a_cell    --> The memory cell holding the instruction (location - 100).
+
+DESCRIPTION
+
+        This method executes the instruction fetched for a_cell, using the pre-decoded copy
+        when the cell is part of the loaded program and decoding the word on the fly
+        otherwise. The threaded and JIT engines call it for the instructions they do not
+        handle themselves, and the fused loop for the first cell of a counted loop it cannot
+        solve.
+
+RETURNS
+
+        Returns the cell of the next instruction, STEP_HALT after a HALT, STEP_FAULT if the
+        instruction failed (division by zero, or READ with no input left), or STEP_WAIT if
+        it is a READ whose input device has nothing available yet or a WRITE whose output
+        device is full. In that case nothing has been executed or counted.
+*/
+/**/
+VC_FORCEINLINE int emulator::ExecuteOne(int a_cell)
+{
+    const DecodedInstruction inst = a_cell < m_codeLimit ? m_decoded[a_cell] : Decode(m_memory[a_cell]);
+    const int operand1 = inst.operand1;
+    const int operand2 = inst.operand2;
+
+    // A READ or WRITE that would block is left to be retried; it is neither executed nor counted.
+    if ((inst.opcode == 7 && m_input->WouldBlock()) || (inst.opcode == 8 && m_output->IsFull()))
+    {
+        return STEP_WAIT;
+    }
+    VC_STATS_COUNT(inst);
+
+    switch (inst.opcode)
+    {
+    case 0:  // No-op
+        break;
+    case 1:  // ADD
+        StoreMemory(operand1, m_memory[operand1] + m_memory[operand2]);
+        break;
+    case 2:  // SUB
+        StoreMemory(operand1, m_memory[operand1] - m_memory[operand2]);
+        break;
+    case 3:  // MULT
+        StoreMemory(operand1, m_memory[operand1] * m_memory[operand2]);
+        break;
+    case 4:  // DIV
+        if (m_memory[operand2] != 0)
+        {
+            StoreMemory(operand1, m_memory[operand1] / m_memory[operand2]);
+        }
+        else
+        {
+            // Error - division by zero
+            return STEP_FAULT;
+        }
+        break;
+    case 5:  // COPY
+        StoreMemory(operand1, m_memory[operand2]);
+        break;
+    case 7:  // READ
+        long long userInput;
+        if (!m_input->Read(userInput))
+        {
+            // Error - no more input
+            return STEP_FAULT;
+        }
+        StoreMemory(operand1, userInput);
+        break;
+    case 8:  // WRITE
+        m_output->Write(m_memory[operand1]);
+        break;
+    case 9:  // BRANCH
+        return operand1 - 100;
+    case 10:  // BRANCH MINUS
+        if (m_memory[operand2] < 0)
+        {
+            return operand1 - 100;
+        }
+        break;
+    case 11:  // BRANCH ZERO
+        if (m_memory[operand2] == 0)
+        {
+            return operand1 - 100;
+        }
+        break;
+    case 12:  // BRANCH POSITIVE
+        if (m_memory[operand2] > 0)
+        {
+            return operand1 - 100;
+        }
+        break;
+    case 13:  // HALT
+        return STEP_HALT;
+    }
+    return a_cell + 1;
+}
+
+/**/
+/*
+bool emulator::RunThreaded()
+
+NAME
+
+        emulator::RunThreaded - Runs the program with the threaded engine.
+
+SYNOPSIS
+
+        bool emulator::RunThreaded();
+
+DESCRIPTION
+
+        This method executes the pre-decoded program through a table holding one handler
+        per cell. With computed goto each handler ends by jumping straight to the handler of
+        the next cell, so every handler has its own indirect branch for the branch predictor
+        to learn. Without computed goto the handlers are functions that return the next cell
+        and are called from a small loop.
+
+        Both variants only cover cells [0, m_codeLimit). When execution moves outside that
+        range (a sentinel slot at m_codeLimit catches falling off the end, and branches check
+        their target) the rest of the run is handed over to RunSwitch, so the results are the
+        same as those of the switch engine.
+
+RETURNS
+
+        Returns true if the program executes successfully, and false otherwise.
+*/
+/**/
+#ifdef VC_COMPUTED_GOTO
+
+bool emulator::RunThreaded()
+{
+    // Opcode to handler, with the opcodes from the instruction set table. Unused opcodes behave as no-ops, as they do in RunSwitch.
+    ThreadedSlot table[100];
+    for (ThreadedSlot& slot : table)
+    {
+        slot = &&op_nop;
+    }
+    table[Isa::Opcode("add")] = &&op_add;
+    table[Isa::Opcode("sub")] = &&op_sub;
+    table[Isa::Opcode("mult")] = &&op_mult;
+    table[Isa::Opcode("div")] = &&op_div;
+    table[Isa::Opcode("copy")] = &&op_copy;
+    table[Isa::Opcode("read")] = &&op_read;
+    table[Isa::Opcode("write")] = &&op_write;
+    table[Isa::Opcode("b")] = &&op_branch;
+    table[Isa::Opcode("bm")] = &&op_branch_minus;
+    table[Isa::Opcode("bz")] = &&op_branch_zero;
+    table[Isa::Opcode("bp")] = &&op_branch_positive;
+    table[Isa::Opcode("halt")] = &&op_halt;
+
+    const int limit = m_codeLimit;
+    m_threaded.resize(limit + 1);
+    for (int i = 0; i < limit; i++)
+    {
+        m_threaded[i] = table[m_decoded[i].opcode];
+    }
+    m_threaded[limit] = &&leave;
+    m_threadedTable = table;
+
+    const ThreadedSlot* code = m_threaded.data();
+    const DecodedInstruction* dec = m_decoded.data();
+    const EmulatorMemory& mem = m_memory;
+    int pc = 0;
+    bool result = true;
+
+#define VC_DISPATCH() goto *code[pc]
+#define VC_BRANCH_TO(target) { pc = (target) - 100; if (static_cast<unsigned>(pc) >= static_cast<unsigned>(limit)) goto leave; VC_DISPATCH(); }
+
+    VC_DISPATCH();
+
+op_nop:
+    VC_STATS_COUNT(dec[pc]);
+    pc++;
+    VC_DISPATCH();
+op_add:
+    VC_STATS_COUNT(dec[pc]);
+    StoreMemory(dec[pc].operand1, mem[dec[pc].operand1] + mem[dec[pc].operand2]);
+    pc++;
+    VC_DISPATCH();
+op_sub:
+    VC_STATS_COUNT(dec[pc]);
+    StoreMemory(dec[pc].operand1, mem[dec[pc].operand1] - mem[dec[pc].operand2]);
+    pc++;
+    VC_DISPATCH();
+op_mult:
+    VC_STATS_COUNT(dec[pc]);
+    StoreMemory(dec[pc].operand1, mem[dec[pc].operand1] * mem[dec[pc].operand2]);
+    pc++;
+    VC_DISPATCH();
+op_div:
+    VC_STATS_COUNT(dec[pc]);
+    if (mem[dec[pc].operand2] == 0)
+    {
+        // Error - division by zero
+        result = false;
+        goto done;
+    }
+    StoreMemory(dec[pc].operand1, mem[dec[pc].operand1] / mem[dec[pc].operand2]);
+    pc++;
+    VC_DISPATCH();
+op_copy:
+    VC_STATS_COUNT(dec[pc]);
+    StoreMemory(dec[pc].operand1, mem[dec[pc].operand2]);
+    pc++;
+    VC_DISPATCH();
+op_read:
+    VC_STATS_COUNT(dec[pc]);
+    {
+        long long userInput;
+        if (!m_input->Read(userInput))
+        {
+            // Error - no more input
+            result = false;
+            goto done;
+        }
+        StoreMemory(dec[pc].operand1, userInput);
+    }
+    pc++;
+    VC_DISPATCH();
+op_write:
+    VC_STATS_COUNT(dec[pc]);
+    m_output->Write(mem[dec[pc].operand1]);
+    pc++;
+    VC_DISPATCH();
+op_branch:
+    VC_STATS_COUNT(dec[pc]);
+    VC_BRANCH_TO(dec[pc].operand1);
+op_branch_minus:
+    VC_STATS_COUNT(dec[pc]);
+    if (mem[dec[pc].operand2] < 0) VC_BRANCH_TO(dec[pc].operand1);
+    pc++;
+    VC_DISPATCH();
+op_branch_zero:
+    VC_STATS_COUNT(dec[pc]);
+    if (mem[dec[pc].operand2] == 0) VC_BRANCH_TO(dec[pc].operand1);
+    pc++;
+    VC_DISPATCH();
+op_branch_positive:
+    VC_STATS_COUNT(dec[pc]);
+    if (mem[dec[pc].operand2] > 0) VC_BRANCH_TO(dec[pc].operand1);
+    pc++;
+    VC_DISPATCH();
+op_halt:
+    VC_STATS_COUNT(dec[pc]);
+    goto done;
+leave:
+    m_threadedTable = nullptr;
+    return RunSwitch(pc + 100);
+done:
+    m_threadedTable = nullptr;
+    return result;
+
+#undef VC_BRANCH_TO
+#undef VC_DISPATCH
+}
+
+#else
+
+// Call-threaded handlers. A branch returns its target cell, which may lie outside the decoded code.
+int emulator::ThreadNop(emulator&, int a_pc)
+{
+    return a_pc + 1;
+}
+
+int emulator::ThreadAdd(emulator& a_emu, int a_pc)
+{
+    const DecodedInstruction& inst = a_emu.m_decoded[a_pc];
+    a_emu.StoreMemory(inst.operand1, a_emu.m_memory[inst.operand1] + a_emu.m_memory[inst.operand2]);
+    return a_pc + 1;
+}
+
+int emulator::ThreadSub(emulator& a_emu, int a_pc)
+{
+    const DecodedInstruction& inst = a_emu.m_decoded[a_pc];
+    a_emu.StoreMemory(inst.operand1, a_emu.m_memory[inst.operand1] - a_emu.m_memory[inst.operand2]);
+    return a_pc + 1;
+}
+
+int emulator::ThreadMult(emulator& a_emu, int a_pc)
+{
+    const DecodedInstruction& inst = a_emu.m_decoded[a_pc];
+    a_emu.StoreMemory(inst.operand1, a_emu.m_memory[inst.operand1] * a_emu.m_memory[inst.operand2]);
+    return a_pc + 1;
+}
+
+int emulator::ThreadDiv(emulator& a_emu, int a_pc)
+{
+    const DecodedInstruction& inst = a_emu.m_decoded[a_pc];
+    if (a_emu.m_memory[inst.operand2] == 0)
+    {
+        // Error - division by zero
+        return STEP_FAULT;
+    }
+    a_emu.StoreMemory(inst.operand1, a_emu.m_memory[inst.operand1] / a_emu.m_memory[inst.operand2]);
+    return a_pc + 1;
+}
+
+int emulator::ThreadCopy(emulator& a_emu, int a_pc)
+{
+    const DecodedInstruction& inst = a_emu.m_decoded[a_pc];
+    a_emu.StoreMemory(inst.operand1, a_emu.m_memory[inst.operand2]);
+    return a_pc + 1;
+}
+
+int emulator::ThreadRead(emulator& a_emu, int a_pc)
+{
+    long long userInput;
+    if (!a_emu.m_input->Read(userInput))
+    {
+        // Error - no more input
+        return STEP_FAULT;
+    }
+    a_emu.StoreMemory(a_emu.m_decoded[a_pc].operand1, userInput);
+    return a_pc + 1;
+}
+
+int emulator::ThreadWrite(emulator& a_emu, int a_pc)
+{
+    a_emu.m_output->Write(a_emu.m_memory[a_emu.m_decoded[a_pc].operand1]);
+    return a_pc + 1;
+}
+
+int emulator::ThreadBranch(emulator& a_emu, int a_pc)
+{
+    return a_emu.m_decoded[a_pc].operand1 - 100;
+}
+
+int emulator::ThreadBranchMinus(emulator& a_emu, int a_pc)
+{
+    const DecodedInstruction& inst = a_emu.m_decoded[a_pc];
+    return a_emu.m_memory[inst.operand2] < 0 ? inst.operand1 - 100 : a_pc + 1;
+}
+
+int emulator::ThreadBranchZero(emulator& a_emu, int a_pc)
+{
+    const DecodedInstruction& inst = a_emu.m_decoded[a_pc];
+    return a_emu.m_memory[inst.operand2] == 0 ? inst.operand1 - 100 : a_pc + 1;
+}
+
+int emulator::ThreadBranchPositive(emulator& a_emu, int a_pc)
+{
+    const DecodedInstruction& inst = a_emu.m_decoded[a_pc];
+    return a_emu.m_memory[inst.operand2] > 0 ? inst.operand1 - 100 : a_pc + 1;
+}
+
+int emulator::ThreadHalt(emulator&, int)
+{
+    return STEP_HALT;
+}
+
+bool emulator::RunThreaded()
+{
+    // Opcode to handler, with the opcodes from the instruction set table. Unused opcodes behave as no-ops, as they do in RunSwitch.
+    ThreadedSlot table[100];
+    for (ThreadedSlot& slot : table)
+    {
+        slot = ThreadNop;
+    }
+    table[Isa::Opcode("add")] = ThreadAdd;
+    table[Isa::Opcode("sub")] = ThreadSub;
+    table[Isa::Opcode("mult")] = ThreadMult;
+    table[Isa::Opcode("div")] = ThreadDiv;
+    table[Isa::Opcode("copy")] = ThreadCopy;
+    table[Isa::Opcode("read")] = ThreadRead;
+    table[Isa::Opcode("write")] = ThreadWrite;
+    table[Isa::Opcode("b")] = ThreadBranch;
+    table[Isa::Opcode("bm")] = ThreadBranchMinus;
+    table[Isa::Opcode("bz")] = ThreadBranchZero;
+    table[Isa::Opcode("bp")] = ThreadBranchPositive;
+    table[Isa::Opcode("halt")] = ThreadHalt;
+
+    const int limit = m_codeLimit;
+    m_threaded.resize(limit);
+    for (int i = 0; i < limit; i++)
+    {
+        m_threaded[i] = table[m_decoded[i].opcode];
+    }
+    m_threadedTable = table;
+
+    int pc = 0;
+    while (static_cast<unsigned>(pc) < static_cast<unsigned>(limit))
+    {
+        VC_STATS_COUNT(m_decoded[pc]);
+        pc = m_threaded[pc](*this, pc);
+    }
+    m_threadedTable = nullptr;
+
+    if (pc == STEP_HALT)
+    {
+        return true;
+    }
+    if (pc == STEP_FAULT)
+    {
+        return false;
+    }
+    return RunSwitch(pc + 100);
+}
+
+#endif
+
+/**/
+/*
+bool emulator::RunJit()
+
+NAME
+
+        emulator::RunJit - Runs the program with the JIT engine.
+
+SYNOPSIS
+
+        bool emulator::RunJit();
+
+DESCRIPTION
+
+        This method executes the pre-decoded program one basic block at a time. For each
+        cell it asks the JitCompiler for a compiled block; if there is one the native code
+        runs and returns the next cell, otherwise ExecuteOne interprets the instruction and
+        the visit counts towards compiling a block there. READ, WRITE, DIV and HALT are
+        always interpreted. With VC_STATS the instructions of a block are counted after it
+        returns, since a block always runs to its end. The pages a block stores into are
+        marked dirty after it returns. After a block that stores into the decoded code the written
+        cells are re-decoded, which also drops any blocks compiled from them.
+
+        If the host cannot run generated code, or the emulator is built with the sparse
+        memory backend, the whole program is interpreted by RunSwitch. As with RunThreaded,
+        execution outside the decoded cells is handed over to it.
+
+RETURNS
+
+        Returns true if the program executes successfully, and false otherwise.
+*/
+/**/
+bool emulator::RunJit()
+{
+#ifdef VC_SPARSE_MEMORY
+    // Compiled blocks address memory as one flat array, which only the dense backend has.
+    return RunSwitch(100);
+#else
+    JitCompiler jit(m_codeLimit);
+    if (!jit.IsAvailable())
+    {
+        return RunSwitch(100);
+    }
+    m_jit = &jit;
+
+    long long* mem = m_memory.Data();
+    int cell = 0;
+    while (static_cast<unsigned>(cell) < static_cast<unsigned>(m_codeLimit))
+    {
+        const JitCompiler::Block* block = jit.Enter(cell, m_decoded.data());
+        if (block == nullptr)
+        {
+            cell = ExecuteOne(cell);
+            continue;
+        }
+        cell = block->code(mem);
+        for (int page : block->dirtyPages)
+        {
+            m_dirty[page] = 1;
+        }
+#ifdef VC_STATS
+        // The whole block has run; its final branch sees the memory as the block left it.
+        for (int i = block->start; i < block->start + block->length; i++)
+        {
+            VC_STATS_COUNT(m_decoded[i]);
+        }
+#endif
+        for (int written : block->codeWrites)
+        {
+            RedecodeCell(written, m_memory[written]);
+        }
+    }
+    m_jit = nullptr;
+
+    if (cell == STEP_HALT)
+    {
+        return true;
+    }
+    if (cell == STEP_FAULT)
+    {
+        return false;
+    }
+    return RunSwitch(cell + 100);
+#endif
+}
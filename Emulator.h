@@ -1,38 +1,371 @@
-/*
-Each function and data member in this class is designed to emulate the operation of a simple computer, the VC1620. The insertMemory function allows 
-machine code instructions and data to be inserted into memory at specified locations, while the runProgram function emulates the execution of the 
-program loaded in memory. The m_memory vector serves as the memory of the emulated computer.
-*/
-
-#ifndef _EMULATOR_H      // UNIX way of preventing multiple inclusions.
-#define _EMULATOR_H
-
-#include <vector>   // Vector is a container that encapsulates dynamic size arrays.
-
-// Emulator class is responsible for running the machine code translated by the assembler.
-class emulator {
-
-public:
-
-    // Constant that sets the memory size of the emulated VC1620 computer.
-    const static int MEMSZ = 100'000;
-
-    // Constructor for the emulator class. It initializes the memory vector with zeroes.
-    emulator() {
-        m_memory.resize(MEMSZ, 0); // Resizes the vector to MEMSZ and initializes all elements to 0.
-    }
-
-    // Records instructions and data into simulated memory. a_location is the memory location and a_contents is the value to be inserted.
-    // Returns true if successful, false otherwise.
-    bool insertMemory(int a_location, long long a_contents);
-
-    // Runs the program recorded in memory. Returns true if the program was able to run successfully, false otherwise.
-    bool runProgram();
-
-private:
-
-    std::vector<long long> m_memory;  // Vector to simulate the memory of the VC1620 computer. Each element can hold a long long integer.
-
-};
-
-#endif
+/*
+Each function and data member in this class is designed to emulate the operation of a simple computer, the VC1620. The insertMemory function allows 
+machine code instructions and data to be inserted into memory at specified locations, while the runProgram function emulates the execution of the 
+program loaded in memory. The m_memory object serves as the memory of the emulated computer; see Memory.h for the dense and sparse backends.
+*/
+
+#ifndef _EMULATOR_H      // UNIX way of preventing multiple inclusions.
+#define _EMULATOR_H
+
+#include <functional> // The breakpoint handler.
+#include <memory>   // The memory snapshot is shared between copies of an emulator.
+#include <string>   // For string objects
+#include <vector>   // Vector is a container that encapsulates dynamic size arrays.
+#include "IODevice.h" // Devices used by the READ and WRITE instructions.
+#include "Stats.h"    // Execution statistics, compiled in with VC_STATS.
+#include "Memory.h"   // The dense or sparse memory backend.
+#include "Trace.h"    // Receivers of traced runs.
+
+// GCC and Clang support taking the address of a label, which the threaded engine uses for
+// direct-threaded dispatch. Other compilers (MSVC) get a call-threaded fallback instead.
+// Define VC_NO_COMPUTED_GOTO to force the fallback.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(VC_NO_COMPUTED_GOTO)
+#define VC_COMPUTED_GOTO
+#endif
+
+// Forces the compiler to inline a function that sits on the emulator's hot path.
+#if defined(_MSC_VER)
+#define VC_FORCEINLINE __forceinline
+#elif defined(__GNUC__) || defined(__clang__)
+#define VC_FORCEINLINE __attribute__((always_inline)) inline
+#else
+#define VC_FORCEINLINE inline
+#endif
+
+// A machine word split into its fields. runProgram works from these records so the packed
+// long long in m_memory only has to be taken apart once, not on every step.
+struct DecodedInstruction {
+    int opcode;     // Operation code, 0-13.
+    int operand1;   // First address field (branch target for the branch instructions).
+    int operand2;   // Second address field.
+};
+
+class JitCompiler;
+struct CountedLoop;
+
+// Emulator class is responsible for running the machine code translated by the assembler.
+class emulator {
+
+public:
+
+    // Constant that sets the memory size of the emulated VC1620 computer.
+    const static int MEMSZ = MemoryLayout::WORDS;
+
+    // The execution engines that runProgram can use.
+    enum Engine {
+        ENGINE_SWITCH,      // One switch statement over the opcode for every step.
+        ENGINE_THREADED,    // Each instruction jumps straight to the handler of the next one.
+        ENGINE_JIT          // Hot basic blocks are compiled to native x86-64 code.
+    };
+
+    // Number of words in each page of memory, as tracked by the dirty-page map.
+    const static int PAGE_WORDS = MemoryLayout::PAGE_WORDS;
+    const static int PAGES = MemoryLayout::PAGES;
+
+    // The outcome of a call to Run.
+    enum RunStatus {
+        STATUS_HALTED,      // HALT was executed, or execution ran off the end of memory.
+        STATUS_BUDGET,      // The instruction budget was used up. Calling Run again continues the program.
+        STATUS_WAITING,     // READ found no input available yet, or WRITE a full output device. Calling Run again retries it.
+        STATUS_FAULTED      // Division by zero, a branch below 100, or READ with the input exhausted.
+    };
+
+    // Constructor for the emulator class. Memory starts out as all zeroes.
+    emulator() {
+        m_dirty.resize(PAGES, 0);
+    }
+
+    // Records instructions and data into simulated memory. a_location is the memory location and a_contents is the value to be inserted.
+    // Returns true if successful, false otherwise.
+    bool insertMemory(int a_location, long long a_contents);
+
+    // Runs the program recorded in memory. Returns true if the program was able to run successfully, false otherwise.
+    bool runProgram();
+
+    // Saves the contents of memory, normally right after the program is loaded, so Restore can return to them.
+    void TakeSnapshot();
+
+    // Returns memory to the last snapshot by copying back only the pages written since it was taken or last restored.
+    // Returns false if no snapshot has been taken.
+    bool Restore();
+
+    // Executes at most a_budget instructions, starting the program at location 100 on the first call and
+    // resuming where the previous call stopped on later ones. Always uses the switch engine, with the tracing,
+    // profiling, coverage and breakpoints that are turned on; the engine chosen with SetEngine is not used.
+    RunStatus Run(long long a_budget);
+
+    // Makes the next call to Run start the program from the beginning.
+    void ResetRun() { m_runStarted = false; }
+
+    // Instructions executed by Run since the program was started.
+    long long GetRetired() const { return m_retired; }
+
+    // Returns the location of the instruction the next call to Run starts with. Not meaningful once the run has ended.
+    int GetRunLocation() const { return m_runCell + 100; }
+
+    // Moves a started run to a_location, with a_retired instructions counted as executed, so the next call to Run carries
+    // on from there. Used to step a run backwards; memory has to be put back separately.
+    void SetRunPosition(int a_location, long long a_retired);
+
+    // Writes a word of memory the way a store by the program does, keeping the decoded code current.
+    void PokeMemory(int a_location, long long a_value) { StoreMemory(a_location, a_value); }
+
+    // Selects the engine used by runProgram. The default is ENGINE_SWITCH.
+    void SetEngine(Engine a_engine) { m_engine = a_engine; }
+
+    // Connects READ and WRITE to the given devices. The default for both is ConsoleDevice::Standard().
+    void SetDevices(InputDevice& a_input, OutputDevice& a_output) { m_input = &a_input; m_output = &a_output; }
+
+    // Turns the load-time verifier on or off. It is on by default; with it off the switch engine always runs checked.
+    void SetVerifying(bool a_verifying) { m_verifying = a_verifying; }
+
+    // Turns pre-decoding of the loaded program on or off. It is on by default; with it off every instruction is decoded
+    // as it is fetched, as before pre-decoding existed, and nothing is verified. Only there to measure what it saves.
+    void SetPreDecoding(bool a_preDecoding) { m_preDecoding = a_preDecoding; }
+
+    // Returns true if the verifier passed the program at the start of the last call to runProgram.
+    bool IsVerified() const { return m_verified; }
+
+    // Returns why the verifier rejected the program, or an empty string if it passed or did not run.
+    const std::string& GetVerifierReport() const { return m_verifierReport; }
+
+    // Turns superinstruction fusion of verified programs on or off. It is on by default.
+    void SetFusing(bool a_fusing) { m_fusing = a_fusing; }
+
+    // Limits fusion to the cells that ran at least a_threshold times according to a_profile, the cell counts of an
+    // earlier profiled run (see GetProfile). An empty profile fuses everywhere again.
+    void SetFusionProfile(const std::vector<long long>& a_profile, long long a_threshold) { m_fusionProfile = a_profile; m_fusionThreshold = a_threshold; }
+
+    // Returns the number of fused sequences in the program of the last call to runProgram.
+    int GetFusedCount() const { return m_fusedCount; }
+
+    // Verifies and fuses the loaded program as runProgram does, then executes only the superinstruction at a_cell with
+    // the handler the unchecked loop uses. Returns the cell of the next instruction, or -1 if the program is not verified
+    // or the cell is not fused. Lets Fusion::CheckHandlers reach the handlers whatever the build.
+    int ExecuteFused(int a_cell);
+
+    // Turns the closed-form execution of counted loops in verified programs on or off. It is on by default.
+    void SetAccelerating(bool a_accelerating) { m_accelerating = a_accelerating; }
+
+    // Returns the number of counted loops found in the program of the last call to runProgram.
+    int GetCountedLoopCount() const;
+
+    // Returns the number of loop iterations the last call to runProgram computed in closed form instead of executing.
+    long long GetSkippedIterations() const { return m_skippedIterations; }
+
+    // Turns on counting how often each cell is executed. Profiled runs always use the switch engine.
+    void SetProfiling(bool a_profiling) { m_profiling = a_profiling; }
+
+    // Turns on marking which cells are executed. Covered runs always use the switch engine.
+    void SetCoverage(bool a_covering) { m_covering = a_covering; }
+
+    // Passes every executed instruction and every word stored to a_trace, or stops tracing if it is null.
+    // Traced runs always use the switch engine.
+    void SetTrace(TraceSink* a_trace) { m_trace = a_trace; }
+
+    // Sets a breakpoint on the instruction at a_location. Returns false if the location is outside memory.
+    bool SetBreakpoint(int a_location);
+
+    // Sets the function called with the location of each breakpoint reached, before the instruction executes. It returns
+    // true to carry on, or false to stop the run, which then fails. Runs with breakpoints always use the switch engine.
+    void SetBreakpointHandler(std::function<bool(int)> a_handler) { m_breakHandler = a_handler; }
+
+    // Execution count of each cell in the last profiled run.
+    const std::vector<long long>& GetProfile() const { return m_profile; }
+
+    // One byte per cell, nonzero if the cell was executed in the last covered run. A byte rather than a bit, so that
+    // marking a cell is one store.
+    const std::vector<unsigned char>& GetCoverage() const { return m_coverage; }
+
+    // Returns one past the highest cell written by insertMemory, i.e. the extent of the loaded program.
+    int GetLoadedLimit() const { return m_loadedLimit; }
+
+    // Gives read access to the simulated memory.
+    const EmulatorMemory& GetMemory() const { return m_memory; }
+
+    // Splits a packed machine word into its opcode and operand fields.
+    static DecodedInstruction Decode(long long a_contents);
+
+#ifdef VC_STATS
+    // Returns the statistics of the last run.
+    const ExecutionStats& GetStats() const { return m_stats; }
+#endif
+
+private:
+
+#ifdef VC_COMPUTED_GOTO
+    typedef const void* ThreadedSlot;               // Address of a handler label in RunThreaded.
+#else
+    typedef int (*ThreadedSlot)(emulator&, int);    // Handler that executes a cell and returns the next one.
+#endif
+
+    // Decodes every loaded cell into m_decoded before execution starts.
+    void PreDecode();
+
+    // Values returned by ExecuteOne and the call-threaded handlers in place of a next cell.
+    static const int STEP_HALT = -2'000'000'000;
+    static const int STEP_FAULT = -2'000'000'001;
+    static const int STEP_WAIT = -2'000'000'002;    // READ or WRITE would block; it has not been executed.
+
+    // Runs the engine selected by m_engine.
+    bool RunEngine();
+
+    // Runs the switch engine starting at location a_loc.
+    bool RunSwitch(int a_loc);
+
+    // Verifies the decoded program and, if it passes, prepares m_verifiedCode for the unchecked RunLoop.
+    void VerifyProgram();
+
+    // The compile-time choices RunLoop is instantiated with. Each policy adds its code to the loop
+    // only when it is turned on, so an instantiation tests no flags for the others at run time.
+    template <bool CHECKED, bool TRACE, bool PROFILE, bool BREAKPOINTS, bool COVERAGE, class INPUT, class OUTPUT, bool BUDGETED = false>
+    struct RunPolicy {
+        static const bool checked = CHECKED;            // Bounds and code-write checks. Off only for verified programs.
+        static const bool trace = TRACE;                // Pass each instruction and store to m_trace.
+        static const bool profile = PROFILE;            // Count executions of each cell in m_profile.
+        static const bool breakpoints = BREAKPOINTS;    // Call m_breakHandler at breakpoints.
+        static const bool coverage = COVERAGE;          // Mark each cell executed in m_coverage.
+        static const bool budgeted = BUDGETED;          // Stop after a budget of instructions, or at a READ or WRITE that would block. For Run.
+#ifdef VC_STATS
+        static const bool stats = true;                 // Count into m_stats. Fixed by the build.
+#else
+        static const bool stats = false;
+#endif
+        typedef INPUT Input;                            // Type READ calls m_input through.
+        typedef OUTPUT Output;                          // Type WRITE calls m_output through.
+
+        // Run the fused program. Only an unchecked loop without instrumentation can, since a fused
+        // handler executes several instructions with no hooks between them.
+        static const bool fused = !CHECKED && !TRACE && !PROFILE && !BREAKPOINTS && !COVERAGE && !stats && !BUDGETED;
+    };
+
+    // Runs the switch engine from cell a_cell, with the checks and instrumentation chosen by Policy. A budgeted
+    // Policy executes at most a_budget instructions and leaves where it stopped in m_runCell and m_runStatus.
+    template <class Policy> bool RunLoop(int a_cell, long long a_budget = 0);
+
+    // Runs the switch engine without instrumentation, specialised for the connected devices.
+    template <bool CHECKED> bool RunProduction();
+
+    // Runs the switch engine with the tracing, profiling, coverage and breakpoints that are turned on.
+    template <bool CHECKED> bool RunInstrumented();
+
+    // Runs the checked switch engine for Run from m_runCell, for at most a_budget instructions, with the
+    // instrumentation that is turned on.
+    void RunBudgeted(long long a_budget);
+
+    // Executes the fused sequence at a_cell of a_code: data instruction FIRST, then SECOND unless it is 0, then branch
+    // BRANCH, which tests the word the instruction before it stored if SAME is true. Returns the next cell.
+    template <int FIRST, int SECOND, int BRANCH, bool SAME> int RunFused(const DecodedInstruction* a_code, int a_cell);
+
+    // Returns the value the data instruction OP (ADD, SUB, MULT or COPY) stores.
+    template <int OP> long long Compute(const DecodedInstruction& a_inst) const;
+
+    // Returns true if a run should stop at breakpoints.
+    bool HasBreakpoints() const { return !m_breakpoints.empty() && m_breakHandler; }
+
+    // Executes the instruction in a_cell. Returns the next cell, STEP_HALT, STEP_FAULT or STEP_WAIT.
+    int ExecuteOne(int a_cell);
+
+    // Runs the threaded engine from location 100, handing over to RunSwitch if execution leaves the decoded code.
+    bool RunThreaded();
+
+    // Runs the JIT engine from location 100, interpreting whatever is not compiled.
+    bool RunJit();
+
+    // Re-decodes a cell of the pre-decoded code after it has been written.
+    void RedecodeCell(int a_location, long long a_value);
+
+    // Records that the page holding a_location has been written.
+    inline void MarkDirty(int a_location)
+    {
+        m_dirty[static_cast<unsigned>(a_location) / PAGE_WORDS] = 1;
+    }
+
+    // Stores a value into memory, re-decoding the cell if it is part of the pre-decoded code.
+    inline void StoreMemory(int a_location, long long a_value)
+    {
+        m_memory.Store(a_location, a_value);
+        MarkDirty(a_location);
+        if (a_location < m_codeLimit) {
+            RedecodeCell(a_location, a_value);
+        }
+    }
+
+    // Stores a value into memory for a verified program, which never writes into its code.
+    inline void StoreData(int a_location, long long a_value)
+    {
+        m_memory.Store(a_location, a_value);
+        MarkDirty(a_location);
+    }
+
+#ifndef VC_COMPUTED_GOTO
+    // Call-threaded handlers. Each executes the cell a_pc and returns the next cell, or STEP_HALT/STEP_FAULT.
+    static int ThreadNop(emulator& a_emu, int a_pc);
+    static int ThreadAdd(emulator& a_emu, int a_pc);
+    static int ThreadSub(emulator& a_emu, int a_pc);
+    static int ThreadMult(emulator& a_emu, int a_pc);
+    static int ThreadDiv(emulator& a_emu, int a_pc);
+    static int ThreadCopy(emulator& a_emu, int a_pc);
+    static int ThreadRead(emulator& a_emu, int a_pc);
+    static int ThreadWrite(emulator& a_emu, int a_pc);
+    static int ThreadBranch(emulator& a_emu, int a_pc);
+    static int ThreadBranchMinus(emulator& a_emu, int a_pc);
+    static int ThreadBranchZero(emulator& a_emu, int a_pc);
+    static int ThreadBranchPositive(emulator& a_emu, int a_pc);
+    static int ThreadHalt(emulator& a_emu, int a_pc);
+#endif
+
+    EmulatorMemory m_memory;  // Simulates the memory of the VC1620 computer. Each word can hold a long long integer.
+
+    std::vector<unsigned char> m_dirty;          // One flag per page of m_memory, set when the page is written.
+    std::shared_ptr<const EmulatorMemory> m_snapshot;  // Memory as it was when TakeSnapshot was called, or null. Copies share it.
+    int m_snapshotLoadedLimit = 0;               // m_loadedLimit at the time of the snapshot.
+
+    std::vector<DecodedInstruction> m_decoded;  // Decoded copy of memory cells [0, m_codeLimit).
+    int m_codeLimit = 0;                         // Number of cells covered by m_decoded.
+    int m_loadedLimit = 0;                       // One past the highest cell written by insertMemory.
+
+    bool m_verifying = true;                     // True if runProgram runs the verifier.
+    bool m_preDecoding = true;                   // True if runProgram decodes the loaded program ahead of the run.
+    bool m_verified = false;                     // True if the verifier passed the program.
+    int m_entry = 0;                             // Cell at which the verified program starts.
+    std::string m_verifierReport;                // Why the verifier rejected the program.
+    std::vector<DecodedInstruction> m_verifiedCode; // Decoded program with branch targets as cells, if verified.
+    bool m_fusing = true;                        // True if verified programs are fused.
+    std::vector<long long> m_fusionProfile;      // Cell counts that limit fusion to hot cells, or empty.
+    long long m_fusionThreshold = 0;             // Fewest executions for a cell to be fused, with a profile.
+    std::vector<DecodedInstruction> m_fusedCode; // m_verifiedCode with superinstructions, if verified.
+    int m_fusedCount = 0;                        // Number of fused sequences in m_fusedCode.
+    bool m_accelerating = true;                  // True if counted loops of verified programs run in closed form.
+    std::shared_ptr<const std::vector<CountedLoop>> m_countedLoops; // Loops whose first cell is COUNTED_LOOP in m_fusedCode, or null.
+    std::vector<long long> m_loopValues;         // Final values of the targets of the loop being solved.
+    long long m_skippedIterations = 0;           // Iterations solved in closed form in the last run.
+
+    std::vector<ThreadedSlot> m_threaded;        // Handler for each decoded cell, plus a sentinel at m_codeLimit.
+    const ThreadedSlot* m_threadedTable = nullptr; // Opcode to handler table while RunThreaded is active.
+
+    JitCompiler* m_jit = nullptr;                // Block cache to invalidate on code writes while RunJit is active.
+
+    Engine m_engine = ENGINE_SWITCH;             // Engine used by runProgram.
+    bool m_runStarted = false;                   // True once Run has started the program.
+    int m_runCell = 0;                           // Cell at which the next call to Run continues.
+    RunStatus m_runStatus = STATUS_BUDGET;       // Status returned by the last call to Run.
+    long long m_retired = 0;                     // Instructions executed by Run so far.
+
+    bool m_profiling = false;                    // True if runProgram fills in m_profile.
+    std::vector<long long> m_profile;            // Executions of each cell in the last profiled run.
+    bool m_covering = false;                     // True if runProgram fills in m_coverage.
+    std::vector<unsigned char> m_coverage;       // One flag per cell executed in the last covered run.
+    TraceSink* m_trace = nullptr;                // Receives the events of traced runs, or null.
+    std::vector<unsigned char> m_breakpoints;    // One flag per cell, or empty if no breakpoint was set.
+    std::function<bool(int)> m_breakHandler;     // Called at breakpoints.
+    InputDevice* m_input = &ConsoleDevice::Standard();     // Source of READ input.
+    OutputDevice* m_output = &ConsoleDevice::Standard();   // Destination of WRITE output.
+
+#ifdef VC_STATS
+    ExecutionStats m_stats;                      // Counters for the current or last run.
+#endif
+
+};
+
+#endif
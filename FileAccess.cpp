@@ -1,142 +1,300 @@
-//
-//  Implementation of file access class.
-//
-#include "stdafx.h"
-#include "FileAccess.h"
-
-
-/**/
-/*
-FileAccess::FileAccess( int argc, char *argv[] )
-
-NAME
-
-        FileAccess::FileAccess - Constructor for FileAccess class.
-
-SYNOPSIS
-
-        FileAccess::FileAccess( int argc, char *argv[] );
-            argc       --> The number of arguments passed to the program.
-            argv       --> The arguments passed to the program as an array of character pointers.
-
-DESCRIPTION
-
-        This constructor checks if there is exactly one run-time parameter (a file name). If not,
-        it reports an error and terminates the program. If there is, it attempts to open that file
-        for reading. If the file cannot be opened, it reports an error and terminates the program.
-
-*/
-/**/
-
-// Don't forget to comment the function headers.
-FileAccess::FileAccess( int argc, char *argv[] )
-{
-    // Check that there is exactly one run time parameter.
-    if( argc != 2 ) {
-        cerr << "Usage: Assem <FileName>" << endl;
-        exit( 1 );
-    }
-    // Open the file.  One might question if this is the best place to open the file.
-    // One might also question whether we need a file access class.
-    m_sfile.open( argv[1], ios::in );
-
-    // If the open failed, report the error and terminate.
-    if( ! m_sfile ) {
-        cerr << "Source file could not be opened, assembler terminated."
-            << endl;
-        exit( 1 ); 
-    }
-}
-
-/**/
-/*
-FileAccess::~FileAccess()
-
-NAME
-
-        FileAccess::~FileAccess - Destructor for FileAccess class.
-
-SYNOPSIS
-
-        FileAccess::~FileAccess();
-
-DESCRIPTION
-
-        This destructor closes the file opened by the constructor. This operation is not strictly
-        necessary, as the file would be closed when the program terminates, but it is good practice.
-
-*/
-/**/
-
-FileAccess::~FileAccess( )
-{
-    // Not that necessary in that the file will be closed when the program terminates, but good form.
-    m_sfile.close( );
-}
-
-/**/
-/*
-bool FileAccess::GetNextLine( string &a_line )
-
-NAME
-
-        FileAccess::GetNextLine - Retrieves the next line from the file.
-
-SYNOPSIS
-
-        bool FileAccess::GetNextLine( string &a_line );
-            a_line    --> A reference to the string that will store the retrieved line.
-
-DESCRIPTION
-
-        This method reads the next line from the file into the string a_line. If there are no
-        more lines in the file, it returns false. Otherwise, it returns true.
-
-RETURNS
-
-        Returns true if a line was successfully read from the file, and false otherwise.
-
-*/
-/**/
-
-// Get the next line from the file.
-bool FileAccess::GetNextLine( string &a_line )
-{
-    // If there is no more data, return false.
-    if( m_sfile.eof() ) {
-    
-        return false;
-    }
-    getline( m_sfile, a_line );
-    
-    // Return indicating success.
-    return true;
-}
-
-
-/**/
-/*
-void FileAccess::rewind()
-
-NAME
-
-        FileAccess::rewind - Resets the file stream.
-
-SYNOPSIS
-
-        void FileAccess::rewind();
-
-DESCRIPTION
-
-        This method clears all file flags and resets the file stream to the beginning of the file.
-        It is typically used when you want to read the file from the beginning after reaching the end.
-
-*/
-/**/
-void FileAccess::rewind( )
-{
-    // Clean all file flags and go back to the beginning of the file.
-    m_sfile.clear();
-    m_sfile.seekg( 0, ios::beg );
-}
-    
+//
+//  Implementation of file access class.
+//
+#include "stdafx.h"
+#include "FileAccess.h"
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+/**/
+/*
+FileAccess::FileAccess( int argc, char *argv[] )
+
+NAME
+
+        FileAccess::FileAccess - Constructor for FileAccess class.
+
+SYNOPSIS
+
+        FileAccess::FileAccess( int argc, char *argv[] );
+            argc       --> The number of arguments passed to the program.
+            argv       --> The arguments passed to the program as an array of character pointers.
+
+DESCRIPTION
+
+        This constructor checks that the first run-time parameter (a file name) is present. If not,
+        it reports an error and terminates the program. Any further parameters are options that
+        the Assembler interprets. If a file name is given, it attempts to map that file into
+        memory, and failing that, to open it for reading as a stream. If the file cannot be
+        opened, it reports an error and terminates the program.
+
+*/
+/**/
+
+// Don't forget to comment the function headers.
+FileAccess::FileAccess( int argc, char *argv[] )
+{
+    // Check that there is a file name. Options that follow it are handled by the Assembler.
+    if( argc < 2 ) {
+        cerr << "Usage: Assem <FileName> [-passes 1|2] [-lexer compare] [-engine switch|threaded|jit|verify] [-decode compare] [-batch <file>] [-jobs <file>] [-sessions <file>] [-input <file>] [-output console|buffered] [-stats <file>] [-profile <file>] [-coverage <file>] [-cfg <file>] [-trace <file>] [-break <location>] [-record <file>] [-record-trace <file>] [-replay <file>] [-debug <file>] [-limit <instructions>] [-timeout <seconds>]" << endl;
+        exit( 1 );
+    }
+    // Open the file.  One might question if this is the best place to open the file.
+    // One might also question whether we need a file access class.
+    m_fileName = argv[1];
+    if( Map( argv[1] ) ) {
+        return;
+    }
+    m_sfile.open( argv[1], ios::in );
+
+    // If the open failed, report the error and terminate.
+    if( ! m_sfile ) {
+        cerr << "Source file could not be opened, assembler terminated."
+            << endl;
+        exit( 1 ); 
+    }
+}
+
+/**/
+/*
+FileAccess::~FileAccess()
+
+NAME
+
+        FileAccess::~FileAccess - Destructor for FileAccess class.
+
+SYNOPSIS
+
+        FileAccess::~FileAccess();
+
+DESCRIPTION
+
+        This destructor unmaps or closes the file opened by the constructor. This operation is not
+        strictly necessary, as the file would be closed when the program terminates, but it is good
+        practice.
+
+*/
+/**/
+
+FileAccess::~FileAccess( )
+{
+    // Not that necessary in that the file will be closed when the program terminates, but good form.
+    if( m_data != nullptr ) {
+#ifdef _WIN32
+        UnmapViewOfFile( m_data );
+        CloseHandle( m_mappingHandle );
+        CloseHandle( m_fileHandle );
+#else
+        munmap( const_cast<char*>( m_data ), m_size );
+#endif
+    }
+    m_sfile.close( );
+}
+
+/**/
+/*
+bool FileAccess::Map( const char* a_fileName )
+
+NAME
+
+        FileAccess::Map - Maps the source file into memory.
+
+SYNOPSIS
+
+        bool FileAccess::Map( const char* a_fileName );
+            a_fileName    --> The name of the file.
+
+DESCRIPTION
+
+        This method maps the whole of the file read-only into memory, telling the system it will
+        be read from start to end. Only a regular file that is not empty is mapped: a pipe or a
+        terminal cannot be, and an empty file is left to the stream.
+
+RETURNS
+
+        Returns true if the file was mapped, and false otherwise.
+
+*/
+/**/
+bool FileAccess::Map( const char* a_fileName )
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA( a_fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+    if( file == INVALID_HANDLE_VALUE ) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if( GetFileType( file ) != FILE_TYPE_DISK || !GetFileSizeEx( file, &size ) || size.QuadPart == 0 ) {
+        CloseHandle( file );
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    const void* data = mapping != nullptr ? MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) : nullptr;
+    if( data == nullptr ) {
+        if( mapping != nullptr ) {
+            CloseHandle( mapping );
+        }
+        CloseHandle( file );
+        return false;
+    }
+    m_fileHandle = file;
+    m_mappingHandle = mapping;
+    m_data = static_cast<const char*>( data );
+    m_size = static_cast<size_t>( size.QuadPart );
+    return true;
+#else
+    int file = open( a_fileName, O_RDONLY );
+    if( file < 0 ) {
+        return false;
+    }
+    struct stat info;
+    if( fstat( file, &info ) != 0 || !S_ISREG( info.st_mode ) || info.st_size == 0 ) {
+        close( file );
+        return false;
+    }
+    void* data = mmap( nullptr, static_cast<size_t>( info.st_size ), PROT_READ, MAP_PRIVATE, file, 0 );
+    close( file );
+    if( data == MAP_FAILED ) {
+        return false;
+    }
+    madvise( data, static_cast<size_t>( info.st_size ), MADV_SEQUENTIAL );
+    m_data = static_cast<const char*>( data );
+    m_size = static_cast<size_t>( info.st_size );
+    return true;
+#endif
+}
+
+/**/
+/*
+bool FileAccess::GetNextLine( string &a_line )
+
+NAME
+
+        FileAccess::GetNextLine - Retrieves the next line from the file.
+
+SYNOPSIS
+
+        bool FileAccess::GetNextLine( string &a_line );
+            a_line    --> A reference to the string that will store the retrieved line.
+
+DESCRIPTION
+
+        This method reads the next line from the file into the string a_line. If there are no
+        more lines in the file, it returns false. Otherwise, it returns true.
+
+RETURNS
+
+        Returns true if a line was successfully read from the file, and false otherwise.
+
+*/
+/**/
+
+// Get the next line from the file.
+bool FileAccess::GetNextLine( string &a_line )
+{
+    std::string_view line;
+    if( !GetNextLine( line ) ) {
+        return false;
+    }
+    a_line.assign( line );
+    return true;
+}
+
+/**/
+/*
+bool FileAccess::GetNextLine( std::string_view &a_line )
+
+NAME
+
+        FileAccess::GetNextLine - Retrieves the next line from the file as a view.
+
+SYNOPSIS
+
+        bool FileAccess::GetNextLine( std::string_view &a_line );
+            a_line    --> Set to the retrieved line.
+
+DESCRIPTION
+
+        This method sets a_line to the next line of the file, without its newline. A mapped file
+        is searched for the end of the line in place; a streamed one is read into m_line. Either
+        way the lines are those getline gives: text after the last newline, even if there is
+        none, is a line. On Windows, where the stream reads in text mode, a mapped line also
+        loses the carriage return before its newline.
+
+RETURNS
+
+        Returns true if a line was successfully read from the file, and false otherwise.
+
+*/
+/**/
+bool FileAccess::GetNextLine( std::string_view &a_line )
+{
+    if( m_data == nullptr ) {
+        // If there is no more data, return false.
+        if( m_sfile.eof() ) {
+            return false;
+        }
+        getline( m_sfile, m_line );
+        a_line = m_line;
+        return true;
+    }
+
+    if( m_atEnd ) {
+        return false;
+    }
+    const char* start = m_data + m_position;
+    const char* newline = static_cast<const char*>( memchr( start, '\n', m_size - m_position ) );
+    if( newline == nullptr ) {
+        a_line = std::string_view( start, m_size - m_position );
+        m_position = m_size;
+        m_atEnd = true;
+        return true;
+    }
+    a_line = std::string_view( start, newline - start );
+    m_position = newline - m_data + 1;
+#ifdef _WIN32
+    if( !a_line.empty() && a_line.back() == '\r' ) {
+        a_line.remove_suffix( 1 );
+    }
+#endif
+    return true;
+}
+
+
+/**/
+/*
+void FileAccess::rewind()
+
+NAME
+
+        FileAccess::rewind - Resets the file stream.
+
+SYNOPSIS
+
+        void FileAccess::rewind();
+
+DESCRIPTION
+
+        This method clears all file flags and resets the file stream, or the position in the mapped
+        text, to the beginning of the file. It is typically used when you want to read the file from
+        the beginning after reaching the end.
+
+*/
+/**/
+void FileAccess::rewind( )
+{
+    // Clean all file flags and go back to the beginning of the file.
+    m_position = 0;
+    m_atEnd = false;
+    if( m_data == nullptr ) {
+        m_sfile.clear();
+        m_sfile.seekg( 0, ios::beg );
+    }
+}
+    
@@ -1,43 +1,71 @@
-/*
-This class provides a basic mechanism for reading from a file line by line. It encapsulates an ifstream object (m_sfile) and provides methods for opening the 
-file (FileAccess constructor), getting the next line from the file (GetNextLine), and resetting the file stream to the beginning of the file (rewind). The destructor 
-(~FileAccess) ensures that the file is properly closed when we are done with it.
-*/
-
-#ifndef _FILEACCESS_H  // UNIX way of preventing multiple inclusions. 
-#define _FILEACCESS_H  // A unique identifier is set as a flag, preventing multiple inclusions of this header file.
-
-#include <fstream>  // For file stream operations
-#include <stdlib.h>
-#include <string>  // For string objects
-
-// The FileAccess class provides mechanisms for reading from a source file. 
-class FileAccess {
-
-public:
-
-    // Constructor. Opens the file specified by the command-line arguments.
-    // Throws an error if the file cannot be opened.
-    // argc is the number of command-line arguments.
-    // argv is an array of command-line arguments.
-    FileAccess(int argc, char* argv[]);
-
-    // Destructor. Closes the source file.
-    ~FileAccess();
-
-    // Reads the next line from the source file.
-    // The read line is returned through the parameter a_line.
-    // Returns true if a line was successfully read, false otherwise (e.g., if end of file was reached).
-    bool GetNextLine(string& a_line);
-
-    // Resets the file stream to the beginning of the source file.
-    void rewind();
-
-private:
-
-    // An input file stream object used to read from the source file.
-    ifstream m_sfile;
-
-};
-
-#endif
+/*
+This class provides a basic mechanism for reading from a file line by line. When the source is a regular file, it is memory-mapped and each line
+is handed out as a view into the mapping, so reading copies nothing; anything that cannot be mapped, such as a pipe, is read as a stream
+(m_sfile) instead, one line at a time. The constructor opens the file, GetNextLine gets the next line, rewind goes back to the beginning, and the
+destructor releases the file when we are done with it.
+*/
+
+#ifndef _FILEACCESS_H  // UNIX way of preventing multiple inclusions. 
+#define _FILEACCESS_H  // A unique identifier is set as a flag, preventing multiple inclusions of this header file.
+
+#include <fstream>  // For file stream operations
+#include <stdlib.h>
+#include <string>  // For string objects
+#include <string_view>  // Lines are handed out as views.
+
+// The FileAccess class provides mechanisms for reading from a source file. 
+class FileAccess {
+
+public:
+
+    // Constructor. Opens the file named by the first command-line argument.
+    // Throws an error if the file cannot be opened.
+    // argc is the number of command-line arguments.
+    // argv is an array of command-line arguments.
+    FileAccess(int argc, char* argv[]);
+
+    // Destructor. Closes the source file.
+    ~FileAccess();
+
+    // Reads the next line from the source file.
+    // The read line is returned through the parameter a_line.
+    // Returns true if a line was successfully read, false otherwise (e.g., if end of file was reached).
+    bool GetNextLine(string& a_line);
+
+    // As above, but a_line is a view. It stays valid as long as this object when the file is mapped,
+    // and until the next call otherwise.
+    bool GetNextLine(std::string_view& a_line);
+
+    // Returns the whole text of the source file if it is mapped, otherwise an empty view.
+    std::string_view GetMappedText() const { return std::string_view(m_data, m_size); }
+
+    // Resets the file stream to the beginning of the source file.
+    void rewind();
+
+    // Returns the name of the source file as given on the command line.
+    const string& GetFileName() const { return m_fileName; }
+
+private:
+
+    // Maps the file a_fileName into memory. Returns false if it is not a regular file or cannot be mapped.
+    bool Map(const char* a_fileName);
+
+    // An input file stream object used to read from the source file when it is not mapped.
+    ifstream m_sfile;
+    string m_line;              // The last line read from m_sfile.
+
+    const char* m_data = nullptr;   // The mapped text of the source file, or null if it is read as a stream.
+    size_t m_size = 0;              // Length of the mapped text.
+    size_t m_position = 0;          // Start of the next line in the mapped text.
+    bool m_atEnd = false;           // The last line of the mapped text has been read.
+#ifdef _WIN32
+    void* m_fileHandle = nullptr;       // The file and its mapping object.
+    void* m_mappingHandle = nullptr;
+#endif
+
+    // The name of the source file.
+    string m_fileName;
+
+};
+
+#endif
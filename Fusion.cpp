@@ -0,0 +1,215 @@
+//
+//  Implementation of the superinstruction pass.
+//
+#include "stdafx.h"
+#include "Fusion.h"
+#include <sstream>
+
+// The patterns, longest first so that a triple is preferred to the pair it starts with.
+static const Fusion::Pattern s_patterns[] = {
+    { FUSED_ADD_SUB_BZ, 3, { 1, 2, 11 }, true, "add+sub+bz" },
+    { FUSED_ADD_SUB_BP, 3, { 1, 2, 12 }, true, "add+sub+bp" },
+    { FUSED_SUB_BZ, 2, { 2, 11, 0 }, true, "sub+bz" },
+    { FUSED_SUB_BM, 2, { 2, 10, 0 }, true, "sub+bm" },
+    { FUSED_SUB_BP, 2, { 2, 12, 0 }, true, "sub+bp" },
+    { FUSED_ADD_BZ, 2, { 1, 11, 0 }, true, "add+bz" },
+    { FUSED_ADD_BM, 2, { 1, 10, 0 }, true, "add+bm" },
+    { FUSED_ADD_BP, 2, { 1, 12, 0 }, true, "add+bp" },
+    { FUSED_ADD_B, 2, { 1, 9, 0 }, false, "add+b" },
+    { FUSED_SUB_B, 2, { 2, 9, 0 }, false, "sub+b" },
+    { FUSED_COPY_B, 2, { 5, 9, 0 }, false, "copy+b" },
+    { FUSED_COPY_BM, 2, { 5, 10, 0 }, false, "copy+bm" },
+    { FUSED_COPY_BZ, 2, { 5, 11, 0 }, false, "copy+bz" },
+    { FUSED_COPY_BP, 2, { 5, 12, 0 }, false, "copy+bp" }
+};
+
+// Returns the pattern table.
+const Fusion::Pattern* Fusion::GetPatterns(int& a_count)
+{
+    a_count = sizeof(s_patterns) / sizeof(s_patterns[0]);
+    return s_patterns;
+}
+
+/**/
+/*
+std::vector<DecodedInstruction> Fusion::Apply(const std::vector<DecodedInstruction>& a_code, const std::vector<long long>* a_profile, long long a_threshold)
+
+NAME
+
+        Fusion::Apply - Gives matching sequences their fused opcodes.
+
+SYNOPSIS
+
+        std::vector<DecodedInstruction> Fusion::Apply(const std::vector<DecodedInstruction>& a_code, const std::vector<long long>* a_profile,
+            long long a_threshold);
+            a_code         --> The verified program, with branch targets as cells.
+            a_profile      --> Executions of each cell in an earlier run, or null.
+            a_threshold    --> With a profile, the fewest executions for a cell to be fused.
+
+DESCRIPTION
+
+        This method tries every pattern, longest first, at every cell of a_code and replaces
+        the opcode of the first cell of the first match with the fused opcode. The operands
+        are left alone and so are the other cells of the sequence, because the fused handler
+        reads them from there and a branch may still land on them. A cell in the middle of
+        one sequence can start another.
+
+        With a profile, cells that ran fewer than a_threshold times are left unfused, so the
+        fused program only differs from the original where it was hot.
+
+RETURNS
+
+        Returns the fused copy of the program.
+*/
+/**/
+std::vector<DecodedInstruction> Fusion::Apply(const std::vector<DecodedInstruction>& a_code, const std::vector<long long>* a_profile,
+    long long a_threshold)
+{
+    std::vector<DecodedInstruction> fused = a_code;
+    for (int cell = 0; cell < static_cast<int>(a_code.size()); cell++) {
+        if (a_profile != nullptr && (cell >= static_cast<int>(a_profile->size()) || (*a_profile)[cell] < a_threshold)) {
+            continue;
+        }
+        for (const Pattern& pattern : s_patterns) {
+            if (Matches(a_code, cell, pattern)) {
+                fused[cell].opcode = pattern.fused;
+                break;
+            }
+        }
+    }
+    return fused;
+}
+
+// The opcodes must match in order and, if the pattern says so, the branch must test the word stored just before it.
+bool Fusion::Matches(const std::vector<DecodedInstruction>& a_code, int a_cell, const Pattern& a_pattern)
+{
+    if (a_cell + a_pattern.length > static_cast<int>(a_code.size())) {
+        return false;
+    }
+    for (int i = 0; i < a_pattern.length; i++) {
+        if (a_code[a_cell + i].opcode != a_pattern.opcodes[i]) {
+            return false;
+        }
+    }
+    const DecodedInstruction& branch = a_code[a_cell + a_pattern.length - 1];
+    const DecodedInstruction& last = a_code[a_cell + a_pattern.length - 2];
+    return !a_pattern.sameCell || branch.operand2 == last.operand1;
+}
+
+/**/
+/*
+int Fusion::CheckHandlers(std::ostream& a_report)
+
+NAME
+
+        Fusion::CheckHandlers - Proves the fused handlers against the unfused instructions.
+
+SYNOPSIS
+
+        int Fusion::CheckHandlers(std::ostream& a_report);
+            a_report    --> Where to write a line for each mismatch.
+
+DESCRIPTION
+
+        For each pattern this method assembles a small program by hand: three READs to load
+        the operands, the pattern itself, then a HALT where a branch that is not taken ends
+        up and a WRITE and HALT where a taken one does. For every combination of negative,
+        zero and positive operands, once with distinct operand words and once with every
+        operand the same word, it runs the program without fusion, and separately stores the
+        operands and calls the fused handler for the pattern through emulator::ExecuteFused.
+        The handler must continue at the cell the unfused run went to, taken or not, and leave
+        memory as the unfused run left it. Calling the handler directly checks it even in a
+        build whose loop never runs the fused program.
+
+RETURNS
+
+        Returns the number of patterns whose handler matched in every case.
+*/
+/**/
+int Fusion::CheckHandlers(std::ostream& a_report)
+{
+    // Operand words, well above the few cells of the test program.
+    const int x = 900, y = 901, z = 902;
+    const long long values[] = { -7, -1, 0, 1, 5 };
+
+    int passed = 0;
+    for (const Pattern& pattern : s_patterns) {
+        bool matched = true;
+        for (int aliased = 0; aliased < 2 && matched; aliased++) {
+
+            // The program, one machine word per cell. The pattern starts at cell 3.
+            std::vector<long long> program;
+            auto word = [](int a_opcode, int a_operand1, int a_operand2) {
+                return a_opcode * 10000000000LL + a_operand1 * 100000LL + a_operand2;
+            };
+            program.push_back(word(7, x, 0));
+            program.push_back(word(7, y, 0));
+            program.push_back(word(7, z, 0));
+            const int notTaken = 3 + pattern.length;
+            const int taken = notTaken + 1;
+            int stored = x;
+            for (int i = 0; i < pattern.length - 1; i++) {
+                const int dest = aliased ? x : (i == 0 ? x : z);
+                const int source = aliased ? x : (i == 0 ? y : x);
+                program.push_back(word(pattern.opcodes[i], dest, source));
+                stored = dest;
+            }
+            program.push_back(word(pattern.opcodes[pattern.length - 1], taken + 100, pattern.sameCell || aliased ? stored : y));
+            program.push_back(word(13, 0, 0));
+            program.push_back(word(8, x, 0));
+            program.push_back(word(13, 0, 0));
+
+            emulator fused, unfused;
+            unfused.SetFusing(false);
+            for (int cell = 0; cell < static_cast<int>(program.size()); cell++) {
+                fused.insertMemory(cell, program[cell]);
+                unfused.insertMemory(cell, program[cell]);
+            }
+            fused.TakeSnapshot();
+            unfused.TakeSnapshot();
+
+            for (long long a : values) {
+                for (long long b : values) {
+                    for (long long c : values) {
+                        std::ostringstream unfusedText;
+                        bool unfusedResult;
+                        {
+                            TapeInput input({ a, b, c });
+                            BufferedOutput output(unfusedText);
+                            unfused.Restore();
+                            unfused.SetDevices(input, output);
+                            unfusedResult = unfused.runProgram();
+                        }
+
+                        fused.Restore();
+                        fused.PokeMemory(x, a);
+                        fused.PokeMemory(y, b);
+                        fused.PokeMemory(z, c);
+                        const int next = fused.ExecuteFused(3);
+                        if (next < 0) {
+                            a_report << "Fusion mismatch: " << pattern.name << " was not fused" << std::endl;
+                            matched = false;
+                        }
+                        else if (!unfusedResult || next != (unfusedText.str().empty() ? notTaken : taken) ||
+                            fused.GetMemory() != unfused.GetMemory()) {
+                            a_report << "Fusion mismatch: " << pattern.name << (aliased ? " (aliased)" : "") << " with "
+                                << a << ", " << b << ", " << c << std::endl;
+                            matched = false;
+                        }
+                        if (!matched) {
+                            break;
+                        }
+                    }
+                    if (!matched) {
+                        break;
+                    }
+                }
+                if (!matched) {
+                    break;
+                }
+            }
+        }
+        passed += matched;
+    }
+    return passed;
+}
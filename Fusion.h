@@ -0,0 +1,68 @@
+/*
+The Fusion class is the superinstruction pass over a verified program. The hot loops of VC1620 programs are mostly short fixed idioms: an
+arithmetic instruction followed by a branch on the word it just computed, or an update followed by a jump back to the top of the loop. The pass
+finds these sequences with a static table of patterns and gives the first cell of each a fused opcode, whose handler in the emulator executes
+the whole sequence with one dispatch. The cells after the first keep their own instructions, so a branch into the middle of a sequence still
+finds them. A profile of an earlier run can limit fusion to the cells that were actually hot, and CheckHandlers proves every fused handler
+against the instructions it replaces.
+*/
+
+#ifndef _FUSION_H      // UNIX way of preventing multiple inclusions.
+#define _FUSION_H
+
+#include <iostream>     // The handler check reports to a stream.
+#include <vector>       // Vector is a container that encapsulates dynamic size arrays.
+#include "Emulator.h"   // The decoded instructions that are fused.
+
+// Opcodes of the fused handlers. They lie above every opcode a machine word can decode to.
+enum FusedOpcode {
+    FUSED_SUB_BZ = 100,     // SUB, then BRANCH ZERO on the difference.
+    FUSED_SUB_BM,           // SUB, then BRANCH MINUS on the difference.
+    FUSED_SUB_BP,           // SUB, then BRANCH POSITIVE on the difference.
+    FUSED_ADD_BZ,           // ADD, then BRANCH ZERO on the sum.
+    FUSED_ADD_BM,           // ADD, then BRANCH MINUS on the sum.
+    FUSED_ADD_BP,           // ADD, then BRANCH POSITIVE on the sum.
+    FUSED_ADD_B,            // ADD, then BRANCH.
+    FUSED_SUB_B,            // SUB, then BRANCH.
+    FUSED_COPY_B,           // COPY, then BRANCH.
+    FUSED_COPY_BM,          // COPY, then BRANCH MINUS.
+    FUSED_COPY_BZ,          // COPY, then BRANCH ZERO.
+    FUSED_COPY_BP,          // COPY, then BRANCH POSITIVE.
+    FUSED_ADD_SUB_BZ,       // ADD, SUB, then BRANCH ZERO on the difference.
+    FUSED_ADD_SUB_BP        // ADD, SUB, then BRANCH POSITIVE on the difference.
+};
+
+// Fusion replaces common instruction sequences with superinstructions.
+class Fusion {
+
+public:
+
+    // A sequence of instructions that has a fused handler.
+    struct Pattern {
+        int fused;          // The opcode of the handler.
+        int length;         // Number of instructions, 2 or 3.
+        int opcodes[3];     // The opcodes of the instructions, in order.
+        bool sameCell;      // The final branch must test the word the instruction before it stores.
+        const char* name;   // Name used in reports.
+    };
+
+    // Returns the table of patterns, longest first, and sets a_count to its size.
+    static const Pattern* GetPatterns(int& a_count);
+
+    // Returns a copy of a_code (a verified program, branch targets already cells) with each sequence that matches a pattern
+    // given the fused opcode of the pattern. If a_profile is not null, only sequences whose first cell ran at least
+    // a_threshold times in the profiled run are fused.
+    static std::vector<DecodedInstruction> Apply(const std::vector<DecodedInstruction>& a_code, const std::vector<long long>* a_profile,
+        long long a_threshold);
+
+    // Runs every fused handler against the instructions it replaces over a range of values and aliasings, writing a line
+    // for each mismatch to a_report. Returns the number of patterns that matched in every case.
+    static int CheckHandlers(std::ostream& a_report);
+
+private:
+
+    // Returns true if the instructions at a_cell match a_pattern.
+    static bool Matches(const std::vector<DecodedInstruction>& a_code, int a_cell, const Pattern& a_pattern);
+};
+
+#endif
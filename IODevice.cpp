@@ -0,0 +1,187 @@
+//
+//  Implementation of the emulator's I/O devices.
+//
+#include "stdafx.h"
+#include "IODevice.h"
+#include <charconv>
+#include <fstream>
+
+/**/
+/*
+bool ConsoleDevice::Read(long long& a_value)
+
+NAME
+
+        ConsoleDevice::Read - Reads a value from the console.
+
+SYNOPSIS
+
+        bool ConsoleDevice::Read(long long& a_value);
+            a_value    --> Receives the value entered.
+
+DESCRIPTION
+
+        This method prompts with "? " and reads a number from the input stream, as the
+        emulator's READ instruction has always done.
+
+RETURNS
+
+        Returns false if the input stream has ended or does not hold a number, otherwise true.
+*/
+/**/
+bool ConsoleDevice::Read(long long& a_value)
+{
+    m_out << "? ";
+    m_in >> a_value;
+    return !m_in.fail();
+}
+
+// Prints a value on a line of its own and flushes, so it is seen immediately.
+void ConsoleDevice::Write(long long a_value)
+{
+    m_out << a_value << endl;
+}
+
+// The console device used by default.
+ConsoleDevice& ConsoleDevice::Standard()
+{
+    static ConsoleDevice console;
+    return console;
+}
+
+/**/
+/*
+bool TapeInput::LoadFile(const std::string& a_file)
+
+NAME
+
+        TapeInput::LoadFile - Loads the tape from a file.
+
+SYNOPSIS
+
+        bool TapeInput::LoadFile(const std::string& a_file);
+            a_file    --> The file holding the values.
+
+DESCRIPTION
+
+        This method reads the whole of a_file in one go and loads the numbers in it onto the
+        tape with LoadText.
+
+RETURNS
+
+        Returns true if the file was read and every entry was a number, otherwise false.
+*/
+/**/
+bool TapeInput::LoadFile(const std::string& a_file)
+{
+    ifstream file(a_file, ios::in | ios::binary);
+    if (!file) {
+        return false;
+    }
+    ostringstream text;
+    text << file.rdbuf();
+    return LoadText(text.str());
+}
+
+/**/
+/*
+bool TapeInput::LoadText(const std::string& a_text)
+
+NAME
+
+        TapeInput::LoadText - Loads the tape from text.
+
+SYNOPSIS
+
+        bool TapeInput::LoadText(const std::string& a_text);
+            a_text    --> White space separated numbers.
+
+DESCRIPTION
+
+        This method replaces the tape with the numbers in a_text, parsed with from_chars, and
+        rewinds it to the first value.
+
+RETURNS
+
+        Returns true if every entry was a number, otherwise false. The numbers before a
+        malformed entry are kept.
+*/
+/**/
+bool TapeInput::LoadText(const std::string& a_text)
+{
+    m_values.clear();
+    m_position = 0;
+
+    const char* next = a_text.data();
+    const char* end = next + a_text.size();
+    for (;;) {
+        while (next != end && isspace(static_cast<unsigned char>(*next))) {
+            next++;
+        }
+        if (next == end) {
+            return true;
+        }
+        long long value;
+        from_chars_result parsed = from_chars(next, end, value);
+        if (parsed.ec != errc()) {
+            return false;
+        }
+        m_values.push_back(value);
+        next = parsed.ptr;
+    }
+}
+
+// Takes the next value off the queue.
+bool QueueInput::Read(long long& a_value)
+{
+    if (m_values.empty()) {
+        return false;
+    }
+    a_value = m_values.front();
+    m_values.pop_front();
+    return true;
+}
+
+/**/
+/*
+void BufferedOutput::Write(long long a_value)
+
+NAME
+
+        BufferedOutput::Write - Adds a value to the output block.
+
+SYNOPSIS
+
+        void BufferedOutput::Write(long long a_value);
+            a_value    --> The value to output.
+
+DESCRIPTION
+
+        This method formats a_value with to_chars, followed by a newline, straight into the
+        block. When the block cannot hold another value it is written to the stream first.
+
+*/
+/**/
+void BufferedOutput::Write(long long a_value)
+{
+    // A long long needs at most 20 characters, plus the newline.
+    const size_t MAX_LENGTH = 21;
+    if (m_block.size() + MAX_LENGTH > BLOCK_SIZE) {
+        Flush();
+    }
+
+    char digits[MAX_LENGTH];
+    to_chars_result formatted = to_chars(digits, digits + MAX_LENGTH, a_value);
+    *formatted.ptr++ = '\n';
+    m_block.append(digits, formatted.ptr);
+}
+
+// Writes the buffered block to the stream.
+void BufferedOutput::Flush()
+{
+    if (!m_block.empty()) {
+        m_out.write(m_block.data(), m_block.size());
+        m_out.flush();
+        m_block.clear();
+    }
+}
@@ -0,0 +1,144 @@
+/*
+These classes are the I/O devices the emulator's READ and WRITE instructions talk to. An InputDevice supplies the values READ stores and an
+OutputDevice receives the values WRITE produces. ConsoleDevice is the interactive prompt the emulator has always used, TapeInput replays values
+loaded from a file or a buffer, QueueInput hands over values supplied while the program runs, and BufferedOutput collects formatted values and
+writes them out in large blocks.
+*/
+
+#ifndef _IODEVICE_H      // UNIX way of preventing multiple inclusions.
+#define _IODEVICE_H
+
+#include <deque>    // Values queued for QueueInput.
+#include <iostream> // Streams the console and buffered devices work on.
+#include <string>   // For string objects
+#include <vector>   // Vector is a container that encapsulates dynamic size arrays.
+
+// Source of the values read by the READ instruction.
+class InputDevice {
+
+public:
+
+    virtual ~InputDevice() {}
+
+    // Supplies the next value. Returns false if there is no more input.
+    virtual bool Read(long long& a_value) = 0;
+
+    // Returns true if a value is not available yet but may be later. emulator::Run then waits instead of reading.
+    virtual bool WouldBlock() const { return false; }
+};
+
+// Destination of the values written by the WRITE instruction.
+class OutputDevice {
+
+public:
+
+    virtual ~OutputDevice() {}
+
+    // Accepts one value.
+    virtual void Write(long long a_value) = 0;
+
+    // Passes on anything held back. The emulator calls this at the end of every run.
+    virtual void Flush() {}
+
+    // Returns true if the device cannot take another value yet. emulator::Run then waits instead of writing.
+    virtual bool IsFull() const { return false; }
+};
+
+// The interactive console: READ prompts with "? " and waits for a value, WRITE prints one value per line and flushes.
+class ConsoleDevice : public InputDevice, public OutputDevice {
+
+public:
+
+    // Constructor. The defaults are the standard input and output streams.
+    ConsoleDevice(std::istream& a_in = std::cin, std::ostream& a_out = std::cout) : m_in(a_in), m_out(a_out) {}
+
+    bool Read(long long& a_value) override;
+    void Write(long long a_value) override;
+
+    // The console device on cin and cout shared by every emulator that has not been given other devices.
+    static ConsoleDevice& Standard();
+
+private:
+
+    std::istream& m_in;
+    std::ostream& m_out;
+};
+
+// A pre-loaded input tape: READ takes the next value from a list loaded up front.
+class TapeInput final : public InputDevice {
+
+public:
+
+    // Constructor. a_values are the values READ returns, in order.
+    explicit TapeInput(const std::vector<long long>& a_values = std::vector<long long>()) : m_values(a_values) {}
+
+    // Replaces the tape with the white space separated numbers in a_file. Returns false if it cannot be read.
+    bool LoadFile(const std::string& a_file);
+
+    // Replaces the tape with the white space separated numbers in a_text. Returns false on a malformed number.
+    bool LoadText(const std::string& a_text);
+
+    // Takes the next value off the tape. Defined here so the emulator's tape instantiation can inline it.
+    bool Read(long long& a_value) override
+    {
+        if (m_position >= m_values.size()) {
+            return false;
+        }
+        a_value = m_values[m_position++];
+        return true;
+    }
+
+    // Number of values read so far.
+    size_t GetPosition() const { return m_position; }
+
+private:
+
+    std::vector<long long> m_values;
+    size_t m_position = 0;
+};
+
+// An input queue fed while the program runs. READ waits while the queue is empty, until Close says no more values will come.
+// The queue is not synchronized; push values from the thread that calls emulator::Run, between calls.
+class QueueInput : public InputDevice {
+
+public:
+
+    // Adds a value for READ.
+    void Push(long long a_value) { m_values.push_back(a_value); }
+
+    // Marks the end of the input. Once the queue is empty READ then fails instead of waiting.
+    void Close() { m_closed = true; }
+
+    bool Read(long long& a_value) override;
+    bool WouldBlock() const override { return m_values.empty() && !m_closed; }
+
+private:
+
+    std::deque<long long> m_values;
+    bool m_closed = false;
+};
+
+// An output sink that formats values with to_chars into a block and writes the block to a stream only when it is full or flushed.
+class BufferedOutput final : public OutputDevice {
+
+public:
+
+    // Size of the block collected before it is written out.
+    const static size_t BLOCK_SIZE = 64 * 1024;
+
+    // Constructor. a_out is the stream the blocks are written to.
+    explicit BufferedOutput(std::ostream& a_out = std::cout) : m_out(a_out) { m_block.reserve(BLOCK_SIZE); }
+
+    // Destructor. Writes out anything still buffered.
+    ~BufferedOutput() { Flush(); }
+
+    void Write(long long a_value) override;
+    void Flush() override;
+
+private:
+
+    std::ostream& m_out;
+    std::string m_block;
+};
+
+#endif
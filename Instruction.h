@@ -1,79 +1,99 @@
-/*
-The Instruction class is responsible for parsing and providing information about an assembly language instruction. This includes the opcode, any operands, and labels associated with the instruction. 
-This class also handles the classification of the instruction type (machine language, assembler instruction, comment, or end instruction). Various helper functions are used to parse a line of 
-assembly language and extract the relevant components.
-*/
-
-#pragma once  // Ensures the header file is only included once during compilation
-
-#include <string>  // For std::string objects
-using namespace std;  // Make std namespace available to the code
-
-// The Instruction class is responsible for parsing and providing information
-// about instructions in an assembly language.
-class Instruction {
-
-public:
-
-    // Default constructor and destructor.
-    Instruction() { };
-    ~Instruction() { };
-
-    // InstructionType is an enumeration that represents the type of instruction.
-    enum InstructionType {
-        ST_MachineLanguage,  // A machine language instruction.
-        ST_AssemblerInstr,   // Assembler Language instruction.
-        ST_Comment,          // Comment or blank line
-        ST_End               // End instruction.
-    };
-
-    // The ParseInstruction method takes a line from the assembly code 
-    // and classifies its type (machine language, assembler instruction, comment, or end).
-    InstructionType ParseInstruction(string a_line);
-
-    // The LocationNextInstruction method calculates the location of the next instruction 
-    // based on the current location.
-    int LocationNextInstruction(int a_loc);
-
-    // The GetLabel method returns the label of the current instruction, if it exists.
-    inline string& GetLabel() { return m_Label; };
-
-    // The isLabel method checks if the current instruction has a label.
-    inline bool isLabel() { return !m_Label.empty(); };
-
-    // The GetNumericOpcode method returns the numeric opcode of the current instruction.
-    inline int GetNumericOpcode() const { return m_NumOpCode; };
-
-    // The GetOpcode method returns the opcode of the current instruction.
-    inline const string& GetOpcode() const { return m_OpCode; };
-
-    // The GetOperand1 method returns the first operand of the current instruction.
-    inline const string& GetOperand1() const { return m_Operand1; };
-
-    // The GetOperand2 method returns the second operand of the current instruction.
-    inline const string& GetOperand2() const { return m_Operand2; };
-
-private:
-
-    // The RemoveComment method removes any comment present in the line.
-    string RemoveComment(string line);
-
-    // The ParseLine method parses a line into label, opcode, and operands.
-    bool ParseLine(const string& line, string& label, string& opcode, string& operand1, string& operand2);
-
-    // The trim method removes leading and trailing white space from a string.
-    string trim(const string& str);
-
-    // Private member variables representing the elements of an instruction
-    string m_Label;
-    string m_OpCode;
-    string m_Operand1;
-    string m_Operand2;
-    string m_instruction;
-
-    // Derived values from an instruction
-    int m_NumOpCode;
-    InstructionType m_type;
-    bool m_IsNumericOperand;
-    int m_OperandValue;
-};
+/*
+The Instruction class is responsible for parsing and providing information about an assembly language instruction. This includes the opcode, any operands, and labels associated with the instruction. 
+This class also handles the classification of the instruction type (machine language, assembler instruction, comment, or end instruction). Various helper functions are used to parse a line of 
+assembly language and extract the relevant components.
+*/
+
+#pragma once  // Ensures the header file is only included once during compilation
+
+#include <string>  // For std::string objects
+#include <string_view>  // The fields of a line are views into it
+using namespace std;  // Make std namespace available to the code
+
+struct IsaEntry;
+struct LexedLine;
+
+// The Instruction class is responsible for parsing and providing information
+// about instructions in an assembly language.
+class Instruction {
+
+public:
+
+    // Default constructor and destructor.
+    Instruction() { };
+    ~Instruction() { };
+
+    // InstructionType is an enumeration that represents the type of instruction.
+    enum InstructionType {
+        ST_MachineLanguage,  // A machine language instruction.
+        ST_AssemblerInstr,   // Assembler Language instruction.
+        ST_Comment,          // Comment or blank line
+        ST_End               // End instruction.
+    };
+
+    // The ParseInstruction method takes a line from the assembly code 
+    // and classifies its type (machine language, assembler instruction, comment, or end).
+    // The label and operands are views into a_line, valid for as long as it is.
+    InstructionType ParseInstruction(std::string_view a_line);
+
+    // As above, taking the fields from a_tokens, the Lexer's tokens of a_line, instead of scanning for them.
+    InstructionType ParseInstruction(std::string_view a_line, const LexedLine& a_tokens);
+
+    // The LocationNextInstruction method calculates the location of the next instruction 
+    // based on the current location.
+    int LocationNextInstruction(int a_loc);
+
+    // The GetLabel method returns the label of the current instruction, if it exists.
+    inline std::string_view GetLabel() const { return m_Label; };
+
+    // The isLabel method checks if the current instruction has a label.
+    inline bool isLabel() { return !m_Label.empty(); };
+
+    // The GetNumericOpcode method returns the numeric opcode of the current instruction.
+    inline int GetNumericOpcode() const { return m_NumOpCode; };
+
+    // The GetOpcode method returns the opcode of the current instruction.
+    inline const string& GetOpcode() const { return m_OpCode; };
+
+    // The GetOperand1 method returns the first operand of the current instruction.
+    inline std::string_view GetOperand1() const { return m_Operand1; };
+
+    // The GetOperand2 method returns the second operand of the current instruction.
+    inline std::string_view GetOperand2() const { return m_Operand2; };
+
+    // The CountOperands method returns the number of operands the current instruction was given.
+    inline int CountOperands() const { return !m_Operand1.empty() + !m_Operand2.empty(); };
+
+    // The GetArity method returns the number of operands the instruction set table says the opcode takes,
+    // or -1 if the opcode is not in the table.
+    int GetArity() const;
+
+private:
+
+    // The RemoveComment method removes any comment present in the line.
+    std::string_view RemoveComment(std::string_view line);
+
+    // The ParseLine method parses a line into label, opcode, and operands.
+    bool ParseLine(std::string_view line, std::string_view& label, std::string_view& opcode, std::string_view& operand1, std::string_view& operand2);
+
+    // The Classify method sets the fields of the instruction and classifies it by its opcode.
+    InstructionType Classify(std::string_view label, std::string_view opcode, std::string_view operand1, std::string_view operand2);
+
+    // The trim method removes leading and trailing white space from a string.
+    string trim(const string& str);
+
+    // Private member variables representing the elements of an instruction.
+    // The opcode is a lower case copy; the rest are views into the line parsed.
+    std::string_view m_Label;
+    string m_OpCode;
+    std::string_view m_Operand1;
+    std::string_view m_Operand2;
+    string m_instruction;
+
+    // Derived values from an instruction
+    const IsaEntry* m_entry = nullptr;  // The instruction set entry of the opcode, or null if it has none.
+    int m_NumOpCode;
+    InstructionType m_type;
+    bool m_IsNumericOperand;
+    int m_OperandValue;
+};
@@ -0,0 +1,166 @@
+/*
+The Isa class describes the instruction set of the VC1620 in one constexpr table: every mnemonic the assembler accepts, with the type of
+statement it makes, its numeric opcode, the number of words it occupies and the number of operands it takes. Mnemonics are looked up through a
+perfect hash whose seed and slots are computed by the compiler from the table, so a lookup is one hash, one slot and one comparison. The
+parser, the location counter, the operand-count check, the emulator's handler tables and the statistics all take their opcodes, mnemonics
+and arities from here, so a new mnemonic, or a new number for an old one, is a change to one row.
+*/
+
+#ifndef _ISA_H      // UNIX way of preventing multiple inclusions.
+#define _ISA_H
+
+#include <array>            // The slots of the perfect hash.
+#include <string_view>      // Mnemonics are compared as views.
+#include "Instruction.h"    // The types of statement.
+
+// The number of words a statement occupies.
+enum IsaLength {
+    IL_Word,        // One word.
+    IL_Operand,     // As many words as its first operand says: ds.
+    IL_None         // None: org.
+};
+
+// One mnemonic of the instruction set.
+struct IsaEntry {
+    std::string_view mnemonic;              // The mnemonic, in lower case.
+    Instruction::InstructionType type;      // Machine instruction, assembler instruction or end.
+    int opcode;                             // Numeric opcode of a machine instruction, 0 for the others.
+    IsaLength length;                       // The number of words the statement occupies.
+    int operands;                           // The number of operands it takes.
+};
+
+// Isa looks up the instruction set table.
+class Isa {
+
+public:
+
+    // Number of slots in the perfect hash. A power of two at least twice the number of mnemonics.
+    static constexpr int SLOTS = 64;
+
+    // Returns the entry for a_mnemonic, which must be in lower case, or null if there is none.
+    static constexpr const IsaEntry* Find(std::string_view a_mnemonic);
+
+    // Returns the numeric opcode of the machine instruction a_mnemonic. Evaluated by the compiler, which
+    // rejects a mnemonic that is not a machine instruction.
+    static consteval int Opcode(std::string_view a_mnemonic);
+
+    // Returns the mnemonic of the machine instruction with numeric opcode a_opcode, or null if there is none.
+    static constexpr const char* Mnemonic(int a_opcode);
+
+    // The hash of a_mnemonic with seed a_seed: FNV-1a with the seed as its offset basis.
+    static constexpr unsigned Hash(std::string_view a_mnemonic, unsigned a_seed)
+    {
+        unsigned hash = a_seed;
+        for (char c : a_mnemonic) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+        }
+        return hash;
+    }
+
+    // Returns the first seed for which every mnemonic hashes to a slot of its own.
+    static constexpr unsigned FindSeed();
+
+    // Returns the index in ISA_TABLE of the mnemonic in each slot, or -1 for an empty slot.
+    static constexpr std::array<signed char, SLOTS> BuildSlots();
+};
+
+// The instruction set. The mnemonics of the machine instructions are stored as the null-terminated
+// strings they are written as, so Mnemonic can hand them out.
+inline constexpr IsaEntry ISA_TABLE[] = {
+    //  mnemonic    type                                opcode  length      operands
+    { "add",        Instruction::ST_MachineLanguage,    1,      IL_Word,    2 },
+    { "sub",        Instruction::ST_MachineLanguage,    2,      IL_Word,    2 },
+    { "mult",       Instruction::ST_MachineLanguage,    3,      IL_Word,    2 },
+    { "div",        Instruction::ST_MachineLanguage,    4,      IL_Word,    2 },
+    { "copy",       Instruction::ST_MachineLanguage,    5,      IL_Word,    2 },
+    { "read",       Instruction::ST_MachineLanguage,    7,      IL_Word,    1 },
+    { "write",      Instruction::ST_MachineLanguage,    8,      IL_Word,    1 },
+    { "b",          Instruction::ST_MachineLanguage,    9,      IL_Word,    1 },
+    { "bm",         Instruction::ST_MachineLanguage,    10,     IL_Word,    2 },
+    { "bz",         Instruction::ST_MachineLanguage,    11,     IL_Word,    2 },
+    { "bp",         Instruction::ST_MachineLanguage,    12,     IL_Word,    2 },
+    { "halt",       Instruction::ST_MachineLanguage,    13,     IL_Word,    0 },
+    { "org",        Instruction::ST_AssemblerInstr,     0,      IL_None,    1 },
+    { "dc",         Instruction::ST_AssemblerInstr,     0,      IL_Word,    1 },
+    { "ds",         Instruction::ST_AssemblerInstr,     0,      IL_Operand, 1 },
+    { "end",        Instruction::ST_End,                0,      IL_Word,    0 },
+};
+
+inline constexpr int ISA_SIZE = sizeof(ISA_TABLE) / sizeof(ISA_TABLE[0]);
+
+static_assert(2 * ISA_SIZE <= Isa::SLOTS, "The perfect hash needs more slots");
+
+// Tries seeds in turn until the mnemonics are spread without a collision.
+constexpr unsigned Isa::FindSeed()
+{
+    for (unsigned seed = 2166136261u; ; seed++) {
+        bool used[SLOTS] = {};
+        bool collides = false;
+        for (const IsaEntry& entry : ISA_TABLE) {
+            const unsigned slot = Hash(entry.mnemonic, seed) % SLOTS;
+            collides = collides || used[slot];
+            used[slot] = true;
+        }
+        if (!collides) {
+            return seed;
+        }
+    }
+}
+
+inline constexpr unsigned ISA_SEED = Isa::FindSeed();
+
+constexpr std::array<signed char, Isa::SLOTS> Isa::BuildSlots()
+{
+    std::array<signed char, SLOTS> slots = {};
+    for (signed char& slot : slots) {
+        slot = -1;
+    }
+    for (int i = 0; i < ISA_SIZE; i++) {
+        slots[Hash(ISA_TABLE[i].mnemonic, ISA_SEED) % SLOTS] = static_cast<signed char>(i);
+    }
+    return slots;
+}
+
+inline constexpr std::array<signed char, Isa::SLOTS> ISA_SLOTS = Isa::BuildSlots();
+
+// Length of the longest mnemonic; anything longer is not looked up at all.
+inline constexpr size_t ISA_LONGEST = [] {
+    size_t longest = 0;
+    for (const IsaEntry& entry : ISA_TABLE) {
+        longest = entry.mnemonic.size() > longest ? entry.mnemonic.size() : longest;
+    }
+    return longest;
+}();
+
+// The only mnemonic that can be in a_mnemonic's slot is the one that hashes there.
+constexpr const IsaEntry* Isa::Find(std::string_view a_mnemonic)
+{
+    if (a_mnemonic.size() > ISA_LONGEST) {
+        return nullptr;
+    }
+    const int index = ISA_SLOTS[Hash(a_mnemonic, ISA_SEED) % SLOTS];
+    return index >= 0 && ISA_TABLE[index].mnemonic == a_mnemonic ? &ISA_TABLE[index] : nullptr;
+}
+
+// Throwing stops the compiler evaluating the call, which makes it an error.
+consteval int Isa::Opcode(std::string_view a_mnemonic)
+{
+    const IsaEntry* entry = Find(a_mnemonic);
+    if (entry == nullptr || entry->type != Instruction::ST_MachineLanguage) {
+        throw "not a machine instruction";
+    }
+    return entry->opcode;
+}
+
+// Searches the table; only used to name opcodes in reports.
+constexpr const char* Isa::Mnemonic(int a_opcode)
+{
+    for (const IsaEntry& entry : ISA_TABLE) {
+        if (entry.type == Instruction::ST_MachineLanguage && entry.opcode == a_opcode) {
+            return entry.mnemonic.data();
+        }
+    }
+    return nullptr;
+}
+
+#endif
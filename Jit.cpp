@@ -0,0 +1,356 @@
+//
+//  Implementation of the x86-64 basic-block JIT used by the emulator.
+//
+#include "stdafx.h"
+#include "Jit.h"
+#include <algorithm>
+
+#if defined(VC_JIT_X64) && !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+// Size of the executable buffer. When it fills up every block is dropped and compilation starts over.
+static const size_t JIT_BUFFER_SIZE = 1 << 20;
+
+// Value of m_hits for a cell where no block can start (for example a READ), so it is not retried.
+static const unsigned short JIT_NEVER = 0xFFFF;
+
+/**/
+/*
+JitCompiler::JitCompiler(int a_codeLimit)
+
+NAME
+
+        JitCompiler::JitCompiler - Constructor for the JitCompiler class.
+
+SYNOPSIS
+
+        JitCompiler::JitCompiler(int a_codeLimit);
+            a_codeLimit    --> The number of pre-decoded cells that blocks may be compiled from.
+
+DESCRIPTION
+
+        This constructor reserves a buffer of memory that is readable, writable and executable,
+        using VirtualAlloc on Windows and mmap elsewhere. If the host is not x86-64, or the
+        operating system refuses the buffer, IsAvailable will report false and the emulator
+        interprets the program instead.
+
+*/
+/**/
+JitCompiler::JitCompiler(int a_codeLimit)
+    : m_codeLimit(a_codeLimit), m_blockAt(a_codeLimit, -1), m_hits(a_codeLimit, 0)
+{
+#if defined(VC_JIT_X64) && defined(_WIN32)
+    void* buffer = VirtualAlloc(nullptr, JIT_BUFFER_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+    if (buffer != nullptr) {
+        m_buffer = static_cast<unsigned char*>(buffer);
+        m_bufferSize = JIT_BUFFER_SIZE;
+    }
+#elif defined(VC_JIT_X64)
+    void* buffer = mmap(nullptr, JIT_BUFFER_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer != MAP_FAILED) {
+        m_buffer = static_cast<unsigned char*>(buffer);
+        m_bufferSize = JIT_BUFFER_SIZE;
+    }
+#endif
+}
+
+/**/
+/*
+JitCompiler::~JitCompiler()
+
+NAME
+
+        JitCompiler::~JitCompiler - Destructor for the JitCompiler class.
+
+SYNOPSIS
+
+        JitCompiler::~JitCompiler();
+
+DESCRIPTION
+
+        This destructor returns the executable buffer to the operating system.
+
+*/
+/**/
+JitCompiler::~JitCompiler()
+{
+    if (m_buffer == nullptr) {
+        return;
+    }
+#if defined(VC_JIT_X64) && defined(_WIN32)
+    VirtualFree(m_buffer, 0, MEM_RELEASE);
+#elif defined(VC_JIT_X64)
+    munmap(m_buffer, m_bufferSize);
+#endif
+}
+
+/**/
+/*
+const JitCompiler::Block* JitCompiler::Enter(int a_cell, const DecodedInstruction* a_decoded)
+
+NAME
+
+        JitCompiler::Enter - Looks up the compiled block for a cell.
+
+SYNOPSIS
+
+        const JitCompiler::Block* JitCompiler::Enter(int a_cell, const DecodedInstruction* a_decoded);
+            a_cell       --> The cell execution has reached. It must be below the code limit.
+            a_decoded    --> The emulator's pre-decoded program.
+
+DESCRIPTION
+
+        This method returns the cached block that starts at a_cell. If there is none, it
+        counts the visit and compiles a block once the cell has been visited HOT_THRESHOLD
+        times, so code that only runs a few times is never compiled.
+
+RETURNS
+
+        Returns the block to execute, or nullptr if the interpreter should execute the cell.
+*/
+/**/
+const JitCompiler::Block* JitCompiler::Enter(int a_cell, const DecodedInstruction* a_decoded)
+{
+    int index = m_blockAt[a_cell];
+    if (index >= 0) {
+        return &m_blocks[index];
+    }
+    if (m_buffer == nullptr || m_hits[a_cell] == JIT_NEVER || ++m_hits[a_cell] < HOT_THRESHOLD) {
+        return nullptr;
+    }
+
+    index = Compile(a_cell, a_decoded);
+    if (index < 0) {
+        m_hits[a_cell] = JIT_NEVER;
+        return nullptr;
+    }
+    return &m_blocks[index];
+}
+
+/**/
+/*
+void JitCompiler::InvalidateCell(int a_cell)
+
+NAME
+
+        JitCompiler::InvalidateCell - Drops the blocks compiled from a cell.
+
+SYNOPSIS
+
+        void JitCompiler::InvalidateCell(int a_cell);
+            a_cell    --> The cell that has been written.
+
+DESCRIPTION
+
+        This method removes every block whose range includes a_cell from the cache, so they
+        are recompiled from the new contents when they become hot again. Blocks are at most
+        MAX_BLOCK_LENGTH cells long, so only the starts just before a_cell need checking.
+        Their code stays in the buffer until the next flush.
+
+*/
+/**/
+void JitCompiler::InvalidateCell(int a_cell)
+{
+    int first = a_cell - MAX_BLOCK_LENGTH + 1;
+    for (int start = first < 0 ? 0 : first; start <= a_cell && start < m_codeLimit; start++) {
+        int index = m_blockAt[start];
+        if (index >= 0 && a_cell < start + m_blocks[index].length) {
+            m_blocks[index].code = nullptr;
+            m_blockAt[start] = -1;
+        }
+        // The cell may now start (or end) a block differently, so let it warm up again.
+        m_hits[start] = 0;
+    }
+}
+
+/**/
+/*
+void JitCompiler::Flush()
+
+NAME
+
+        JitCompiler::Flush - Discards every compiled block.
+
+SYNOPSIS
+
+        void JitCompiler::Flush();
+
+DESCRIPTION
+
+        This method empties the block cache and makes the whole executable buffer available
+        again. It is used when the buffer is full.
+
+*/
+/**/
+void JitCompiler::Flush()
+{
+    m_blocks.clear();
+    std::fill(m_blockAt.begin(), m_blockAt.end(), -1);
+    m_bufferUsed = 0;
+}
+
+// Appends bytes to the block being compiled.
+void JitCompiler::Emit(std::initializer_list<unsigned char> a_bytes)
+{
+    m_code.insert(m_code.end(), a_bytes);
+}
+
+// Appends a little-endian 32-bit value to the block being compiled.
+void JitCompiler::Emit32(int a_value)
+{
+    for (int i = 0; i < 4; i++) {
+        m_code.push_back(static_cast<unsigned char>((static_cast<unsigned>(a_value) >> (8 * i)) & 0xFF));
+    }
+}
+
+/**/
+/*
+int JitCompiler::Compile(int a_cell, const DecodedInstruction* a_decoded)
+
+NAME
+
+        JitCompiler::Compile - Compiles the basic block starting at a cell.
+
+SYNOPSIS
+
+        int JitCompiler::Compile(int a_cell, const DecodedInstruction* a_decoded);
+            a_cell       --> The first cell of the block.
+            a_decoded    --> The emulator's pre-decoded program.
+
+DESCRIPTION
+
+        This method translates the instructions from a_cell onwards into x86-64 code. The
+        generated function receives the base of simulated memory in its first argument
+        register (rcx on Windows, rdi elsewhere), copies it to r11 and addresses every
+        operand as [r11 + 8 * address]. ADD, SUB, MULT and COPY become one to three
+        instructions each, and a branch ends the block by returning either its target or
+        the following cell. The block also ends, without the instruction, at DIV, READ,
+        WRITE and HALT, which are left to the interpreter, and straight after any store
+        into the decoded code, so the emulator can re-decode the written cell before
+        anything compiled from it runs.
+
+RETURNS
+
+        Returns the index of the new block in m_blocks, or -1 if the first instruction cannot
+        be compiled or the JIT is not available on this host.
+*/
+/**/
+int JitCompiler::Compile(int a_cell, const DecodedInstruction* a_decoded)
+{
+#ifdef VC_JIT_X64
+    Block block;
+    block.start = a_cell;
+    block.length = 0;
+    block.code = nullptr;
+
+    m_code.clear();
+#ifdef _WIN32
+    Emit({ 0x49, 0x89, 0xCB });             // mov r11, rcx
+#else
+    Emit({ 0x49, 0x89, 0xFB });             // mov r11, rdi
+#endif
+
+    int pc = a_cell;
+    bool ended = false;
+    bool returned = false;      // True once a branch has emitted its own return.
+    while (!ended && pc < m_codeLimit && block.length < MAX_BLOCK_LENGTH) {
+        const DecodedInstruction& inst = a_decoded[pc];
+        const int disp1 = inst.operand1 * 8;
+        const int disp2 = inst.operand2 * 8;
+        bool writes = false;
+
+        switch (inst.opcode) {
+        case 1:  // ADD
+            Emit({ 0x49, 0x8B, 0x83 }); Emit32(disp2);          // mov rax, [r11 + disp2]
+            Emit({ 0x49, 0x01, 0x83 }); Emit32(disp1);          // add [r11 + disp1], rax
+            writes = true;
+            break;
+        case 2:  // SUB
+            Emit({ 0x49, 0x8B, 0x83 }); Emit32(disp2);          // mov rax, [r11 + disp2]
+            Emit({ 0x49, 0x29, 0x83 }); Emit32(disp1);          // sub [r11 + disp1], rax
+            writes = true;
+            break;
+        case 3:  // MULT
+            Emit({ 0x49, 0x8B, 0x83 }); Emit32(disp1);          // mov rax, [r11 + disp1]
+            Emit({ 0x49, 0x0F, 0xAF, 0x83 }); Emit32(disp2);    // imul rax, [r11 + disp2]
+            Emit({ 0x49, 0x89, 0x83 }); Emit32(disp1);          // mov [r11 + disp1], rax
+            writes = true;
+            break;
+        case 5:  // COPY
+            Emit({ 0x49, 0x8B, 0x83 }); Emit32(disp2);          // mov rax, [r11 + disp2]
+            Emit({ 0x49, 0x89, 0x83 }); Emit32(disp1);          // mov [r11 + disp1], rax
+            writes = true;
+            break;
+        case 4:  // DIV
+        case 7:  // READ
+        case 8:  // WRITE
+        case 13: // HALT
+            // Left to the interpreter; the block returns the cell of this instruction.
+            ended = true;
+            continue;
+        case 9:  // BRANCH
+            Emit({ 0xB8 }); Emit32(inst.operand1 - 100);        // mov eax, target
+            Emit({ 0xC3 });                                     // ret
+            ended = returned = true;
+            break;
+        case 10: // BRANCH MINUS
+        case 11: // BRANCH ZERO
+        case 12: // BRANCH POSITIVE
+        {
+            const unsigned char jcc = inst.opcode == 10 ? 0x7C : inst.opcode == 11 ? 0x74 : 0x7F;  // jl, je, jg
+            Emit({ 0x49, 0x83, 0xBB }); Emit32(disp2); Emit({ 0x00 });  // cmp qword [r11 + disp2], 0
+            Emit({ jcc, 0x06 });                                // jcc taken
+            Emit({ 0xB8 }); Emit32(pc + 1);                     // mov eax, next cell
+            Emit({ 0xC3 });                                     // ret
+            Emit({ 0xB8 }); Emit32(inst.operand1 - 100);        // taken: mov eax, target
+            Emit({ 0xC3 });                                     // ret
+            ended = returned = true;
+            break;
+        }
+        default: // No-op
+            break;
+        }
+
+        pc++;
+        block.length++;
+
+        if (writes) {
+            const int page = inst.operand1 / emulator::PAGE_WORDS;
+            if (std::find(block.dirtyPages.begin(), block.dirtyPages.end(), page) == block.dirtyPages.end()) {
+                block.dirtyPages.push_back(page);
+            }
+        }
+
+        // A store into the decoded code ends the block so the cell can be re-decoded first.
+        if (writes && inst.operand1 < m_codeLimit) {
+            block.codeWrites.push_back(inst.operand1);
+            ended = true;
+        }
+    }
+
+    if (block.length == 0) {
+        return -1;
+    }
+    if (!returned) {
+        Emit({ 0xB8 }); Emit32(pc);                             // mov eax, next cell
+        Emit({ 0xC3 });                                         // ret
+    }
+
+    if (m_bufferUsed + m_code.size() > m_bufferSize) {
+        Flush();
+    }
+    unsigned char* entry = m_buffer + m_bufferUsed;
+    std::copy(m_code.begin(), m_code.end(), entry);
+    m_bufferUsed += m_code.size();
+
+    block.code = reinterpret_cast<BlockFunction>(entry);
+    m_blocks.push_back(block);
+    m_blockAt[a_cell] = static_cast<int>(m_blocks.size() - 1);
+    return m_blockAt[a_cell];
+#else
+    (void)a_cell;
+    (void)a_decoded;
+    return -1;
+#endif
+}
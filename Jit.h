@@ -0,0 +1,84 @@
+/*
+The JitCompiler class translates hot basic blocks of decoded VC1620 code into native x86-64 code. Blocks are compiled into an executable buffer once
+they have been entered often enough, kept in a cache keyed by the cell they start at, and dropped again when a program writes into one of the cells
+they were compiled from. Only straight-line ADD, SUB, MULT and COPY sequences ending in a branch are compiled; everything else is left to the interpreter.
+*/
+
+#ifndef _JIT_H      // UNIX way of preventing multiple inclusions.
+#define _JIT_H
+
+#include <vector>       // Vector is a container that encapsulates dynamic size arrays.
+#include <initializer_list>
+#include "Emulator.h"   // For DecodedInstruction.
+
+// The JIT is only available when the emulator itself is built for x86-64.
+#if defined(_M_X64) || defined(__x86_64__)
+#define VC_JIT_X64
+#endif
+
+// JitCompiler owns the executable buffer and the block cache used by the emulator's JIT engine.
+class JitCompiler {
+
+public:
+
+    // A compiled block takes the base of simulated memory and returns the cell to continue at.
+    typedef int (*BlockFunction)(long long* a_memory);
+
+    // A compiled basic block.
+    struct Block {
+        int start;                  // First cell of the block.
+        int length;                 // Number of cells compiled into the block.
+        BlockFunction code;         // Entry point in the executable buffer, or nullptr once invalidated.
+        std::vector<int> codeWrites; // Cells inside the decoded code that the block writes to.
+        std::vector<int> dirtyPages; // Memory pages (of emulator::PAGE_WORDS words) the block writes to.
+    };
+
+    // Number of times a cell must be entered before a block starting there is compiled.
+    const static int HOT_THRESHOLD = 16;
+
+    // Longest block that will be compiled.
+    const static int MAX_BLOCK_LENGTH = 64;
+
+    // Constructor. Reserves the executable buffer; a_codeLimit is the number of decoded cells.
+    explicit JitCompiler(int a_codeLimit);
+
+    // Destructor. Releases the executable buffer.
+    ~JitCompiler();
+
+    JitCompiler(const JitCompiler&) = delete;
+    JitCompiler& operator=(const JitCompiler&) = delete;
+
+    // Returns true if native code can be generated on this host.
+    bool IsAvailable() const { return m_buffer != nullptr; }
+
+    // Returns the compiled block starting at a_cell, compiling it once the cell is hot.
+    // Returns nullptr if the block is not (yet) compiled and the interpreter should step instead.
+    const Block* Enter(int a_cell, const DecodedInstruction* a_decoded);
+
+    // Drops every compiled block that covers a_cell. Called when a program writes into its code.
+    void InvalidateCell(int a_cell);
+
+private:
+
+    // Compiles the block starting at a_cell. Returns its index in m_blocks, or -1 if nothing could be compiled.
+    int Compile(int a_cell, const DecodedInstruction* a_decoded);
+
+    // Empties the block cache and the executable buffer.
+    void Flush();
+
+    // Helpers that append machine code to m_code.
+    void Emit(std::initializer_list<unsigned char> a_bytes);
+    void Emit32(int a_value);
+
+    unsigned char* m_buffer = nullptr;      // Executable buffer.
+    size_t m_bufferSize = 0;                // Size of the executable buffer in bytes.
+    size_t m_bufferUsed = 0;                // Bytes of the buffer holding compiled blocks.
+    std::vector<unsigned char> m_code;      // Code of the block being compiled.
+
+    int m_codeLimit;                        // Number of decoded cells the JIT may compile.
+    std::vector<int> m_blockAt;             // Index into m_blocks of the block starting at each cell, or -1.
+    std::vector<unsigned short> m_hits;     // Times each cell was entered while not compiled.
+    std::vector<Block> m_blocks;            // Every block compiled since the last flush.
+};
+
+#endif
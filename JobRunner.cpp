@@ -0,0 +1,235 @@
+//
+//  Implementation of the work-stealing job runner.
+//
+#include "stdafx.h"
+#include "JobRunner.h"
+#include <chrono>
+#include <thread>
+
+/**/
+/*
+JobRunner::JobRunner(unsigned a_threads)
+
+NAME
+
+        JobRunner::JobRunner - Constructor for the JobRunner class.
+
+SYNOPSIS
+
+        JobRunner::JobRunner(unsigned a_threads);
+            a_threads    --> The number of worker threads, or 0 for one per hardware thread.
+
+DESCRIPTION
+
+        This constructor sizes the pool. If the number of hardware threads cannot be
+        determined a single worker is used.
+
+*/
+/**/
+JobRunner::JobRunner(unsigned a_threads)
+    : m_threadCount(a_threads)
+{
+    if (m_threadCount == 0) {
+        m_threadCount = std::thread::hardware_concurrency();
+    }
+    if (m_threadCount == 0) {
+        m_threadCount = 1;
+    }
+}
+
+/**/
+/*
+size_t JobRunner::Submit(const std::vector<long long>& a_image, const std::vector<long long>& a_input)
+
+NAME
+
+        JobRunner::Submit - Adds a job to the runner.
+
+SYNOPSIS
+
+        size_t JobRunner::Submit(const std::vector<long long>& a_image, const std::vector<long long>& a_input);
+            a_image    --> The memory contents to load, starting at cell 0.
+            a_input    --> The values READ returns, in order.
+
+DESCRIPTION
+
+        This method queues a job for the next call to Run.
+
+RETURNS
+
+        Returns the index of the job in GetResults.
+*/
+/**/
+size_t JobRunner::Submit(const std::vector<long long>& a_image, const std::vector<long long>& a_input)
+{
+    m_jobs.push_back({ a_image, a_input });
+    return m_jobs.size() - 1;
+}
+
+/**/
+/*
+void JobRunner::Run()
+
+NAME
+
+        JobRunner::Run - Runs every submitted job.
+
+SYNOPSIS
+
+        void JobRunner::Run();
+
+DESCRIPTION
+
+        This method deals the jobs round-robin into one queue per worker, starts the workers
+        and waits for them. Results are written into slots reserved up front, so they come
+        out in submission order however the jobs were scheduled. Afterwards the job list is
+        empty and the runner can be reused.
+
+*/
+/**/
+void JobRunner::Run()
+{
+    m_results.assign(m_jobs.size(), Result());
+    m_queues = std::vector<WorkQueue>(m_threadCount);
+    for (size_t job = 0; job < m_jobs.size(); job++) {
+        m_queues[job % m_threadCount].jobs.push_back(job);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned worker = 0; worker < m_threadCount; worker++) {
+        workers.emplace_back(&JobRunner::Work, this, worker);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    m_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    m_jobs.clear();
+}
+
+// Body of a worker thread: run jobs until there are none left anywhere, reusing one emulator.
+void JobRunner::Work(unsigned a_worker)
+{
+    emulator emu;
+    const std::vector<long long>* loaded = nullptr;
+    size_t job;
+    while (NextJob(a_worker, job)) {
+        RunJob(job, emu, loaded);
+    }
+}
+
+/**/
+/*
+bool JobRunner::NextJob(unsigned a_worker, size_t& a_job)
+
+NAME
+
+        JobRunner::NextJob - Finds the next job for a worker.
+
+SYNOPSIS
+
+        bool JobRunner::NextJob(unsigned a_worker, size_t& a_job);
+            a_worker    --> The worker asking for work.
+            a_job       --> Receives the job to run.
+
+DESCRIPTION
+
+        This method takes the most recently queued job from the worker's own queue. If that
+        queue is empty it visits the other workers' queues in turn and steals the oldest job
+        from the first one that has any. No jobs are added once Run has started, so when
+        every queue is empty the worker can stop.
+
+RETURNS
+
+        Returns true if a job was found, otherwise false.
+*/
+/**/
+bool JobRunner::NextJob(unsigned a_worker, size_t& a_job)
+{
+    {
+        WorkQueue& own = m_queues[a_worker];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.jobs.empty()) {
+            a_job = own.jobs.back();
+            own.jobs.pop_back();
+            return true;
+        }
+    }
+    for (unsigned i = 1; i < m_threadCount; i++) {
+        WorkQueue& victim = m_queues[(a_worker + i) % m_threadCount];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.jobs.empty()) {
+            a_job = victim.jobs.front();
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+/**/
+/*
+void JobRunner::RunJob(size_t a_job, emulator& a_emu, const std::vector<long long>*& a_loaded)
+
+NAME
+
+        JobRunner::RunJob - Runs a single job.
+
+SYNOPSIS
+
+        void JobRunner::RunJob(size_t a_job, emulator& a_emu, const std::vector<long long>*& a_loaded);
+            a_job       --> The index of the job to run.
+            a_emu       --> The worker's emulator.
+            a_loaded    --> The image last loaded into a_emu, or nullptr. Updated if another is loaded.
+
+DESCRIPTION
+
+        If a_emu already holds the job's image, this method resets it with Restore, which
+        copies back only the pages the previous job wrote. Otherwise it loads the image into
+        a fresh emulator and takes a snapshot of it. It then connects READ to a tape
+        holding the job's input and WRITE to a buffered sink collecting its output, runs
+        the program and records the result and the time it took. If a watchdog limit is
+        set the program is run in slices by a Scheduler, which kills it at the limit; the
+        slices always run on the switch engine, so m_engine is then not used.
+
+*/
+/**/
+void JobRunner::RunJob(size_t a_job, emulator& a_emu, const std::vector<long long>*& a_loaded)
+{
+    const Job& job = m_jobs[a_job];
+    Result& result = m_results[a_job];
+    auto start = std::chrono::steady_clock::now();
+
+    if (a_loaded != nullptr && *a_loaded == job.image) {
+        a_emu.Restore();
+    }
+    else {
+        a_emu = emulator();
+        for (size_t cell = 0; cell < job.image.size(); cell++) {
+            a_emu.insertMemory(static_cast<int>(cell), job.image[cell]);
+        }
+        a_emu.TakeSnapshot();
+        a_loaded = &job.image;
+    }
+
+    TapeInput input(job.input);
+    std::ostringstream text;
+    BufferedOutput output(text);
+    a_emu.SetDevices(input, output);
+    a_emu.SetEngine(m_engine);
+
+    if (m_maxInstructions > 0 || m_maxSeconds > 0) {
+        Scheduler watchdog;
+        watchdog.SetWatchdog(m_maxInstructions, m_maxSeconds);
+        watchdog.Add(a_emu);
+        watchdog.RunUntilIdle();
+        result.success = watchdog.GetTask(0).state == Scheduler::TASK_HALTED;
+        result.killed = watchdog.GetTask(0).state == Scheduler::TASK_KILLED;
+    }
+    else {
+        result.success = a_emu.runProgram();
+    }
+    result.output = text.str();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
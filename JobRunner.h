@@ -0,0 +1,90 @@
+/*
+The JobRunner class runs many independent emulator jobs on all of the host's cores. Each job is a memory image and the values its READ instructions
+consume. Jobs are dealt out to one queue per worker thread; a worker that empties its own queue steals from the others, so uneven job lengths do
+not leave cores idle. Each worker keeps one emulator and resets it from a snapshot between jobs that share an image, every job gets its own output
+buffer, and results are returned in the order the jobs were submitted.
+*/
+
+#ifndef _JOBRUNNER_H      // UNIX way of preventing multiple inclusions.
+#define _JOBRUNNER_H
+
+#include <deque>        // Work queues.
+#include <mutex>        // Protects each work queue.
+#include <string>       // For string objects
+#include <vector>       // Vector is a container that encapsulates dynamic size arrays.
+#include "Emulator.h"   // Each job runs in its own emulator.
+#include "Scheduler.h"  // Watchdog for jobs with limits.
+
+// JobRunner executes a set of emulator jobs on a work-stealing thread pool.
+class JobRunner {
+
+public:
+
+    // The outcome of one job.
+    struct Result {
+        bool success = false;       // True if the program halted normally.
+        bool killed = false;        // True if the watchdog stopped the job.
+        std::string output;         // The values the job wrote, one per line.
+        double seconds = 0;         // Time spent running the job.
+    };
+
+    // Constructor. a_threads is the number of workers; 0 means one per hardware thread.
+    explicit JobRunner(unsigned a_threads = 0);
+
+    // Selects the engine every job without a watchdog limit runs with.
+    void SetEngine(emulator::Engine a_engine) { m_engine = a_engine; }
+
+    // Limits the instructions and seconds each job may use; 0 means no limit. Jobs with a limit run under a Scheduler,
+    // in slices of emulator::Run, and so always on the switch engine whatever SetEngine selected.
+    void SetWatchdog(long long a_maxInstructions, double a_maxSeconds) { m_maxInstructions = a_maxInstructions; m_maxSeconds = a_maxSeconds; }
+
+    // Adds a job. a_image holds the memory contents from cell 0; a_input the values for READ.
+    // Returns the index of the job's result.
+    size_t Submit(const std::vector<long long>& a_image, const std::vector<long long>& a_input);
+
+    // Runs every submitted job and waits for all of them to finish.
+    void Run();
+
+    // Results of Run, in submission order.
+    const std::vector<Result>& GetResults() const { return m_results; }
+
+    // Wall-clock time of the last Run, in seconds.
+    double GetElapsed() const { return m_elapsed; }
+
+    // Number of worker threads used.
+    unsigned GetThreadCount() const { return m_threadCount; }
+
+private:
+
+    // A job waiting to run.
+    struct Job {
+        std::vector<long long> image;
+        std::vector<long long> input;
+    };
+
+    // A worker's queue. The owner takes from the back, thieves take from the front.
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<size_t> jobs;
+    };
+
+    // Body of worker thread a_worker.
+    void Work(unsigned a_worker);
+
+    // Takes the next job for a_worker, stealing if its own queue is empty. Returns false when no work is left.
+    bool NextJob(unsigned a_worker, size_t& a_job);
+
+    // Runs job a_job on a worker's emulator and stores its result. a_loaded is the image a_emu holds, or nullptr.
+    void RunJob(size_t a_job, emulator& a_emu, const std::vector<long long>*& a_loaded);
+
+    unsigned m_threadCount;
+    emulator::Engine m_engine = emulator::ENGINE_SWITCH;
+    long long m_maxInstructions = 0;
+    double m_maxSeconds = 0;
+    std::vector<Job> m_jobs;
+    std::vector<Result> m_results;
+    std::vector<WorkQueue> m_queues;
+    double m_elapsed = 0;
+};
+
+#endif
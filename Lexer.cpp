@@ -0,0 +1,521 @@
+//
+//  Implementation of the source lexer.
+//
+#include "stdafx.h"
+#include "Lexer.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define VC_LEXER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only allow AVX2 intrinsics in functions compiled for AVX2. MSVC allows them anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define VC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define VC_TARGET_AVX2
+#endif
+
+// Bytes classified at a time: one bit of a mask each.
+static const size_t BLOCK = 64;
+
+// Blocks classified before their masks are read, so the classifier runs in a loop of its own.
+static const size_t CHUNK_BLOCKS = 16;
+
+// Lines lexed at a time by Next. Their records stay in the level 2 cache while they are handed out.
+static const size_t BATCH_LINES = 1024;
+
+/**/
+/*
+Lexer::Lexer(std::string_view a_text, bool a_vector)
+
+NAME
+
+        Lexer::Lexer - Constructor for the Lexer class.
+
+SYNOPSIS
+
+        Lexer::Lexer(std::string_view a_text, bool a_vector);
+            a_text     --> The buffer to lex. It must outlive the lexer.
+            a_vector   --> Classify with AVX2 if the host has it.
+
+DESCRIPTION
+
+        This constructor chooses the classifier, AVX2 only if it was asked for and the
+        processor can run it, and positions the lexer on the first line of a_text.
+
+*/
+/**/
+Lexer::Lexer(std::string_view a_text, bool a_vector)
+    : m_text(a_text), m_vector(a_vector && HasAvx2())
+{
+    Reset();
+}
+
+/**/
+/*
+bool Lexer::HasAvx2()
+
+NAME
+
+        Lexer::HasAvx2 - Checks whether the host can run the AVX2 classifier.
+
+SYNOPSIS
+
+        static bool Lexer::HasAvx2();
+
+DESCRIPTION
+
+        This method asks the processor, through cpuid, whether it supports AVX2 and whether
+        the operating system saves the AVX registers. On other architectures it returns false
+        and the scalar classifier is used.
+
+RETURNS
+
+        Returns true if AVX2 can be used, otherwise false.
+*/
+/**/
+bool Lexer::HasAvx2()
+{
+#if defined(VC_LEXER_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(VC_LEXER_X86)
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    return false;
+#endif
+}
+
+/**/
+/*
+void Lexer::Classify(std::string_view a_text, size_t a_offset, size_t a_blocks, BlockMasks* a_masks) const
+
+NAME
+
+        Lexer::Classify - Classifies a chunk of the buffer.
+
+SYNOPSIS
+
+        void Lexer::Classify(std::string_view a_text, size_t a_offset, size_t a_blocks, BlockMasks* a_masks) const;
+            a_text     --> The buffer.
+            a_offset   --> The start of the chunk.
+            a_blocks   --> The number of blocks in the chunk.
+            a_masks    --> Set to the masks of each block.
+
+DESCRIPTION
+
+        This method classifies the whole blocks of the chunk where they lie, with the
+        classifier the lexer was given. A block that runs past the end of the buffer is
+        copied out and padded with a letter, and the blocks after it are cleared, so the
+        bytes past the end are in no class.
+
+*/
+/**/
+void Lexer::Classify(std::string_view a_text, size_t a_offset, size_t a_blocks, BlockMasks* a_masks) const
+{
+    const size_t available = a_text.size() - std::min(a_offset, a_text.size());
+    const size_t whole = std::min(a_blocks, available / BLOCK);
+    if (m_vector) {
+        ClassifyAvx2(a_text.data() + a_offset, whole, a_masks);
+    }
+    else {
+        ClassifyScalar(a_text.data() + a_offset, whole, a_masks);
+    }
+    size_t block = whole;
+    if (block < a_blocks && available % BLOCK != 0) {
+        const size_t start = a_offset + block * BLOCK;
+        char padded[BLOCK];
+        memcpy(padded, a_text.data() + start, a_text.size() - start);
+        memset(padded + (a_text.size() - start), 'x', BLOCK - (a_text.size() - start));
+        ClassifyScalar(padded, 1, a_masks + block);
+        block++;
+    }
+    for (; block < a_blocks; block++) {
+        a_masks[block] = BlockMasks();
+    }
+}
+
+// The classes of each character, as bits: 1 newline, 2 semicolon, 4 comma, 8 white space.
+static constexpr std::array<unsigned char, 256> CHARACTER_CLASSES = [] {
+    std::array<unsigned char, 256> classes = {};
+    classes['\n'] = 1 | 8;
+    classes[';'] = 2;
+    classes[','] = 4;
+    for (unsigned char c : { ' ', '\t', '\v', '\f', '\r' }) {
+        classes[c] = 8;
+    }
+    return classes;
+}();
+
+/**/
+/*
+void Lexer::ClassifyScalar(const char* a_data, size_t a_blocks, BlockMasks* a_masks)
+
+NAME
+
+        Lexer::ClassifyScalar - Classifies blocks of the buffer one byte at a time.
+
+SYNOPSIS
+
+        static void Lexer::ClassifyScalar(const char* a_data, size_t a_blocks, BlockMasks* a_masks);
+            a_data     --> The blocks to classify.
+            a_blocks   --> The number of them.
+            a_masks    --> Set to the masks of each block.
+
+DESCRIPTION
+
+        This method sets bit i of each mask of a block if byte i of the block is a newline, a
+        semicolon, a comma or white space, looking the classes of each byte up in a table.
+        White space is what the >> operator of a stream skips: space, tab, newline, vertical
+        tab, form feed and carriage return.
+
+*/
+/**/
+void Lexer::ClassifyScalar(const char* a_data, size_t a_blocks, BlockMasks* a_masks)
+{
+    for (size_t block = 0; block < a_blocks; block++) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(a_data + block * BLOCK);
+        BlockMasks masks = {};
+        for (size_t i = 0; i < BLOCK; i++) {
+            const uint64_t classes = CHARACTER_CLASSES[bytes[i]];
+            masks.newline |= (classes & 1) << i;
+            masks.semicolon |= ((classes >> 1) & 1) << i;
+            masks.comma |= ((classes >> 2) & 1) << i;
+            masks.space |= ((classes >> 3) & 1) << i;
+        }
+        a_masks[block] = masks;
+    }
+}
+
+/**/
+/*
+void Lexer::ClassifyAvx2(const char* a_data, size_t a_blocks, BlockMasks* a_masks)
+
+NAME
+
+        Lexer::ClassifyAvx2 - Classifies blocks of the buffer with AVX2.
+
+SYNOPSIS
+
+        static void Lexer::ClassifyAvx2(const char* a_data, size_t a_blocks, BlockMasks* a_masks);
+            a_data     --> The blocks to classify.
+            a_blocks   --> The number of them.
+            a_masks    --> Set to the masks of each block.
+
+DESCRIPTION
+
+        This method computes the same masks as ClassifyScalar, 32 bytes to a compare: each
+        class is a byte-wise comparison whose sign bits movemask gathers into half a mask.
+        Tab to carriage return are the codes 9 to 13, so they are found with one unsigned
+        range check rather than five comparisons. Without AVX2 in the build, it is the scalar
+        classifier.
+
+*/
+/**/
+#ifdef VC_LEXER_X86
+
+// Gathers the sign bits of a byte-wise comparison into the low half of a mask.
+VC_TARGET_AVX2 static inline uint64_t bits(__m256i a_compare)
+{
+    return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(a_compare)));
+}
+
+VC_TARGET_AVX2 void Lexer::ClassifyAvx2(const char* a_data, size_t a_blocks, BlockMasks* a_masks)
+{
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i semicolon = _mm256_set1_epi8(';');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i controlRange = _mm256_set1_epi8('\r' - '\t');
+
+    for (size_t block = 0; block < a_blocks; block++) {
+        const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_data + block * BLOCK));
+        const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a_data + block * BLOCK + 32));
+
+        // A byte is tab to carriage return if, less tab, it is unsigned no greater than the range.
+        const __m256i lowControl = _mm256_sub_epi8(low, tab);
+        const __m256i highControl = _mm256_sub_epi8(high, tab);
+        const __m256i lowSpace = _mm256_or_si256(_mm256_cmpeq_epi8(low, space),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(lowControl, controlRange), lowControl));
+        const __m256i highSpace = _mm256_or_si256(_mm256_cmpeq_epi8(high, space),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(highControl, controlRange), highControl));
+
+        BlockMasks& masks = a_masks[block];
+        masks.newline = bits(_mm256_cmpeq_epi8(low, newline)) | bits(_mm256_cmpeq_epi8(high, newline)) << 32;
+        masks.semicolon = bits(_mm256_cmpeq_epi8(low, semicolon)) | bits(_mm256_cmpeq_epi8(high, semicolon)) << 32;
+        masks.comma = bits(_mm256_cmpeq_epi8(low, comma)) | bits(_mm256_cmpeq_epi8(high, comma)) << 32;
+        masks.space = bits(lowSpace) | bits(highSpace) << 32;
+    }
+}
+
+#else
+
+void Lexer::ClassifyAvx2(const char* a_data, size_t a_blocks, BlockMasks* a_masks)
+{
+    ClassifyScalar(a_data, a_blocks, a_masks);
+}
+
+#endif
+
+/**/
+/*
+const LexedLine* Lexer::Next(std::string_view& a_line)
+
+NAME
+
+        Lexer::Next - Hands out the next line and its tokens.
+
+SYNOPSIS
+
+        const LexedLine* Lexer::Next(std::string_view& a_line);
+            a_line     --> Set to the next line, without its newline.
+
+DESCRIPTION
+
+        This method hands out the lines lexed by the last batch, lexing the next batch when
+        they are used up.
+
+RETURNS
+
+        Returns the tokens of the line, or null if there are no more lines.
+*/
+/**/
+const LexedLine* Lexer::Next(std::string_view& a_line)
+{
+    if (m_next == m_count) {
+        if (m_offset > m_text.size()) {
+            return nullptr;
+        }
+        m_batch.resize(BATCH_LINES);
+        m_count = Lex(m_text, m_offset, m_batch.data(), BATCH_LINES);
+        m_next = 0;
+    }
+    const LexedLine* tokens = &m_batch[m_next++];
+    a_line = m_text.substr(tokens->start, tokens->length);
+    return tokens;
+}
+
+/**/
+/*
+void Lexer::Reset()
+
+NAME
+
+        Lexer::Reset - Goes back to the first line.
+
+SYNOPSIS
+
+        void Lexer::Reset();
+
+DESCRIPTION
+
+        This method discards the lines lexed so far, so that Next starts again from the
+        beginning of the buffer.
+
+*/
+/**/
+void Lexer::Reset()
+{
+    m_offset = 0;
+    m_count = 0;
+    m_next = 0;
+}
+
+/**/
+/*
+size_t Lexer::Lex(std::string_view a_text, size_t& a_offset, LexedLine* a_lines, size_t a_limit) const
+
+NAME
+
+        Lexer::Lex - Lexes lines of the buffer from their masks.
+
+SYNOPSIS
+
+        size_t Lexer::Lex(std::string_view a_text, size_t& a_offset, LexedLine* a_lines, size_t a_limit) const;
+            a_text     --> The buffer.
+            a_offset   --> The start of the first line to lex. Set to the start of the next.
+            a_lines    --> Set to the lines lexed.
+            a_limit    --> The number of lines to lex, if there are that many.
+
+DESCRIPTION
+
+        This method classifies a_text a chunk of blocks at a time, and reads each line that
+        starts in the chunk from the 64 bits of each mask that start at its first byte, so
+        that bit i describes byte i of the line wherever it lies in its blocks:
+
+            - the first newline ends the line and the first semicolon before it starts the
+              comment;
+            - the bytes before the comment that are not white space make up the words: a
+              word starts where such a byte follows one that is not, and ends where one is
+              followed by one that is not. The first few are taken lowest bit first;
+            - the first comma before the comment and at or after the end of the opcode, the
+              word after the label if there is one, is the one that separates operands.
+
+        This is the split that Instruction::ParseInstruction makes with RemoveComment and
+        ParseLine, so the tokens give the same fields. A line of 64 bytes or more is handed
+        to LexLongLine. As getline does, the text after the last newline is a line even if
+        it is empty. On Windows, where the source stream reads in text mode, a line also
+        loses the carriage return before its newline.
+
+RETURNS
+
+        Returns the number of lines lexed. After the last line, a_offset is one past the end
+        of a_text.
+*/
+/**/
+size_t Lexer::Lex(std::string_view a_text, size_t& a_offset, LexedLine* a_lines, size_t a_limit) const
+{
+    // The offset is kept in a local, which stores to the lines cannot change.
+    const size_t size = a_text.size();
+    size_t offset = a_offset;
+    size_t count = 0;
+
+    // One more block than the chunk is classified, for the lines that start in its last block.
+    BlockMasks chunk[CHUNK_BLOCKS + 1];
+
+    while (offset <= size && count < a_limit) {
+        const size_t base = offset / BLOCK * BLOCK;
+        Classify(a_text, base, CHUNK_BLOCKS + 1, chunk);
+
+        while (offset <= size && offset < base + CHUNK_BLOCKS * BLOCK && count < a_limit) {
+            const size_t block = (offset - base) / BLOCK;
+            const unsigned shift = static_cast<unsigned>(offset % BLOCK);
+            auto window = [&](uint64_t BlockMasks::* a_class) {
+                const uint64_t low = chunk[block].*a_class >> shift;
+                return shift == 0 ? low : low | chunk[block + 1].*a_class << (BLOCK - shift);
+            };
+
+            const size_t available = size - offset;
+            const uint64_t newline = window(&BlockMasks::newline);
+            if (newline == 0 && available >= BLOCK) {
+                offset = LexLongLine(a_text, offset, a_lines[count++]);
+                continue;
+            }
+
+            // Bytes past the end of the text are in no class, so a last line without a newline has none in its window.
+            const unsigned end = newline != 0 ? static_cast<unsigned>(std::countr_zero(newline)) : static_cast<unsigned>(available);
+            const uint64_t lineMask = (uint64_t(1) << end) - 1;
+            const uint64_t semicolon = window(&BlockMasks::semicolon) & lineMask;
+            const unsigned clean = semicolon != 0 ? static_cast<unsigned>(std::countr_zero(semicolon)) : end;
+            const uint64_t cleanMask = (uint64_t(1) << clean) - 1;
+
+            const uint64_t word = ~window(&BlockMasks::space) & cleanMask;
+            uint64_t starts = word & ~(word << 1);
+            uint64_t lasts = word & ~(word >> 1);
+
+            LexedLine& lexed = a_lines[count++];
+            lexed.start = offset;
+            lexed.length = end;
+#ifdef _WIN32
+            if (newline != 0 && end > 0 && a_text[offset + end - 1] == '\r') {
+                lexed.length--;
+            }
+#endif
+            lexed.clean = std::min(clean, lexed.length);
+            lexed.label = end > 0 && a_text[offset] != ' ' && a_text[offset] != '\t';
+
+            // Always four rounds, so the number of words costs no branch; the rounds past the last word record 64.
+            int words = 0;
+            for (int i = 0; i < LexedLine::WORDS; i++) {
+                lexed.wordStart[i] = static_cast<unsigned>(std::countr_zero(starts));
+                lexed.wordEnd[i] = static_cast<unsigned>(std::countr_zero(lasts)) + 1;
+                words += starts != 0;
+                starts &= starts - 1;
+                lasts &= lasts - 1;
+            }
+            lexed.words = static_cast<unsigned char>(words);
+
+            const int opcode = lexed.label ? 1 : 0;
+            const uint64_t comma = words > opcode ? window(&BlockMasks::comma) & cleanMask & (~uint64_t(0) << lexed.wordEnd[opcode]) : 0;
+            lexed.comma = comma != 0 ? static_cast<unsigned>(std::countr_zero(comma)) : LexedLine::NONE;
+
+            offset += newline != 0 ? end + 1 : available + 1;
+        }
+    }
+    a_offset = offset;
+    return count;
+}
+
+/**/
+/*
+size_t Lexer::LexLongLine(std::string_view a_text, size_t a_offset, LexedLine& a_line)
+
+NAME
+
+        Lexer::LexLongLine - Lexes a line too long for the masks.
+
+SYNOPSIS
+
+        static size_t Lexer::LexLongLine(std::string_view a_text, size_t a_offset, LexedLine& a_line);
+            a_text     --> The buffer.
+            a_offset   --> The start of the line.
+            a_line     --> Set to the tokens of the line.
+
+DESCRIPTION
+
+        This method finds the same tokens as Lex, for a line of 64 bytes or more, by looking
+        at each byte of the line in turn.
+
+RETURNS
+
+        Returns the start of the next line, or one past the end of a_text if this is the last.
+*/
+/**/
+size_t Lexer::LexLongLine(std::string_view a_text, size_t a_offset, LexedLine& a_line)
+{
+    std::string_view line = a_text.substr(a_offset);
+    const size_t newline = line.find('\n');
+    line = line.substr(0, newline);
+    const size_t semicolon = line.find(';');
+    const size_t clean = semicolon != std::string_view::npos ? semicolon : line.size();
+
+    LexedLine& lexed = a_line;
+    lexed.start = a_offset;
+    lexed.length = static_cast<unsigned>(line.size());
+#ifdef _WIN32
+    if (newline != std::string_view::npos && !line.empty() && line.back() == '\r') {
+        lexed.length--;
+    }
+#endif
+    lexed.clean = std::min(static_cast<unsigned>(clean), lexed.length);
+    lexed.label = !line.empty() && line[0] != ' ' && line[0] != '\t';
+
+    int words = 0;
+    bool inWord = false;
+    for (size_t i = 0; i <= clean && words <= LexedLine::WORDS; i++) {
+        const bool space = i == clean || (CHARACTER_CLASSES[static_cast<unsigned char>(line[i])] & 8) != 0;
+        if (!space && !inWord) {
+            if (words == LexedLine::WORDS) {
+                break;
+            }
+            lexed.wordStart[words] = static_cast<unsigned>(i);
+        }
+        else if (space && inWord) {
+            lexed.wordEnd[words++] = static_cast<unsigned>(i);
+        }
+        inWord = !space;
+    }
+    lexed.words = static_cast<unsigned char>(words);
+
+    const int opcode = lexed.label ? 1 : 0;
+    const size_t comma = words > opcode ? line.substr(0, clean).find(',', lexed.wordEnd[opcode]) : std::string_view::npos;
+    lexed.comma = comma != std::string_view::npos ? static_cast<unsigned>(comma) : LexedLine::NONE;
+
+    return newline != std::string_view::npos ? a_offset + newline + 1 : a_text.size() + 1;
+}
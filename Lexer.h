@@ -0,0 +1,87 @@
+/*
+The Lexer class splits a buffer of assembler source into lines and finds, in one sweep, everything Instruction needs to take each line apart:
+where the comment starts, where the first few words start and end, and where the first comma after the opcode is. The buffer is classified
+64 bytes at a time into bit masks of newlines, semicolons, commas and white space, with AVX2 when the processor has it and a scalar loop
+otherwise; each line is then read off 64 bits of the masks starting at its first byte, a handful of bit operations for all its tokens.
+Lines are lexed in batches, so memory stays small however large the source is. The assembler does not read its source through the Lexer:
+even with AVX2 it is slower than splitting the lines and scanning each one, so it is only run by "-lexer compare", which measures the two.
+*/
+
+#ifndef _LEXER_H      // UNIX way of preventing multiple inclusions.
+#define _LEXER_H
+
+#include <cstdint>      // The masks are 64-bit.
+#include <string_view>  // The buffer and its lines are views.
+#include <vector>       // Vector is a container that encapsulates dynamic size arrays.
+
+// The tokens of one line, as offsets from the start of the line.
+struct LexedLine {
+
+    static constexpr int WORDS = 4;            // Words recorded: label, opcode and two operands.
+    static constexpr unsigned NONE = ~0u;      // Offset of something the line does not have.
+
+    size_t start;                           // Offset of the line in the buffer.
+    unsigned length;                        // Length of the line, without its newline.
+    unsigned clean;                         // Length of the line before its comment.
+    unsigned comma;                         // The first comma after the opcode, or NONE.
+    bool label;                             // The first word is a label: the line starts with neither space nor tab.
+    unsigned char words;                    // Number of words recorded, at most WORDS.
+    unsigned wordStart[WORDS];              // Start of each word recorded.
+    unsigned wordEnd[WORDS];                // One past the end of each word recorded.
+};
+
+// Lexer hands out the lines of a buffer with their tokens.
+class Lexer {
+
+public:
+
+    // Lexes a_text, which must outlive the lexer, with AVX2 if a_vector is true and the host has it.
+    explicit Lexer(std::string_view a_text = std::string_view(), bool a_vector = true);
+
+    // Sets a_line to the next line and returns its tokens, which stay valid until the next call, or null after the last line.
+    // Lines are split as getline splits them: text after the last newline is a line, even if empty.
+    const LexedLine* Next(std::string_view& a_line);
+
+    // Goes back to the first line.
+    void Reset();
+
+    // Returns true if the lexer classifies with AVX2.
+    bool IsVector() const { return m_vector; }
+
+    // Returns true if the host can run the AVX2 classifier.
+    static bool HasAvx2();
+
+private:
+
+    // The classification of a 64-byte block: bit i describes byte i.
+    struct BlockMasks {
+        uint64_t newline;
+        uint64_t semicolon;
+        uint64_t comma;
+        uint64_t space;                     // The characters the >> operator of a stream skips.
+    };
+
+    // Sets a_masks to the classification of a_blocks blocks of a_text from a_offset. A block short of the end
+    // of a_text is classified up to the end, and a block past it is in no class.
+    void Classify(std::string_view a_text, size_t a_offset, size_t a_blocks, BlockMasks* a_masks) const;
+
+    // Sets a_masks to the classification of the a_blocks whole blocks at a_data.
+    static void ClassifyScalar(const char* a_data, size_t a_blocks, BlockMasks* a_masks);
+    static void ClassifyAvx2(const char* a_data, size_t a_blocks, BlockMasks* a_masks);
+
+    // Lexes up to a_limit lines of a_text from a_offset into a_lines, and sets a_offset to the start of the next line,
+    // one past the end of a_text after the last. Returns the number of lines lexed.
+    size_t Lex(std::string_view a_text, size_t& a_offset, LexedLine* a_lines, size_t a_limit) const;
+
+    // Lexes the line at a_offset of a_text into a_line one byte at a time. Returns the start of the next line.
+    static size_t LexLongLine(std::string_view a_text, size_t a_offset, LexedLine& a_line);
+
+    std::string_view m_text;                // The buffer.
+    bool m_vector;                          // Classify with AVX2.
+    size_t m_offset = 0;                    // Start of the next line to lex.
+    std::vector<LexedLine> m_batch;         // The last batch of lines lexed.
+    size_t m_count = 0;                     // The number of lines in it.
+    size_t m_next = 0;                      // The next of them to hand out.
+};
+
+#endif
@@ -0,0 +1,108 @@
+//
+//  Implementation of the emulator's memory backends.
+//
+#include "stdafx.h"
+#include "Memory.h"
+#include <algorithm>
+
+// Makes one page equal to the same page of another memory.
+void DenseMemory::CopyPage(int a_page, const DenseMemory& a_from)
+{
+    const int first = a_page * PAGE_WORDS;
+    const int last = first + PAGE_WORDS < WORDS ? first + PAGE_WORDS : WORDS;
+    std::copy(a_from.m_words.begin() + first, a_from.m_words.begin() + last, m_words.begin() + first);
+}
+
+// The page every unwritten page of a SparseMemory reads from.
+static const long long s_zeroPage[MemoryLayout::PAGE_WORDS] = {};
+
+// Constructor. Nothing is allocated beyond the page table.
+SparseMemory::SparseMemory()
+    : m_table(PAGES, s_zeroPage), m_pages(PAGES)
+{
+}
+
+// Copy constructor. Only written pages are duplicated.
+SparseMemory::SparseMemory(const SparseMemory& a_other)
+    : m_table(PAGES, s_zeroPage), m_pages(PAGES)
+{
+    *this = a_other;
+}
+
+/**/
+/*
+SparseMemory& SparseMemory::operator=(const SparseMemory& a_other)
+
+NAME
+
+        SparseMemory::operator= - Copies another sparse memory.
+
+SYNOPSIS
+
+        SparseMemory& SparseMemory::operator=(const SparseMemory& a_other);
+            a_other    --> The memory to copy.
+
+DESCRIPTION
+
+        This operator duplicates the pages a_other has written, reusing pages this memory
+        already owns where it can, and releases pages that a_other has not written.
+
+RETURNS
+
+        Returns a reference to this memory.
+*/
+/**/
+SparseMemory& SparseMemory::operator=(const SparseMemory& a_other)
+{
+    if (this != &a_other) {
+        for (int page = 0; page < PAGES; page++) {
+            CopyPage(page, a_other);
+        }
+    }
+    return *this;
+}
+
+// Allocates a zeroed page and points the table at it.
+long long* SparseMemory::Materialize(int a_page)
+{
+    m_pages[a_page].reset(new long long[PAGE_WORDS]());
+    m_table[a_page] = m_pages[a_page].get();
+    return m_pages[a_page].get();
+}
+
+// Makes one page equal to the same page of another memory, releasing it if the other never wrote it.
+void SparseMemory::CopyPage(int a_page, const SparseMemory& a_from)
+{
+    const long long* source = a_from.m_pages[a_page].get();
+    if (source == nullptr) {
+        m_pages[a_page].reset();
+        m_table[a_page] = s_zeroPage;
+        return;
+    }
+    long long* page = m_pages[a_page].get();
+    if (page == nullptr) {
+        page = Materialize(a_page);
+    }
+    std::copy(source, source + PAGE_WORDS, page);
+}
+
+// Counts the pages that have been allocated.
+size_t SparseMemory::GetResidentBytes() const
+{
+    size_t pages = 0;
+    for (const auto& page : m_pages) {
+        pages += page != nullptr;
+    }
+    return pages * PAGE_WORDS * sizeof(long long);
+}
+
+// Two memories are equal if every word is, whether or not the page holding it was allocated.
+bool SparseMemory::operator==(const SparseMemory& a_other) const
+{
+    for (int page = 0; page < PAGES; page++) {
+        if (!std::equal(m_table[page], m_table[page] + PAGE_WORDS, a_other.m_table[page])) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,111 @@
+/*
+These classes are the memory of the emulated VC1620. DenseMemory is one flat array of every word, which is what the emulator has always used.
+SparseMemory splits the same address space into fixed-size pages and only allocates a page the first time it is written; reads from pages that
+have never been written are served from a single shared page of zeroes. Which one the emulator uses is chosen at compile time: define
+VC_SPARSE_MEMORY to get the sparse backend. Both have the same interface, so the emulator is written once against EmulatorMemory.
+*/
+
+#ifndef _MEMORY_H      // UNIX way of preventing multiple inclusions.
+#define _MEMORY_H
+
+#include <memory>   // Owned pages of the sparse backend.
+#include <vector>   // Vector is a container that encapsulates dynamic size arrays.
+
+// Size and page layout shared by both memory backends.
+struct MemoryLayout {
+
+    // Number of words of memory.
+    const static int WORDS = 100'000;
+
+    // Number of words in a page, and the number of pages. The last page is only partly used.
+    const static int PAGE_WORDS = 512;
+    const static int PAGES = (WORDS + PAGE_WORDS - 1) / PAGE_WORDS;
+};
+
+// Memory held as one contiguous, fully committed array.
+class DenseMemory : public MemoryLayout {
+
+public:
+
+    // Constructor. Every word starts out as zero.
+    DenseMemory() : m_words(WORDS, 0) {}
+
+    // Returns the word at a_location.
+    long long operator[](int a_location) const { return m_words[a_location]; }
+
+    // Writes a_value to a_location.
+    void Store(int a_location, long long a_value) { m_words[a_location] = a_value; }
+
+    // Makes page a_page equal to the same page of a_from.
+    void CopyPage(int a_page, const DenseMemory& a_from);
+
+    // Bytes of host memory holding words.
+    size_t GetResidentBytes() const { return m_words.size() * sizeof(long long); }
+
+    // Base of the array. Only the dense backend has one; the JIT engine compiles against it.
+    long long* Data() { return m_words.data(); }
+
+    bool operator==(const DenseMemory& a_other) const { return m_words == a_other.m_words; }
+    bool operator!=(const DenseMemory& a_other) const { return !(*this == a_other); }
+
+private:
+
+    std::vector<long long> m_words;
+};
+
+// Memory held as pages that are allocated on their first write.
+class SparseMemory : public MemoryLayout {
+
+public:
+
+    // Constructor. Every page reads as the shared zero page.
+    SparseMemory();
+
+    // Copying duplicates the pages that have been written; unwritten pages stay shared.
+    SparseMemory(const SparseMemory& a_other);
+    SparseMemory& operator=(const SparseMemory& a_other);
+
+    // Returns the word at a_location.
+    long long operator[](int a_location) const
+    {
+        const unsigned location = static_cast<unsigned>(a_location);
+        return m_table[location / PAGE_WORDS][location % PAGE_WORDS];
+    }
+
+    // Writes a_value to a_location, allocating its page if this is the first write to it.
+    void Store(int a_location, long long a_value)
+    {
+        const unsigned location = static_cast<unsigned>(a_location);
+        long long* page = m_pages[location / PAGE_WORDS].get();
+        if (page == nullptr) {
+            page = Materialize(location / PAGE_WORDS);
+        }
+        page[location % PAGE_WORDS] = a_value;
+    }
+
+    // Makes page a_page equal to the same page of a_from. A page that a_from has never written is released.
+    void CopyPage(int a_page, const SparseMemory& a_from);
+
+    // Bytes of host memory holding words, i.e. the pages that have been written.
+    size_t GetResidentBytes() const;
+
+    bool operator==(const SparseMemory& a_other) const;
+    bool operator!=(const SparseMemory& a_other) const { return !(*this == a_other); }
+
+private:
+
+    // Allocates page a_page, filled with zeroes, and points the table at it.
+    long long* Materialize(int a_page);
+
+    std::vector<const long long*> m_table;              // Page used for reads: an owned page or the zero page.
+    std::vector<std::unique_ptr<long long[]>> m_pages;  // Owned pages, or nullptr for pages never written.
+};
+
+// The memory backend the emulator is built with.
+#ifdef VC_SPARSE_MEMORY
+typedef SparseMemory EmulatorMemory;
+#else
+typedef DenseMemory EmulatorMemory;
+#endif
+
+#endif
@@ -0,0 +1,105 @@
+//
+//  Implementation of the parsed source.
+//
+#include "stdafx.h"
+#include "ParsedSource.h"
+#include <algorithm>
+
+/**/
+/*
+ParsedLine& ParsedSource::Add(std::string_view a_line, Instruction::InstructionType a_type, Instruction& a_inst, int a_location)
+
+NAME
+
+        ParsedSource::Add - Records a parsed line.
+
+SYNOPSIS
+
+        ParsedLine& ParsedSource::Add(std::string_view a_line, Instruction::InstructionType a_type, Instruction& a_inst, int a_location);
+            a_line        --> The text of the line.
+            a_type        --> The type ParseInstruction returned for it.
+            a_inst        --> The instruction that parsed it.
+            a_location    --> The location pass I gave it.
+
+DESCRIPTION
+
+        This method appends a record of the line to the lines, and its text to the buffer
+        unless it lies in the shared text, where it is found by its place instead. A comment or end statement is recorded as text alone. For a statement, the
+        label and any operand that is not a number are recorded by symbol number, and an
+        operand made only of digits is converted, as GenerateMachineCode does; one too
+        large for an int is marked, and the first such error is kept. A statement with more
+        or fewer operands than the instruction set table gives its opcode is marked as well.
+
+RETURNS
+
+        Returns the record of the line.
+
+*/
+/**/
+ParsedLine& ParsedSource::Add(std::string_view a_line, Instruction::InstructionType a_type, Instruction& a_inst, int a_location)
+{
+    ParsedLine line = {};
+    line.type = static_cast<unsigned char>(a_type);
+    line.kind = ParsedLine::LK_Text;
+    line.label = -1;
+    line.arity = -1;
+    line.location = a_location;
+    line.length = static_cast<unsigned int>(a_line.size());
+    if (!m_shared.empty()) {
+        line.offset = a_line.data() - m_shared.data();
+    }
+    else {
+        line.offset = m_text.size();
+        m_text += a_line;
+    }
+
+    if (a_type != Instruction::ST_Comment && a_type != Instruction::ST_End) {
+        const string& opcode = a_inst.GetOpcode();
+        line.kind = opcode == "dc" ? ParsedLine::LK_Constant
+            : opcode == "ds" || opcode == "org" ? ParsedLine::LK_Storage : ParsedLine::LK_Instruction;
+        line.opcode = a_inst.GetNumericOpcode();
+        line.label = a_inst.isLabel() ? SymbolNumber(a_inst.GetLabel()) : -1;
+        line.size = a_inst.LocationNextInstruction(0);
+        if (a_inst.CountOperands() != a_inst.GetArity()) {
+            line.arity = static_cast<signed char>(a_inst.GetArity());
+        }
+
+        const std::string_view operands[2] = { a_inst.GetOperand1(), a_inst.GetOperand2() };
+        for (int i = 0; i < 2; i++) {
+            const std::string_view operand = operands[i];
+            if (operand.empty()) {
+                continue;
+            }
+            if (std::all_of(operand.begin(), operand.end(), [](unsigned char c) { return std::isdigit(c); })) {
+                try {
+                    line.address[i] = stoi(string(operand));
+                    line.operandKind[i] = ParsedLine::OK_Number;
+                }
+                catch (const std::exception& e) {
+                    line.operandKind[i] = ParsedLine::OK_BadNumber;
+                    if (m_badNumberMessage.empty()) {
+                        m_badNumberMessage = e.what();
+                    }
+                }
+            }
+            else {
+                line.operandKind[i] = ParsedLine::OK_Symbol;
+                line.symbol[i] = SymbolNumber(operand);
+            }
+        }
+    }
+
+    m_lines.push_back(line);
+    return m_lines.back();
+}
+
+// Numbers are given in the order the symbols are first met. The name is copied into m_key, whose storage is reused, for the lookup.
+int ParsedSource::SymbolNumber(std::string_view a_name)
+{
+    m_key.assign(a_name);
+    auto inserted = m_symbolNumbers.try_emplace(m_key, static_cast<int>(m_symbolNames.size()));
+    if (inserted.second) {
+        m_symbolNames.push_back(m_key);
+    }
+    return inserted.first->second;
+}
@@ -0,0 +1,93 @@
+/*
+The ParsedSource class is the intermediate representation the assembler builds as it reads the source. It holds one compact record per source
+line: its type, its numeric opcode, its label and operands as symbol numbers or values, its location and the span of its text. The text of
+every line is kept once for the listing: in place when the source is memory-mapped, or else copied into a single buffer. Pass I fills it in;
+pass II, the listing and any later analysis work from the records and never read or parse the source again.
+*/
+
+#ifndef _PARSEDSOURCE_H      // UNIX way of preventing multiple inclusions.
+#define _PARSEDSOURCE_H
+
+#include <string>           // For string objects
+#include <string_view>      // The text of a line is a view into the buffer.
+#include <unordered_map>    // Symbol numbers by name.
+#include <vector>           // Vector is a container that encapsulates dynamic size arrays.
+#include "Instruction.h"    // The parser whose results are recorded.
+
+// One line of the source.
+struct ParsedLine {
+
+    // How the listing shows the line.
+    enum Kind : unsigned char {
+        LK_Text,            // Comment, blank line or end statement: the text alone.
+        LK_Instruction,     // Opcode and both operands.
+        LK_Constant,        // dc: the constant in the last field.
+        LK_Storage          // ds and org: all zero.
+    };
+
+    // What an operand holds.
+    enum OperandKind : unsigned char {
+        OK_None,            // There is no operand.
+        OK_Number,          // A number, in address.
+        OK_Symbol,          // A symbol, by number in symbol; address holds its value once it is resolved.
+        OK_Undefined,       // A symbol that is not in the symbol table.
+        OK_BadNumber        // A number too large for an int.
+    };
+
+    unsigned char type;                 // Instruction::InstructionType of the line, as ParseInstruction classified it.
+    Kind kind;                          // How the listing shows the line.
+    OperandKind operandKind[2];         // What each operand holds.
+    signed char arity;                  // Operands the opcode takes if the line gives another number, or -1.
+    int opcode;                         // Numeric opcode.
+    int label;                          // Symbol number of the label, or -1 if there is none.
+    int symbol[2];                      // Symbol number of each operand that names one.
+    int address[2];                     // Value of each operand, 0 if absent or not yet resolved.
+    int location;                       // Location pass I gave the line.
+    int size;                           // Number of words the statement occupies: what LocationNextInstruction adds.
+    unsigned int length;                // Length of the text of the line.
+    size_t offset;                      // Start of the text in the buffer.
+};
+
+// ParsedSource holds the parsed lines of a program and the names of the symbols they use.
+class ParsedSource {
+
+public:
+
+    // Appends a_line, which a_inst has just parsed as a_type, at location a_location.
+    ParsedLine& Add(std::string_view a_line, Instruction::InstructionType a_type, Instruction& a_inst, int a_location);
+
+    // Makes lines that lie in a_text be recorded by their place in it rather than copied. a_text must outlive
+    // this object; an empty a_text makes every line be copied.
+    void ShareText(std::string_view a_text) { m_shared = a_text; }
+
+    // Returns the lines, in source order.
+    const std::vector<ParsedLine>& GetLines() const { return m_lines; }
+    std::vector<ParsedLine>& GetLines() { return m_lines; }
+
+    // Returns the text of a_line.
+    std::string_view GetText(const ParsedLine& a_line) const { return (m_shared.empty() ? std::string_view(m_text) : m_shared).substr(a_line.offset, a_line.length); }
+
+    // Returns the name of symbol number a_symbol.
+    const std::string& GetSymbolName(int a_symbol) const { return m_symbolNames[a_symbol]; }
+
+    // Returns the number of distinct symbols the lines name.
+    int GetSymbolCount() const { return static_cast<int>(m_symbolNames.size()); }
+
+    // Returns the error converting the first operand that was too large for an int.
+    const std::string& GetBadNumberMessage() const { return m_badNumberMessage; }
+
+private:
+
+    // Returns the number of the symbol a_name, giving it the next number if it has none yet.
+    int SymbolNumber(std::string_view a_name);
+
+    std::string_view m_shared;                              // Text the lines lie in, if they are not copied.
+    std::string m_text;                                     // Text of every line, end to end, if they are.
+    std::vector<ParsedLine> m_lines;                        // One record per line.
+    std::unordered_map<std::string, int> m_symbolNumbers;   // Number of each symbol by name.
+    std::vector<std::string> m_symbolNames;                 // Name of each symbol by number.
+    std::string m_key;                                      // The name being looked up.
+    std::string m_badNumberMessage;                         // Error converting the first operand too large for an int.
+};
+
+#endif
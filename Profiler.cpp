@@ -0,0 +1,153 @@
+//
+//  Implementation of the label-level profiler.
+//
+#include "stdafx.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <climits>
+#include <iomanip>
+
+/**/
+/*
+Profiler::Profiler(const std::map<std::string, int>& a_symbols, const std::vector<int>& a_locations)
+
+NAME
+
+        Profiler::Profiler - Constructor for the Profiler class.
+
+SYNOPSIS
+
+        Profiler::Profiler(const std::map<std::string, int>& a_symbols, const std::vector<int>& a_locations);
+            a_symbols      --> The symbol table, label to location.
+            a_locations    --> The location of the statement in each cell of the loaded program.
+
+DESCRIPTION
+
+        This constructor creates one region per label, sorted by location, plus a region
+        for the statements ahead of the first label. Multiply defined labels have no usable
+        location and are left out. Where several labels share a location the first in
+        alphabetical order names the region.
+
+*/
+/**/
+Profiler::Profiler(const std::map<std::string, int>& a_symbols, const std::vector<int>& a_locations)
+    : m_locations(a_locations)
+{
+    m_regions.push_back({ "(start)", INT_MIN, 0 });
+    for (const auto& symbol : a_symbols) {
+        if (symbol.second >= 0) {
+            m_regions.push_back({ symbol.first, symbol.second, 0 });
+        }
+    }
+    std::stable_sort(m_regions.begin(), m_regions.end(),
+        [](const Region& a, const Region& b) { return a.location < b.location; });
+    m_regions.erase(std::unique(m_regions.begin(), m_regions.end(),
+        [](const Region& a, const Region& b) { return a.location == b.location; }), m_regions.end());
+}
+
+/**/
+/*
+void Profiler::Attribute(const std::vector<long long>& a_counts)
+
+NAME
+
+        Profiler::Attribute - Charges execution counts to the labelled regions.
+
+SYNOPSIS
+
+        void Profiler::Attribute(const std::vector<long long>& a_counts);
+            a_counts    --> The number of times each cell was executed.
+
+DESCRIPTION
+
+        This method adds the count of every executed cell to the region that holds the
+        location of the statement in that cell. Cells past the loaded program hold no
+        statement; they are counted separately as unlisted.
+
+*/
+/**/
+void Profiler::Attribute(const std::vector<long long>& a_counts)
+{
+    for (size_t cell = 0; cell < a_counts.size(); cell++) {
+        if (a_counts[cell] == 0) {
+            continue;
+        }
+        m_total += a_counts[cell];
+        if (cell < m_locations.size()) {
+            m_regions[FindRegion(m_locations[cell])].count += a_counts[cell];
+        }
+        else {
+            m_unlisted += a_counts[cell];
+        }
+    }
+}
+
+// Returns the last region starting at or before a_location. The first region starts before every location.
+size_t Profiler::FindRegion(int a_location) const
+{
+    auto next = std::upper_bound(m_regions.begin(), m_regions.end(), a_location,
+        [](int location, const Region& region) { return location < region.location; });
+    return static_cast<size_t>(next - m_regions.begin()) - 1;
+}
+
+/**/
+/*
+void Profiler::WriteReport(std::ostream& a_out) const
+
+NAME
+
+        Profiler::WriteReport - Writes the per-label profile.
+
+SYNOPSIS
+
+        void Profiler::WriteReport(std::ostream& a_out) const;
+            a_out    --> The stream to write to.
+
+DESCRIPTION
+
+        This method lists every region that executed at least one instruction, hottest
+        first, with its location, instruction count (one instruction is one VC1620 cycle)
+        and percentage of the total.
+
+*/
+/**/
+void Profiler::WriteReport(std::ostream& a_out) const
+{
+    std::vector<Region> hot;
+    for (const Region& region : m_regions) {
+        if (region.count > 0) {
+            hot.push_back(region);
+        }
+    }
+    if (m_unlisted > 0) {
+        hot.push_back({ "(unlisted)", -1, m_unlisted });
+    }
+    std::stable_sort(hot.begin(), hot.end(), [](const Region& a, const Region& b) { return a.count > b.count; });
+
+    a_out << "Profile: " << m_total << " instructions" << endl;
+    a_out << "Label       Location    Instructions      Percent" << endl;
+    for (const Region& region : hot) {
+        a_out << setfill(' ') << left << setw(12) << region.label << right << setw(8);
+        if (region.location >= 0) {
+            a_out << region.location;
+        }
+        else {
+            a_out << "-";
+        }
+        a_out << setw(16) << region.count << setw(12) << fixed << setprecision(2)
+              << 100.0 * region.count / m_total << "%" << defaultfloat << endl;
+    }
+}
+
+// Writes one folded stack per region that executed at least one instruction.
+void Profiler::WriteFolded(std::ostream& a_out) const
+{
+    for (const Region& region : m_regions) {
+        if (region.count > 0) {
+            a_out << region.label << " " << region.count << "\n";
+        }
+    }
+    if (m_unlisted > 0) {
+        a_out << "(unlisted) " << m_unlisted << "\n";
+    }
+}
@@ -0,0 +1,51 @@
+/*
+The Profiler class turns the per-cell execution counts collected by the emulator into a profile of the assembler program's labelled regions. Every
+executed cell is charged to the nearest label at or before the location of the statement it holds, so a region runs from one label to the next.
+The result can be written as a per-label report or as folded stacks, the input format of the common flame-graph tools.
+*/
+
+#ifndef _PROFILER_H      // UNIX way of preventing multiple inclusions.
+#define _PROFILER_H
+
+#include <iostream> // Reports are written to a stream.
+#include <map>      // The symbol table the labels come from.
+#include <string>   // For string objects
+#include <vector>   // Vector is a container that encapsulates dynamic size arrays.
+
+// Profiler attributes execution counts to labelled regions of a program.
+class Profiler {
+
+public:
+
+    // Constructor. a_symbols maps each label to its location (as built by PassI); a_locations holds the
+    // location of the statement in each memory cell of the loaded program.
+    Profiler(const std::map<std::string, int>& a_symbols, const std::vector<int>& a_locations);
+
+    // Charges the execution count of every cell in a_counts to its region.
+    void Attribute(const std::vector<long long>& a_counts);
+
+    // Writes one line per region, hottest first, with its instruction count and share of the total.
+    void WriteReport(std::ostream& a_out) const;
+
+    // Writes the regions as folded stacks ("label count" per line) for flame-graph tools.
+    void WriteFolded(std::ostream& a_out) const;
+
+private:
+
+    // A labelled region of the program.
+    struct Region {
+        std::string label;      // Label that starts the region.
+        int location;           // Location of the label.
+        long long count;        // Instructions executed in the region.
+    };
+
+    // Returns the index in m_regions of the region holding a_location.
+    size_t FindRegion(int a_location) const;
+
+    std::vector<Region> m_regions;      // Regions ordered by location. The first one covers code before any label.
+    std::vector<int> m_locations;       // Location of the statement in each cell.
+    long long m_unlisted = 0;           // Instructions executed in cells beyond the loaded program.
+    long long m_total = 0;              // Instructions executed in all.
+};
+
+#endif
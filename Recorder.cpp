@@ -0,0 +1,296 @@
+//
+//  Implementation of run recording and replay.
+//
+#include "stdafx.h"
+#include "Recorder.h"
+#include <fstream>
+#include <sstream>
+
+static const char s_magic[4] = { 'V', 'C', 'R', 'R' };
+
+// Appends an unsigned LEB128 varint.
+static void PutVarint(std::string& a_out, uint64_t a_value)
+{
+    while (a_value >= 0x80) {
+        a_out.push_back(static_cast<char>((a_value & 0x7f) | 0x80));
+        a_value >>= 7;
+    }
+    a_out.push_back(static_cast<char>(a_value));
+}
+
+// Reads an unsigned LEB128 varint at a_position, advancing it. Returns false if the data ends first.
+static bool GetVarint(const std::string& a_in, size_t& a_position, uint64_t& a_value)
+{
+    a_value = 0;
+    for (int shift = 0; shift < 64 && a_position < a_in.size(); shift += 7) {
+        const unsigned char byte = static_cast<unsigned char>(a_in[a_position++]);
+        a_value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Maps signed values to unsigned ones so that numbers near zero, of either sign, encode in few bytes.
+static uint64_t ZigZag(int64_t a_value)
+{
+    return (static_cast<uint64_t>(a_value) << 1) ^ static_cast<uint64_t>(a_value >> 63);
+}
+
+static int64_t UnZigZag(uint64_t a_value)
+{
+    return static_cast<int64_t>(a_value >> 1) ^ -static_cast<int64_t>(a_value & 1);
+}
+
+// FNV-1a over every word of the loaded program.
+uint64_t RecordingFormat::HashImage(const emulator& a_emu)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (int location = 0; location < a_emu.GetLoadedLimit(); location++) {
+        const uint64_t word = static_cast<uint64_t>(a_emu.GetMemory()[location]);
+        for (int byte = 0; byte < 8; byte++) {
+            hash = (hash ^ ((word >> (byte * 8)) & 0xff)) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+/**/
+/*
+Recorder::Recorder(std::ostream& a_out, InputDevice& a_input, bool a_trace, uint64_t a_imageHash)
+
+NAME
+
+        Recorder::Recorder - Constructor for the Recorder class.
+
+SYNOPSIS
+
+        Recorder::Recorder(std::ostream& a_out, InputDevice& a_input, bool a_trace, uint64_t a_imageHash);
+            a_out          --> The stream the recording is written to, opened in binary mode.
+            a_input        --> The device READ really takes its values from.
+            a_trace        --> True if the recording is to hold a trace.
+            a_imageHash    --> The hash of the loaded program.
+
+DESCRIPTION
+
+        This constructor writes the header of the recording.
+
+*/
+/**/
+Recorder::Recorder(std::ostream& a_out, InputDevice& a_input, bool a_trace, uint64_t a_imageHash)
+    : m_out(a_out), m_input(a_input)
+{
+    std::string header(s_magic, sizeof(s_magic));
+    PutVarint(header, RecordingFormat::VERSION);
+    PutVarint(header, a_trace ? RecordingFormat::RECORD_TRACE : 0);
+    for (int byte = 0; byte < 8; byte++) {
+        header.push_back(static_cast<char>((a_imageHash >> (byte * 8)) & 0xff));
+    }
+    m_out.write(header.data(), header.size());
+    if (a_trace) {
+        m_block.reserve(BLOCK_SIZE + 32);
+    }
+}
+
+// Passes READ through to the real device and records the value it supplies.
+bool Recorder::Read(long long& a_value)
+{
+    if (!m_input.Read(a_value)) {
+        return false;
+    }
+    FlushTrace();
+    std::string record(1, static_cast<char>(RecordingFormat::TAG_INPUT));
+    PutVarint(record, ZigZag(a_value));
+    m_out.write(record.data(), record.size());
+    return true;
+}
+
+// Records an instruction as the distance from the one after the last.
+void Recorder::Step(int a_location, const DecodedInstruction&)
+{
+    PutVarint(m_block, ZigZag(static_cast<int64_t>(a_location) - (m_lastLocation + 1)) << 1);
+    m_lastLocation = a_location;
+    m_steps++;
+    if (m_block.size() >= BLOCK_SIZE) {
+        FlushTrace();
+    }
+}
+
+// Records a store as the distance from the last store and the change in the word.
+void Recorder::Store(int a_location, long long a_old, long long a_new)
+{
+    PutVarint(m_block, (ZigZag(static_cast<int64_t>(a_location) - m_lastStore) << 1) | 1);
+    PutVarint(m_block, ZigZag(static_cast<int64_t>(static_cast<uint64_t>(a_new) - static_cast<uint64_t>(a_old))));
+    m_lastStore = a_location;
+}
+
+// Writes the pending trace events as one record.
+void Recorder::FlushTrace()
+{
+    if (m_block.empty()) {
+        return;
+    }
+    std::string record(1, static_cast<char>(RecordingFormat::TAG_TRACE));
+    PutVarint(record, m_block.size());
+    m_out.write(record.data(), record.size());
+    m_out.write(m_block.data(), m_block.size());
+    m_block.clear();
+}
+
+// Ends the recording.
+void Recorder::Finish(bool a_result)
+{
+    FlushTrace();
+    std::string record(1, static_cast<char>(RecordingFormat::TAG_END));
+    PutVarint(record, a_result ? 1 : 0);
+    PutVarint(record, m_steps);
+    m_out.write(record.data(), record.size());
+    m_out.flush();
+}
+
+/**/
+/*
+bool Replayer::Load(const std::string& a_file)
+
+NAME
+
+        Replayer::Load - Loads a recording.
+
+SYNOPSIS
+
+        bool Replayer::Load(const std::string& a_file);
+            a_file    --> The file holding the recording.
+
+DESCRIPTION
+
+        This method reads the whole recording, checks its header, and collects the input
+        values and the trace events from its records. It stops at the end record, or at
+        the point where a recording that was cut short ends.
+
+RETURNS
+
+        Returns false if the file cannot be read, is not a recording, or is of a later
+        version of the format; otherwise true.
+*/
+/**/
+bool Replayer::Load(const std::string& a_file)
+{
+    std::ifstream file(a_file, std::ios::in | std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    const std::string data = contents.str();
+
+    size_t position = sizeof(s_magic);
+    uint64_t version, flags;
+    if (data.compare(0, sizeof(s_magic), s_magic, sizeof(s_magic)) != 0 ||
+        !GetVarint(data, position, version) || version > RecordingFormat::VERSION ||
+        !GetVarint(data, position, flags) || position + 8 > data.size()) {
+        return false;
+    }
+    m_hasTrace = (flags & RecordingFormat::RECORD_TRACE) != 0;
+    m_imageHash = 0;
+    for (int byte = 0; byte < 8; byte++) {
+        m_imageHash |= static_cast<uint64_t>(static_cast<unsigned char>(data[position++])) << (byte * 8);
+    }
+
+    while (position < data.size() && !m_ended) {
+        const int tag = static_cast<unsigned char>(data[position++]);
+        uint64_t value, steps;
+        if (tag == RecordingFormat::TAG_INPUT && GetVarint(data, position, value)) {
+            m_inputs.push_back(UnZigZag(value));
+        }
+        else if (tag == RecordingFormat::TAG_TRACE && GetVarint(data, position, value) && value <= data.size() - position) {
+            m_trace.append(data, position, value);
+            position += value;
+        }
+        else if (tag == RecordingFormat::TAG_END && GetVarint(data, position, value) && GetVarint(data, position, steps)) {
+            m_recordedResult = value != 0;
+            m_ended = true;
+        }
+        else {
+            // A damaged or truncated record - keep what came before it
+            break;
+        }
+    }
+    return true;
+}
+
+// Supplies the next recorded value. Fails where the recorded READ failed.
+bool Replayer::Read(long long& a_value)
+{
+    if (m_inputPosition >= m_inputs.size()) {
+        return false;
+    }
+    a_value = m_inputs[m_inputPosition++];
+    return true;
+}
+
+// Checks an instruction against the next event of the trace.
+void Replayer::Step(int a_location, const DecodedInstruction&)
+{
+    uint64_t event;
+    if (!NextEvent(event)) {
+        return;
+    }
+    const int64_t recorded = m_lastLocation + 1 + UnZigZag(event >> 1);
+    if ((event & 1) != 0) {
+        Diverge("executed the instruction at " + std::to_string(a_location) + " where the recording stored a word");
+        return;
+    }
+    if (recorded != a_location) {
+        Diverge("executed the instruction at " + std::to_string(a_location) + " where the recording executed " + std::to_string(recorded));
+        return;
+    }
+    m_lastLocation = a_location;
+    m_steps++;
+}
+
+// Checks a store against the next event of the trace.
+void Replayer::Store(int a_location, long long a_old, long long a_new)
+{
+    uint64_t event, change;
+    if (!NextEvent(event)) {
+        return;
+    }
+    if ((event & 1) == 0) {
+        Diverge("stored into " + std::to_string(a_location) + " where the recording executed the next instruction");
+        return;
+    }
+    const int64_t recorded = m_lastStore + UnZigZag(event >> 1);
+    if (!GetVarint(m_trace, m_tracePosition, change)) {
+        Diverge("stored into " + std::to_string(a_location) + " after the end of the recorded trace");
+        return;
+    }
+    const long long recordedValue = static_cast<long long>(static_cast<uint64_t>(a_old) + static_cast<uint64_t>(UnZigZag(change)));
+    if (recorded != a_location || recordedValue != a_new) {
+        Diverge("stored " + std::to_string(a_new) + " into " + std::to_string(a_location) + " where the recording stored " +
+            std::to_string(recordedValue) + " into " + std::to_string(recorded));
+        return;
+    }
+    m_lastStore = a_location;
+}
+
+// Takes the next trace event, unless the run has already diverged.
+bool Replayer::NextEvent(uint64_t& a_event)
+{
+    if (!m_divergence.empty()) {
+        return false;
+    }
+    if (!GetVarint(m_trace, m_tracePosition, a_event)) {
+        Diverge("ran on past the end of the recorded trace");
+        return false;
+    }
+    return true;
+}
+
+// Keeps the first divergence only; everything after it follows from it.
+void Replayer::Diverge(const std::string& a_what)
+{
+    if (m_divergence.empty()) {
+        m_divergence = "after " + std::to_string(m_steps) + " instructions the replay " + a_what;
+    }
+}
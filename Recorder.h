@@ -0,0 +1,133 @@
+/*
+These classes record a run of the emulator and replay it later without a console. The Recorder sits between the emulator and its real input
+device and logs every value READ takes; optionally it is also the run's trace sink and logs every instruction executed and every word stored.
+Everything goes into one compact binary file. The Replayer loads that file, feeds the recorded values back to READ, and when the file holds a
+trace it checks the replayed run against it event by event and reports the first point where the two part ways.
+*/
+
+#ifndef _RECORDER_H      // UNIX way of preventing multiple inclusions.
+#define _RECORDER_H
+
+#include <cstdint>      // Fixed-size integers of the file format.
+#include <iostream>     // Recordings are written to a stream.
+#include <string>       // For string objects
+#include <vector>       // Vector is a container that encapsulates dynamic size arrays.
+#include "Emulator.h"   // The emulator whose runs are recorded.
+
+/*
+The recording format. All numbers are LEB128 varints; signed ones are zigzag encoded first.
+
+    header     "VCRR", version, flags (RECORD_TRACE if the file holds a trace), 8-byte little-endian hash of the loaded image
+    records    a tag byte and its fields, in the order the events happened:
+                 TAG_INPUT    the signed value READ took
+                 TAG_TRACE    a length, then that many bytes of trace events
+                 TAG_END      1 if the run succeeded, else 0; then the number of instructions traced
+
+A trace event is one varint whose low bit says which kind it is, followed by a second varint for a store:
+
+    step       (signed) location - (previous location + 1), shifted left one
+    store      (signed) location - previous store location, shifted left one, low bit set; then (signed) new value - old value
+
+A program that runs straight through its code costs one byte per instruction, and a store of a counter another two or three.
+*/
+struct RecordingFormat {
+    const static int VERSION = 1;
+    const static int RECORD_TRACE = 1;
+    const static int TAG_INPUT = 1;
+    const static int TAG_TRACE = 2;
+    const static int TAG_END = 3;
+
+    // Returns a hash of the program loaded into a_emu, so that a recording is only replayed against the program it was made with.
+    static uint64_t HashImage(const emulator& a_emu);
+};
+
+// Records the input of a run, and optionally its trace, while passing READ through to the real input device.
+class Recorder : public InputDevice, public TraceSink {
+
+public:
+
+    // Constructor. The recording is written to a_out. READ takes its values from a_input. If a_trace is true the recorder
+    // must also be set as the emulator's trace sink. a_imageHash identifies the program, see RecordingFormat::HashImage.
+    Recorder(std::ostream& a_out, InputDevice& a_input, bool a_trace, uint64_t a_imageHash);
+
+    bool Read(long long& a_value) override;
+    bool WouldBlock() const override { return m_input.WouldBlock(); }
+
+    void Step(int a_location, const DecodedInstruction& a_inst) override;
+    void Store(int a_location, long long a_old, long long a_new) override;
+
+    // Writes out the rest of the trace and the end record. a_result is the result of the run.
+    void Finish(bool a_result);
+
+private:
+
+    // Writes the trace events collected so far as one TAG_TRACE record.
+    void FlushTrace();
+
+    // Trace events collected before they are written as a record.
+    const static size_t BLOCK_SIZE = 64 * 1024;
+
+    std::ostream& m_out;
+    InputDevice& m_input;
+    std::string m_block;            // Trace events not yet written.
+    int m_lastLocation = 99;        // Location of the last step, so the first one at 100 encodes as 0.
+    int m_lastStore = 0;            // Location of the last store.
+    long long m_steps = 0;          // Instructions traced.
+};
+
+// Replays a recording: supplies the recorded input and, if there is a trace, checks the run against it.
+class Replayer : public InputDevice, public TraceSink {
+
+public:
+
+    // Loads a recording. Returns false if the file cannot be read or is not a recording. A recording that stops
+    // short of its end record, as one from a run that crashed does, is loaded up to where it stops.
+    bool Load(const std::string& a_file);
+
+    // Returns true if the recording holds a trace. The replayer must then be set as the emulator's trace sink.
+    bool HasTrace() const { return m_hasTrace; }
+
+    // Returns the hash of the program the recording was made with.
+    uint64_t GetImageHash() const { return m_imageHash; }
+
+    // Returns true if the recording has its end record, and sets a_result to the result of the recorded run.
+    bool GetRecordedResult(bool& a_result) const { a_result = m_recordedResult; return m_ended; }
+
+    bool Read(long long& a_value) override;
+
+    void Step(int a_location, const DecodedInstruction& a_inst) override;
+    void Store(int a_location, long long a_old, long long a_new) override;
+
+    // Returns true if the replayed run has followed the trace so far and, once the run is over, used all of it.
+    bool IsFaithful() const { return m_divergence.empty() && m_tracePosition == m_trace.size(); }
+
+    // Describes where the replayed run left the trace, or returns an empty string if it has not.
+    const std::string& GetDivergence() const { return m_divergence; }
+
+    // Number of instructions checked against the trace.
+    long long GetSteps() const { return m_steps; }
+
+private:
+
+    // Reads the next trace event. Returns false, recording a divergence, if the trace has ended.
+    bool NextEvent(uint64_t& a_event);
+
+    // Records the first divergence.
+    void Diverge(const std::string& a_what);
+
+    std::vector<long long> m_inputs;
+    size_t m_inputPosition = 0;
+    std::string m_trace;            // The trace events of every TAG_TRACE record, joined.
+    size_t m_tracePosition = 0;
+    bool m_hasTrace = false;
+    uint64_t m_imageHash = 0;
+    bool m_ended = false;
+    bool m_recordedResult = false;
+
+    int m_lastLocation = 99;
+    int m_lastStore = 0;
+    long long m_steps = 0;
+    std::string m_divergence;
+};
+
+#endif
@@ -0,0 +1,121 @@
+//
+//  Implementation of the time-slicing scheduler.
+//
+#include "stdafx.h"
+#include "Scheduler.h"
+#include <chrono>
+
+// Adds an emulator as a ready task. Its program starts from the beginning on its first turn.
+size_t Scheduler::Add(emulator& a_emu)
+{
+    a_emu.ResetRun();
+    m_tasks.push_back({ &a_emu, TASK_READY, 0 });
+    m_ready.push_back(m_tasks.size() - 1);
+    return m_tasks.size() - 1;
+}
+
+/**/
+/*
+size_t Scheduler::RunUntilIdle()
+
+NAME
+
+        Scheduler::RunUntilIdle - Runs the ready tasks.
+
+SYNOPSIS
+
+        size_t Scheduler::RunUntilIdle();
+
+DESCRIPTION
+
+        This method takes the task at the front of the ready queue, gives it one turn and,
+        if it is still ready afterwards, puts it at the back. It stops when no task is
+        ready: every task has finished, been killed, or is waiting for I/O.
+
+RETURNS
+
+        Returns the number of tasks waiting for I/O.
+*/
+/**/
+size_t Scheduler::RunUntilIdle()
+{
+    while (!m_ready.empty()) {
+        size_t task = m_ready.front();
+        m_ready.pop_front();
+        RunTurn(task);
+        if (m_tasks[task].state == TASK_READY) {
+            m_ready.push_back(task);
+        }
+    }
+
+    size_t waiting = 0;
+    for (const Task& task : m_tasks) {
+        waiting += task.state == TASK_WAITING;
+    }
+    return waiting;
+}
+
+// Makes a waiting task ready again.
+void Scheduler::Wake(size_t a_task)
+{
+    if (m_tasks[a_task].state == TASK_WAITING) {
+        m_tasks[a_task].state = TASK_READY;
+        m_ready.push_back(a_task);
+    }
+}
+
+/**/
+/*
+void Scheduler::RunTurn(size_t a_task)
+
+NAME
+
+        Scheduler::RunTurn - Gives a task one turn.
+
+SYNOPSIS
+
+        void Scheduler::RunTurn(size_t a_task);
+            a_task    --> The task to run.
+
+DESCRIPTION
+
+        This method runs the task's emulator for one slice, or less if that would take it
+        past its instruction limit, and sets the task's state from the status returned.
+        A task that is still unfinished when it has reached its instruction or time limit
+        is killed by the watchdog.
+
+*/
+/**/
+void Scheduler::RunTurn(size_t a_task)
+{
+    Task& task = m_tasks[a_task];
+
+    long long budget = m_slice;
+    if (m_maxInstructions > 0 && m_maxInstructions - task.emu->GetRetired() < budget) {
+        budget = m_maxInstructions - task.emu->GetRetired();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    emulator::RunStatus status = task.emu->Run(budget);
+    task.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    switch (status) {
+    case emulator::STATUS_HALTED:
+        task.state = TASK_HALTED;
+        return;
+    case emulator::STATUS_FAULTED:
+        task.state = TASK_FAULTED;
+        return;
+    case emulator::STATUS_WAITING:
+        task.state = TASK_WAITING;
+        break;
+    case emulator::STATUS_BUDGET:
+        task.state = TASK_READY;
+        break;
+    }
+
+    if ((m_maxInstructions > 0 && task.emu->GetRetired() >= m_maxInstructions) ||
+        (m_maxSeconds > 0 && task.seconds >= m_maxSeconds)) {
+        task.state = TASK_KILLED;
+    }
+}
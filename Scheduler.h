@@ -0,0 +1,68 @@
+/*
+The Scheduler class time-slices many emulators on one thread. Each emulator is a task that is given a fixed instruction budget per turn with
+emulator::Run and then goes to the back of the line, so a long job cannot starve the others. A watchdog limits each task's total instructions
+and wall-clock time; a task that exceeds either is killed, which only stops that emulator, not the process.
+*/
+
+#ifndef _SCHEDULER_H      // UNIX way of preventing multiple inclusions.
+#define _SCHEDULER_H
+
+#include <deque>        // The queue of ready tasks.
+#include <vector>       // Vector is a container that encapsulates dynamic size arrays.
+#include "Emulator.h"   // The tasks are emulators.
+
+// Scheduler runs emulators round-robin in instruction-budgeted slices, under a watchdog.
+class Scheduler {
+
+public:
+
+    // Instructions a task may execute per turn unless another slice is given.
+    const static long long DEFAULT_SLICE = 100'000;
+
+    // The state of a task.
+    enum TaskState {
+        TASK_READY,     // Waiting for its next turn.
+        TASK_WAITING,   // Waiting for input or for room to write. Wake makes it ready again.
+        TASK_HALTED,    // The program finished.
+        TASK_FAULTED,   // The program failed.
+        TASK_KILLED     // Stopped by the watchdog.
+    };
+
+    // A scheduled emulator.
+    struct Task {
+        emulator* emu;              // The emulator; owned by the caller.
+        TaskState state;
+        double seconds;             // Time spent running the task.
+    };
+
+    // Constructor. a_slice is the instruction budget of each turn.
+    explicit Scheduler(long long a_slice = DEFAULT_SLICE) : m_slice(a_slice) {}
+
+    // Sets the watchdog limits: the most instructions and seconds a task may use in all. 0 means no limit.
+    void SetWatchdog(long long a_maxInstructions, double a_maxSeconds) { m_maxInstructions = a_maxInstructions; m_maxSeconds = a_maxSeconds; }
+
+    // Adds an emulator, ready to start its program. Returns the task's index.
+    size_t Add(emulator& a_emu);
+
+    // Gives ready tasks turns, round-robin, until none is ready. Returns the number of tasks left waiting.
+    size_t RunUntilIdle();
+
+    // Makes a waiting task ready again, typically after input has been supplied for it or its output drained.
+    void Wake(size_t a_task);
+
+    // Returns a task.
+    const Task& GetTask(size_t a_task) const { return m_tasks[a_task]; }
+
+private:
+
+    // Gives task a_task one turn and updates its state.
+    void RunTurn(size_t a_task);
+
+    long long m_slice;
+    long long m_maxInstructions = 0;
+    double m_maxSeconds = 0;
+    std::vector<Task> m_tasks;
+    std::deque<size_t> m_ready;     // Ready tasks in the order they will run.
+};
+
+#endif
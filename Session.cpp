@@ -0,0 +1,244 @@
+//
+//  Implementation of coroutine-driven emulator sessions and their event loop.
+//
+#include "stdafx.h"
+#include "Session.h"
+
+// Queues a machine to be resumed and wakes the loop if it is sleeping.
+void EventLoop::Post(std::coroutine_handle<> a_machine)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_ready.push_back(a_machine);
+    }
+    m_posted.notify_one();
+}
+
+// Resumes ready machines until there are none.
+void EventLoop::RunUntilIdle()
+{
+    while (std::coroutine_handle<> machine = Next(false)) {
+        machine.resume();
+    }
+}
+
+// Resumes ready machines, sleeping while there are none, until Stop is called.
+void EventLoop::Run()
+{
+    while (std::coroutine_handle<> machine = Next(true)) {
+        machine.resume();
+    }
+}
+
+// Asks Run to return once it has nothing left to resume.
+void EventLoop::Stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stopping = true;
+    }
+    m_posted.notify_all();
+}
+
+/**/
+/*
+std::coroutine_handle<> EventLoop::Next(bool a_wait)
+
+NAME
+
+        EventLoop::Next - Takes the next machine to resume.
+
+SYNOPSIS
+
+        std::coroutine_handle<> EventLoop::Next(bool a_wait);
+            a_wait    --> True to sleep until a machine is posted or Stop is called.
+
+DESCRIPTION
+
+        This method removes the oldest machine from the ready queue. Machines are resumed
+        in the order they were posted, so a machine that yields after its slice goes behind
+        every other ready machine.
+
+RETURNS
+
+        Returns the machine, or a null handle if none is ready (and, when waiting, Stop has
+        been called).
+*/
+/**/
+std::coroutine_handle<> EventLoop::Next(bool a_wait)
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+    if (a_wait) {
+        m_posted.wait(guard, [this] { return !m_ready.empty() || m_stopping; });
+    }
+    if (m_ready.empty()) {
+        return nullptr;
+    }
+    std::coroutine_handle<> machine = m_ready.front();
+    m_ready.pop_front();
+    return machine;
+}
+
+/**/
+/*
+Session::Session(EventLoop& a_loop, const emulator& a_image)
+
+NAME
+
+        Session::Session - Constructor for the Session class.
+
+SYNOPSIS
+
+        Session::Session(EventLoop& a_loop, const emulator& a_image);
+            a_loop     --> The loop that will resume the machine.
+            a_image    --> An emulator holding the loaded program.
+
+DESCRIPTION
+
+        This constructor copies the loaded program into the session's own emulator,
+        connects its READ and WRITE to the session's queues and creates the coroutine
+        that runs it. The machine does not run until Start is called.
+
+*/
+/**/
+Session::Session(EventLoop& a_loop, const emulator& a_image)
+    : m_loop(a_loop), m_emu(a_image)
+{
+    m_emu.SetDevices(*this, *this);
+    m_task = Drive();
+}
+
+// Destroys the coroutine.
+Session::~Session()
+{
+    m_task.handle.destroy();
+}
+
+// Posts the machine to its loop for the first time.
+void Session::Start()
+{
+    m_loop.Post(m_task.handle);
+}
+
+/**/
+/*
+MachineTask Session::Drive()
+
+NAME
+
+        Session::Drive - The coroutine that runs the session's emulator.
+
+SYNOPSIS
+
+        MachineTask Session::Drive();
+
+DESCRIPTION
+
+        This coroutine calls emulator::Run one slice at a time. When the program is waiting
+        for input or for room to write, the coroutine suspends until Feed or TakeOutput
+        wakes it; when the slice simply ran out it yields to the other machines on the loop.
+        It finishes when the program halts or faults.
+
+*/
+/**/
+MachineTask Session::Drive()
+{
+    for (;;) {
+        emulator::RunStatus status = m_emu.Run(SLICE);
+        if (status == emulator::STATUS_HALTED || status == emulator::STATUS_FAULTED) {
+            m_status = status;
+            m_finished = true;
+            co_return;
+        }
+        if (status == emulator::STATUS_WAITING) {
+            co_await WaitForWake{ this };
+        }
+        else {
+            co_await Yield{ &m_loop };
+        }
+    }
+}
+
+// Parks the machine until the next wake-up, or reposts it at once if one arrived while it was running.
+void Session::WaitForWake::await_suspend(std::coroutine_handle<> a_machine)
+{
+    std::unique_lock<std::mutex> guard(session->m_lock);
+    if (session->m_wakePending) {
+        session->m_wakePending = false;
+        guard.unlock();
+        session->m_loop.Post(a_machine);
+        return;
+    }
+    session->m_waiting = a_machine;
+}
+
+// Posts a parked machine, or records the wake-up for the next time it parks. Called with m_lock held.
+void Session::Wake()
+{
+    if (m_waiting) {
+        m_loop.Post(m_waiting);
+        m_waiting = nullptr;
+    }
+    else {
+        m_wakePending = true;
+    }
+}
+
+// Adds a value for READ.
+void Session::Feed(long long a_value)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_input.push_back(a_value);
+    Wake();
+}
+
+// Ends the input.
+void Session::CloseInput()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_inputClosed = true;
+    Wake();
+}
+
+// Hands over the values written so far.
+std::vector<long long> Session::TakeOutput()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    std::vector<long long> output;
+    output.swap(m_output);
+    Wake();
+    return output;
+}
+
+// Takes the next input value for READ.
+bool Session::Read(long long& a_value)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (m_input.empty()) {
+        return false;
+    }
+    a_value = m_input.front();
+    m_input.pop_front();
+    return true;
+}
+
+// READ waits while there is no input and more may come.
+bool Session::WouldBlock() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_input.empty() && !m_inputClosed;
+}
+
+// Queues a value written by WRITE.
+void Session::Write(long long a_value)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_output.push_back(a_value);
+}
+
+// WRITE waits while the output queue is at capacity.
+bool Session::IsFull() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_output.size() >= OUTPUT_CAPACITY;
+}
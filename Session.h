@@ -0,0 +1,145 @@
+/*
+These classes let one thread drive many emulated machines as interactive sessions. Each Session runs its emulator inside a C++20 coroutine that
+executes a slice of instructions at a time. The coroutine suspends when the program reaches a READ with no input or a WRITE with no room for
+output, and also between slices so that busy machines take turns. An EventLoop resumes suspended machines as soon as they can make progress:
+Feed supplies input and TakeOutput makes room for output, from any thread, and the machine is posted back to its loop. A small pool of threads,
+each running an EventLoop, can therefore serve thousands of sessions.
+*/
+
+#ifndef _SESSION_H      // UNIX way of preventing multiple inclusions.
+#define _SESSION_H
+
+#include <atomic>               // Whether a session has finished is read from other threads.
+#include <condition_variable>   // The event loop sleeps until work is posted.
+#include <coroutine>            // Machines run as coroutines.
+#include <deque>                // Queues of input, output and ready machines.
+#include <mutex>                // Sessions are fed from other threads.
+#include <vector>               // Vector is a container that encapsulates dynamic size arrays.
+#include "Emulator.h"           // Each session runs its own emulator.
+
+// The coroutine type of a running machine. It starts suspended and stays suspended at its end until destroyed.
+struct MachineTask {
+
+    struct promise_type {
+        MachineTask get_return_object() { return MachineTask{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() { }
+        void unhandled_exception() { throw; }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Resumes the machines that are ready to run, on the thread that calls Run or RunUntilIdle.
+class EventLoop {
+
+public:
+
+    // Queues a suspended machine to be resumed. May be called from any thread.
+    void Post(std::coroutine_handle<> a_machine);
+
+    // Resumes posted machines until none is left ready.
+    void RunUntilIdle();
+
+    // Resumes posted machines, sleeping while there are none, until Stop is called.
+    void Run();
+
+    // Makes Run return once the machines already posted have been resumed. May be called from any thread.
+    void Stop();
+
+private:
+
+    // Takes the next ready machine, waiting for one if a_wait is true. Returns a null handle if there is none.
+    std::coroutine_handle<> Next(bool a_wait);
+
+    std::mutex m_lock;
+    std::condition_variable m_posted;
+    std::deque<std::coroutine_handle<>> m_ready;
+    bool m_stopping = false;
+};
+
+// An interactive session: an emulator whose READ and WRITE are served by queues that other code fills and drains.
+class Session : private InputDevice, private OutputDevice {
+
+public:
+
+    // Instructions run before a busy machine lets the others on its loop have a turn.
+    const static long long SLICE = 100'000;
+
+    // Output values held before a WRITE waits for TakeOutput.
+    const static size_t OUTPUT_CAPACITY = 4096;
+
+    // Constructor. The session runs a copy of a_image on a_loop.
+    Session(EventLoop& a_loop, const emulator& a_image);
+
+    // Destructor. The session must not be running, i.e. its loop must not be resuming it.
+    ~Session();
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    // Posts the machine to its loop so that it starts running.
+    void Start();
+
+    // Supplies a value for READ and wakes the machine if it is waiting. May be called from any thread.
+    void Feed(long long a_value);
+
+    // Marks the end of the input; a READ after the last value then fails. May be called from any thread.
+    void CloseInput();
+
+    // Removes and returns the values written so far, waking the machine if it was waiting for room. May be called from any thread.
+    std::vector<long long> TakeOutput();
+
+    // Returns true once the program has halted or faulted.
+    bool IsFinished() const { return m_finished; }
+
+    // Returns the final status of the program. Only meaningful once IsFinished is true.
+    emulator::RunStatus GetStatus() const { return m_status; }
+
+private:
+
+    // Suspends the machine until Wake is called, unless a wake-up has arrived since it last ran.
+    struct WaitForWake {
+        Session* session;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> a_machine);
+        void await_resume() const noexcept { }
+    };
+
+    // Suspends the machine and posts it straight back to the end of its loop's queue.
+    struct Yield {
+        EventLoop* loop;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> a_machine) { loop->Post(a_machine); }
+        void await_resume() const noexcept { }
+    };
+
+    // The coroutine that runs the emulator.
+    MachineTask Drive();
+
+    // Posts the machine if it is suspended in WaitForWake, otherwise remembers the wake-up. Called with m_lock held.
+    void Wake();
+
+    // The devices the emulator uses. Called on the loop's thread while the machine runs.
+    bool Read(long long& a_value) override;
+    bool WouldBlock() const override;
+    void Write(long long a_value) override;
+    bool IsFull() const override;
+
+    EventLoop& m_loop;
+    emulator m_emu;
+    MachineTask m_task;
+
+    mutable std::mutex m_lock;                  // Guards everything below.
+    std::deque<long long> m_input;
+    bool m_inputClosed = false;
+    std::vector<long long> m_output;
+    std::coroutine_handle<> m_waiting;          // The machine while it is suspended in WaitForWake.
+    bool m_wakePending = false;                 // A wake-up arrived while the machine was not waiting.
+
+    std::atomic<bool> m_finished{ false };
+    emulator::RunStatus m_status = emulator::STATUS_BUDGET;
+};
+
+#endif
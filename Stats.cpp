@@ -0,0 +1,73 @@
+//
+//  Implementation of the emulator's execution statistics.
+//
+#include "stdafx.h"
+#include "Stats.h"
+#include "Isa.h"
+
+// Clears every counter.
+void ExecutionStats::Reset()
+{
+    *this = ExecutionStats();
+}
+
+/**/
+/*
+void ExecutionStats::WriteJson(std::ostream& a_out) const
+
+NAME
+
+        ExecutionStats::WriteJson - Writes the counters as JSON.
+
+SYNOPSIS
+
+        void ExecutionStats::WriteJson(std::ostream& a_out) const;
+            a_out    --> The stream to write to.
+
+DESCRIPTION
+
+        This method writes a single JSON object holding the number of instructions retired,
+        the run time in seconds, the MIPS figure, a count for every opcode that was executed
+        (keyed by its mnemonic, or by its number for opcodes the assembler never emits) and
+        the taken and not-taken counts of the four branch instructions.
+
+*/
+/**/
+void ExecutionStats::WriteJson(std::ostream& a_out) const
+{
+    // Opcodes are named by their mnemonics in the instruction set table, and 0 as a no-op.
+    auto name = [](int a_opcode) { return a_opcode == 0 ? "nop" : Isa::Mnemonic(a_opcode); };
+
+    a_out << "{\n";
+    a_out << "  \"instructions\": " << m_retired << ",\n";
+    a_out << "  \"seconds\": " << m_seconds << ",\n";
+    a_out << "  \"mips\": " << GetMips() << ",\n";
+
+    a_out << "  \"opcodes\": {";
+    const char* separator = "";
+    for (int opcode = 0; opcode < OPCODES; opcode++) {
+        if (m_opcodes[opcode] == 0) {
+            continue;
+        }
+        a_out << separator << "\n    \"";
+        if (name(opcode) != nullptr) {
+            a_out << name(opcode);
+        }
+        else {
+            a_out << opcode;
+        }
+        a_out << "\": " << m_opcodes[opcode];
+        separator = ",";
+    }
+    a_out << "\n  },\n";
+
+    a_out << "  \"branches\": {";
+    separator = "";
+    for (int opcode = FIRST_BRANCH; opcode <= LAST_BRANCH; opcode++) {
+        a_out << separator << "\n    \"" << name(opcode) << "\": { \"taken\": " << GetTaken(opcode)
+              << ", \"not_taken\": " << GetNotTaken(opcode) << " }";
+        separator = ",";
+    }
+    a_out << "\n  }\n";
+    a_out << "}\n";
+}
@@ -0,0 +1,78 @@
+/*
+The ExecutionStats class holds the counters the emulator keeps while it runs a program: instructions retired, the count for each opcode, taken
+and not-taken counts for each branch instruction, and the wall-clock time of the run. The counters are only compiled in when VC_STATS is defined;
+without it the VC_STATS_COUNT hook expands to nothing and the emulator carries no ExecutionStats at all.
+*/
+
+#ifndef _STATS_H      // UNIX way of preventing multiple inclusions.
+#define _STATS_H
+
+#include <iostream> // The statistics are written to a stream.
+
+// Define VC_STATS to build the emulator with execution statistics. Without it VC_STATS_COUNT expands
+// to nothing, so the engines are compiled exactly as if the counters did not exist.
+#ifdef VC_STATS
+#define VC_STATS_COUNT(inst) m_stats.Count((inst).opcode, m_memory[(inst).operand2])
+#else
+#define VC_STATS_COUNT(inst) ((void)0)
+#endif
+
+// Counters collected over one run of the emulator.
+class ExecutionStats {
+
+public:
+
+    // Number of opcode values a decoded instruction can hold.
+    const static int OPCODES = 100;
+
+    // First and last of the branch opcodes (BRANCH, BRANCH MINUS, BRANCH ZERO, BRANCH POSITIVE).
+    const static int FIRST_BRANCH = 9;
+    const static int LAST_BRANCH = 12;
+
+    // Clears every counter.
+    void Reset();
+
+    // Counts one executed instruction. a_condition is the word its second operand addresses, which decides
+    // whether a conditional branch is taken.
+    void Count(int a_opcode, long long a_condition)
+    {
+        m_retired++;
+        m_opcodes[a_opcode]++;
+        if (a_opcode >= FIRST_BRANCH && a_opcode <= LAST_BRANCH) {
+            bool taken = a_opcode == 9
+                || (a_opcode == 10 && a_condition < 0)
+                || (a_opcode == 11 && a_condition == 0)
+                || (a_opcode == 12 && a_condition > 0);
+            m_taken[a_opcode - FIRST_BRANCH] += taken;
+        }
+    }
+
+    // Records the wall-clock time of the run.
+    void SetSeconds(double a_seconds) { m_seconds = a_seconds; }
+
+    // Total instructions retired.
+    long long GetRetired() const { return m_retired; }
+
+    // Instructions retired with opcode a_opcode.
+    long long GetOpcodeCount(int a_opcode) const { return m_opcodes[a_opcode]; }
+
+    // Times branch opcode a_opcode was taken, and not taken.
+    long long GetTaken(int a_opcode) const { return m_taken[a_opcode - FIRST_BRANCH]; }
+    long long GetNotTaken(int a_opcode) const { return m_opcodes[a_opcode] - m_taken[a_opcode - FIRST_BRANCH]; }
+
+    // Wall-clock time of the run in seconds, and the millions of instructions retired per second.
+    double GetSeconds() const { return m_seconds; }
+    double GetMips() const { return m_seconds > 0 ? m_retired / m_seconds / 1e6 : 0; }
+
+    // Writes the counters as a JSON object.
+    void WriteJson(std::ostream& a_out) const;
+
+private:
+
+    long long m_retired = 0;
+    long long m_opcodes[OPCODES] = {};
+    long long m_taken[LAST_BRANCH - FIRST_BRANCH + 1] = {};
+    double m_seconds = 0;
+};
+
+#endif
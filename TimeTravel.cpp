@@ -0,0 +1,310 @@
+//
+//  Implementation of the time-travel debugger.
+//
+#include "stdafx.h"
+#include "TimeTravel.h"
+#include <climits>
+
+/**/
+/*
+TimeTravel::TimeTravel(emulator& a_emu, InputDevice& a_input, OutputDevice& a_output, long long a_interval, size_t a_undoLimit)
+
+NAME
+
+        TimeTravel::TimeTravel - Constructor for the TimeTravel class.
+
+SYNOPSIS
+
+        TimeTravel::TimeTravel(emulator& a_emu, InputDevice& a_input, OutputDevice& a_output, long long a_interval,
+            size_t a_undoLimit);
+            a_emu         --> The emulator, with the program loaded.
+            a_input       --> The device READ takes its values from.
+            a_output      --> The device WRITE passes its values to.
+            a_interval    --> Instructions between checkpoints.
+            a_undoLimit   --> Instructions kept on the undo log.
+
+DESCRIPTION
+
+        This constructor connects the emulator to the history devices, starts the program
+        over without executing anything, and takes the checkpoint at the start of the
+        program, which is never dropped.
+
+*/
+/**/
+TimeTravel::TimeTravel(emulator& a_emu, InputDevice& a_input, OutputDevice& a_output, long long a_interval, size_t a_undoLimit)
+    : m_emu(a_emu), m_input(a_input), m_output(a_output), m_interval(a_interval > 0 ? a_interval : DEFAULT_INTERVAL),
+      m_undoLimit(a_undoLimit), m_nextCheckpoint(0)
+{
+    m_emu.SetDevices(m_input, m_output);
+    m_emu.ResetRun();
+    m_emu.Run(0);
+    TakeCheckpoint();
+}
+
+// Runs forward, stopping at the end of the program.
+emulator::RunStatus TimeTravel::Forward(long long a_count)
+{
+    const long long position = GetPosition();
+    return RunTo(a_count > LLONG_MAX - position ? LLONG_MAX : position + a_count);
+}
+
+// Goes back, stopping at the start of the program.
+bool TimeTravel::Back(long long a_count)
+{
+    if (GetPosition() == 0) {
+        return false;
+    }
+    JumpTo(a_count > GetPosition() ? 0 : GetPosition() - a_count);
+    return true;
+}
+
+/**/
+/*
+emulator::RunStatus TimeTravel::JumpTo(long long a_position)
+
+NAME
+
+        TimeTravel::JumpTo - Moves to an instruction count.
+
+SYNOPSIS
+
+        emulator::RunStatus TimeTravel::JumpTo(long long a_position);
+            a_position    --> The number of instructions executed at the point to move to.
+
+DESCRIPTION
+
+        Going forward simply runs the program on. Going back to a point that is still on
+        the undo log undoes the instructions after it one at a time. Going back any further
+        restores the latest checkpoint that leaves the whole undo log to be run again before
+        a_position, then runs forward to it; the jump costs at most one checkpoint interval
+        at full speed and one undo log of single steps, and leaves the point just reached
+        ready to be stepped back from.
+
+RETURNS
+
+        Returns the status of the run at the point reached.
+*/
+/**/
+emulator::RunStatus TimeTravel::JumpTo(long long a_position)
+{
+    if (a_position < 0) {
+        a_position = 0;
+    }
+    const long long position = GetPosition();
+    if (a_position >= position) {
+        return RunTo(a_position);
+    }
+    if (position - a_position <= static_cast<long long>(m_undo.size())) {
+        while (GetPosition() > a_position) {
+            Undo();
+        }
+        return m_status;
+    }
+    RestoreCheckpoint(a_position - static_cast<long long>(m_undoLimit));
+    return RunTo(a_position);
+}
+
+// Runs at full speed up to the stretch the undo log covers, then single steps.
+emulator::RunStatus TimeTravel::RunTo(long long a_position)
+{
+    if (m_status == emulator::STATUS_WAITING) {
+        m_status = emulator::STATUS_BUDGET;
+    }
+    if (m_status != emulator::STATUS_BUDGET) {
+        return m_status;
+    }
+    const long long logFrom = a_position - static_cast<long long>(m_undoLimit);
+    if (GetPosition() < logFrom) {
+        RunFast(logFrom);
+        if (m_status == emulator::STATUS_HALTED || m_status == emulator::STATUS_FAULTED) {
+            // The program ended before the stretch that was to be logged. Run up to the end again, logging the
+            // instructions before it, so that the end can be stepped back from like any other point.
+            a_position = GetPosition();
+            RestoreCheckpoint(a_position - static_cast<long long>(m_undoLimit));
+            RunFast(a_position - static_cast<long long>(m_undoLimit));
+        }
+    }
+    while (GetPosition() < a_position && m_status == emulator::STATUS_BUDGET) {
+        StepLogged();
+    }
+    return m_status;
+}
+
+// Runs the emulator in slices that end at each checkpoint that is due.
+void TimeTravel::RunFast(long long a_position)
+{
+    if (GetPosition() < a_position) {
+        m_undo.clear();
+    }
+    while (GetPosition() < a_position && m_status == emulator::STATUS_BUDGET) {
+        if (m_nextCheckpoint <= GetPosition()) {
+            // Single steps went past the point the checkpoint was due at
+            TakeCheckpoint();
+        }
+        const long long stop = a_position < m_nextCheckpoint ? a_position : m_nextCheckpoint;
+        m_status = m_emu.Run(stop - GetPosition());
+        if (m_status == emulator::STATUS_BUDGET && GetPosition() == m_nextCheckpoint) {
+            TakeCheckpoint();
+        }
+    }
+}
+
+// Notes the word the instruction is about to store into before executing it.
+void TimeTravel::StepLogged()
+{
+    const int location = m_emu.GetRunLocation();
+    UndoEntry entry = { location, -1, 0, m_input.m_position, m_output.m_position };
+    if (location >= 100 && location < emulator::MEMSZ) {
+        const DecodedInstruction inst = emulator::Decode(m_emu.GetMemory()[location - 100]);
+        const bool stores = (inst.opcode >= 1 && inst.opcode <= 5) || inst.opcode == 7;
+        if (stores && inst.operand1 >= 0 && inst.operand1 < emulator::MEMSZ) {
+            entry.stored = inst.operand1;
+            entry.old = m_emu.GetMemory()[inst.operand1];
+        }
+    }
+    m_status = m_emu.Run(1);
+    if (m_status == emulator::STATUS_WAITING) {
+        return;
+    }
+    m_undo.push_back(entry);
+    if (m_undo.size() > m_undoLimit) {
+        m_undo.pop_front();
+    }
+    m_lastLocation = location;
+    if (m_status == emulator::STATUS_BUDGET && GetPosition() >= m_nextCheckpoint) {
+        TakeCheckpoint();
+    }
+}
+
+// Puts back the word the last instruction stored into and the position before it.
+void TimeTravel::Undo()
+{
+    const UndoEntry& entry = m_undo.back();
+    if (entry.stored >= 0) {
+        m_emu.PokeMemory(entry.stored, entry.old);
+    }
+    m_emu.SetRunPosition(entry.location, GetPosition() - 1);
+    m_input.m_position = entry.inputs;
+    m_output.m_position = entry.outputs;
+    m_status = emulator::STATUS_BUDGET;
+    m_undo.pop_back();
+}
+
+/**/
+/*
+void TimeTravel::TakeCheckpoint()
+
+NAME
+
+        TimeTravel::TakeCheckpoint - Records the current point.
+
+SYNOPSIS
+
+        void TimeTravel::TakeCheckpoint();
+
+DESCRIPTION
+
+        This method records the position of the run and its memory. Each page of memory
+        that is the same as in the previous checkpoint shares that checkpoint's copy, so a
+        checkpoint costs a comparison of memory and a copy of the pages the program wrote
+        to since the last one. A point that already has a checkpoint, because the program
+        is being run again after going back, is not recorded twice.
+
+        When there are more than MAX_CHECKPOINTS, every other one is dropped and the
+        interval doubles, so the memory held stays bounded however long the program runs.
+
+*/
+/**/
+void TimeTravel::TakeCheckpoint()
+{
+    const long long position = GetPosition();
+    m_nextCheckpoint = position + m_interval;
+    if (!m_checkpoints.empty() && m_checkpoints.back().position >= position) {
+        return;
+    }
+
+    Checkpoint checkpoint = { position, m_emu.GetRunLocation(), m_input.m_position, m_output.m_position, {} };
+    const Checkpoint* previous = m_checkpoints.empty() ? nullptr : &m_checkpoints.back();
+    const EmulatorMemory& memory = m_emu.GetMemory();
+    checkpoint.pages.reserve(emulator::PAGES);
+    for (int page = 0; page < emulator::PAGES; page++) {
+        const int first = page * emulator::PAGE_WORDS;
+        const int count = first + emulator::PAGE_WORDS <= emulator::MEMSZ ? emulator::PAGE_WORDS : emulator::MEMSZ - first;
+        if (previous != nullptr) {
+            const std::vector<long long>& words = *previous->pages[page];
+            int word = 0;
+            while (word < count && memory[first + word] == words[word]) {
+                word++;
+            }
+            if (word == count) {
+                checkpoint.pages.push_back(previous->pages[page]);
+                continue;
+            }
+        }
+        std::shared_ptr<std::vector<long long>> copy = std::make_shared<std::vector<long long>>(count);
+        for (int word = 0; word < count; word++) {
+            (*copy)[word] = memory[first + word];
+        }
+        checkpoint.pages.push_back(copy);
+    }
+    m_checkpoints.push_back(std::move(checkpoint));
+
+    if (m_checkpoints.size() > MAX_CHECKPOINTS) {
+        std::vector<Checkpoint> kept;
+        for (size_t i = 0; i < m_checkpoints.size(); i += 2) {
+            kept.push_back(std::move(m_checkpoints[i]));
+        }
+        m_checkpoints.swap(kept);
+        m_interval *= 2;
+        m_nextCheckpoint = position + m_interval;
+    }
+}
+
+// Writes back only the words that differ from the checkpoint, so that the decoded code stays current.
+void TimeTravel::RestoreCheckpoint(long long a_position)
+{
+    size_t index = m_checkpoints.size() - 1;
+    while (index > 0 && m_checkpoints[index].position > a_position) {
+        index--;
+    }
+    const Checkpoint& checkpoint = m_checkpoints[index];
+    const EmulatorMemory& memory = m_emu.GetMemory();
+    for (int page = 0; page < emulator::PAGES; page++) {
+        const int first = page * emulator::PAGE_WORDS;
+        const std::vector<long long>& words = *checkpoint.pages[page];
+        for (int word = 0; word < static_cast<int>(words.size()); word++) {
+            if (memory[first + word] != words[word]) {
+                m_emu.PokeMemory(first + word, words[word]);
+            }
+        }
+    }
+    m_emu.SetRunPosition(checkpoint.location, checkpoint.position);
+    m_input.m_position = checkpoint.inputs;
+    m_output.m_position = checkpoint.outputs;
+    m_status = emulator::STATUS_BUDGET;
+    m_undo.clear();
+    m_nextCheckpoint = checkpoint.position + m_interval;
+}
+
+// Replays values already read before asking the real device for more.
+bool TimeTravel::HistoryInput::Read(long long& a_value)
+{
+    if (m_position == m_values.size()) {
+        if (!m_input.Read(a_value)) {
+            return false;
+        }
+        m_values.push_back(a_value);
+    }
+    a_value = m_values[m_position++];
+    return true;
+}
+
+// A value produced again after going back was passed on the first time.
+void TimeTravel::HistoryOutput::Write(long long a_value)
+{
+    if (m_position == m_written) {
+        m_output.Write(a_value);
+        m_written++;
+    }
+    m_position++;
+}
@@ -0,0 +1,129 @@
+/*
+The TimeTravel class lets a debugger run a program backwards. While the program runs forward it takes a checkpoint of memory every so many
+instructions; memory is kept in pages and a checkpoint only copies the pages that changed since the one before, sharing the rest. The last
+stretch of instructions before the current position is executed one at a time with an undo log of the words each one stored, so stepping
+back a few instructions just undoes them. Jumping to any earlier instruction count restores the nearest checkpoint before it and runs forward
+from there, which costs about one checkpoint interval however long the program has been running. READ and WRITE go through the class too:
+values read are kept so that running a stretch again reads the same ones, and values written are only passed on the first time.
+*/
+
+#ifndef _TIMETRAVEL_H      // UNIX way of preventing multiple inclusions.
+#define _TIMETRAVEL_H
+
+#include <deque>        // The undo log.
+#include <memory>       // Pages are shared between checkpoints.
+#include <vector>       // Vector is a container that encapsulates dynamic size arrays.
+#include "Emulator.h"   // The emulator that is run backwards.
+
+// TimeTravel runs an emulator forward and backward by instruction count.
+class TimeTravel {
+
+public:
+
+    const static long long DEFAULT_INTERVAL = 1000000;     // Instructions between checkpoints.
+    const static size_t DEFAULT_UNDO_LIMIT = 100000;        // Instructions kept in the undo log.
+    const static size_t MAX_CHECKPOINTS = 256;              // More than this and every other one is dropped.
+
+    // Constructor. a_emu must have its program loaded; it is started over and given the devices of this class, which
+    // pass READ and WRITE on to a_input and a_output. a_interval and a_undoLimit set the cost of going back.
+    TimeTravel(emulator& a_emu, InputDevice& a_input, OutputDevice& a_output, long long a_interval = DEFAULT_INTERVAL,
+        size_t a_undoLimit = DEFAULT_UNDO_LIMIT);
+
+    // Runs forward at most a_count instructions. Returns the status of the run afterwards.
+    emulator::RunStatus Forward(long long a_count);
+
+    // Goes back a_count instructions, or to the start if there are not that many. Returns false if already at the start.
+    bool Back(long long a_count);
+
+    // Moves to the point where a_position instructions have been executed, going forward or back. Going forward stops
+    // early if the program ends. Returns the status of the run afterwards.
+    emulator::RunStatus JumpTo(long long a_position);
+
+    // Returns the number of instructions executed to reach the current point.
+    long long GetPosition() const { return m_emu.GetRetired(); }
+
+    // Returns the status of the run at the current point.
+    emulator::RunStatus GetStatus() const { return m_status; }
+
+    // Returns the location of the next instruction, or, once the program has ended, of the instruction that ended it.
+    int GetLocation() const { return m_status == emulator::STATUS_BUDGET ? m_emu.GetRunLocation() : m_lastLocation; }
+
+    // Returns the number of checkpoints held.
+    size_t GetCheckpointCount() const { return m_checkpoints.size(); }
+
+private:
+
+    typedef std::shared_ptr<const std::vector<long long>> Page;
+
+    // Memory and the position of the run every m_interval instructions.
+    struct Checkpoint {
+        long long position;         // Instructions executed.
+        int location;               // Location of the next instruction.
+        size_t inputs;              // Values READ had taken.
+        size_t outputs;             // Values WRITE had produced.
+        std::vector<Page> pages;    // Memory, in pages of emulator::PAGE_WORDS words; the last is shorter.
+    };
+
+    // What one instruction executed with the undo log changed.
+    struct UndoEntry {
+        int location;               // Location of the instruction.
+        int stored;                 // Location of the word it stored into, or -1.
+        long long old;              // The word before the store.
+        size_t inputs;              // Values READ had taken before it.
+        size_t outputs;             // Values WRITE had produced before it.
+    };
+
+    // READ: takes values from the real device the first time and from the history when a stretch is run again.
+    class HistoryInput : public InputDevice {
+    public:
+        HistoryInput(InputDevice& a_input) : m_input(a_input) {}
+        bool Read(long long& a_value) override;
+        bool WouldBlock() const override { return m_position == m_values.size() && m_input.WouldBlock(); }
+        InputDevice& m_input;
+        std::vector<long long> m_values;    // Every value read so far.
+        size_t m_position = 0;              // Values taken at the current point.
+    };
+
+    // WRITE: passes on only values that have not been written before.
+    class HistoryOutput : public OutputDevice {
+    public:
+        HistoryOutput(OutputDevice& a_output) : m_output(a_output) {}
+        void Write(long long a_value) override;
+        void Flush() override { m_output.Flush(); }
+        bool IsFull() const override { return m_position == m_written && m_output.IsFull(); }
+        OutputDevice& m_output;
+        size_t m_written = 0;               // Values passed on to the real device.
+        size_t m_position = 0;              // Values produced at the current point.
+    };
+
+    // Runs forward to a_position, or until the program ends, with the last m_undoLimit instructions on the undo log.
+    emulator::RunStatus RunTo(long long a_position);
+
+    // Runs forward to a_position, or until the program ends, at full speed, taking checkpoints on the way.
+    void RunFast(long long a_position);
+
+    // Executes one instruction and logs what it changes.
+    void StepLogged();
+
+    // Undoes the last instruction on the undo log.
+    void Undo();
+
+    // Takes a checkpoint of the current point, sharing pages with the previous checkpoint where they are unchanged.
+    void TakeCheckpoint();
+
+    // Puts memory and the run back to the latest checkpoint at or before a_position.
+    void RestoreCheckpoint(long long a_position);
+
+    emulator& m_emu;
+    HistoryInput m_input;
+    HistoryOutput m_output;
+    long long m_interval;
+    size_t m_undoLimit;
+    std::vector<Checkpoint> m_checkpoints;      // In order of position; the first is the start of the program.
+    long long m_nextCheckpoint;                 // Position at which the next checkpoint is due.
+    std::deque<UndoEntry> m_undo;               // The instructions just before the current point, last at the back.
+    emulator::RunStatus m_status = emulator::STATUS_BUDGET;
+    int m_lastLocation = 100;                   // Location of the last instruction executed with the undo log.
+};
+
+#endif
@@ -0,0 +1,12 @@
+//
+//  Implementation of the text trace.
+//
+#include "stdafx.h"
+#include "Trace.h"
+#include "Emulator.h"
+
+// Writes the location and fields of the instruction about to execute.
+void TextTrace::Step(int a_location, const DecodedInstruction& a_inst)
+{
+    m_out << a_location << ' ' << a_inst.opcode << ' ' << a_inst.operand1 << ' ' << a_inst.operand2 << '\n';
+}
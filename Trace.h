@@ -0,0 +1,43 @@
+/*
+A TraceSink receives the instructions a traced run executes and the words they store, in order. The emulator calls it from the traced
+instantiations of its switch engine only, so an untraced run pays nothing for it. TextTrace writes one readable line per instruction; the
+recorder in Recorder.h writes a compact binary trace instead.
+*/
+
+#ifndef _TRACE_H      // UNIX way of preventing multiple inclusions.
+#define _TRACE_H
+
+#include <iostream> // The text trace is written to a stream.
+
+struct DecodedInstruction;
+
+// Receiver of the events of a traced run.
+class TraceSink {
+
+public:
+
+    virtual ~TraceSink() {}
+
+    // Called before the instruction a_inst at a_location executes.
+    virtual void Step(int a_location, const DecodedInstruction& a_inst) = 0;
+
+    // Called when the executing instruction stores a_new into the word at a_location, which held a_old.
+    virtual void Store(int /*a_location*/, long long /*a_old*/, long long /*a_new*/) {}
+};
+
+// A trace written as text: the location, opcode and operands of each instruction on a line of its own.
+class TextTrace : public TraceSink {
+
+public:
+
+    // Constructor. a_out is the stream the lines are written to.
+    explicit TextTrace(std::ostream& a_out) : m_out(a_out) {}
+
+    void Step(int a_location, const DecodedInstruction& a_inst) override;
+
+private:
+
+    std::ostream& m_out;
+};
+
+#endif
@@ -0,0 +1,111 @@
+//
+//  Implementation of the load-time program verifier.
+//
+#include "stdafx.h"
+#include "Verifier.h"
+
+/**/
+/*
+VerifiedProgram Verifier::Verify(const std::vector<DecodedInstruction>& a_decoded, int a_entry, int a_memoryWords)
+
+NAME
+
+        Verifier::Verify - Proves that a program stays inside memory and its own code.
+
+SYNOPSIS
+
+        VerifiedProgram Verifier::Verify(const std::vector<DecodedInstruction>& a_decoded, int a_entry, int a_memoryWords);
+            a_decoded        --> The decoded cells of the loaded program.
+            a_entry          --> The cell at which execution starts.
+            a_memoryWords    --> The number of words of memory.
+
+DESCRIPTION
+
+        This method walks every cell that execution can reach from a_entry, following both
+        the fall-through and the target of each branch, exactly as the emulator would decode
+        them. It fails at the first reachable cell that addresses a word outside memory,
+        branches to a location outside the decoded cells, falls through past the last one,
+        or stores into one of them. Cells that cannot be reached, such as the data after a
+        HALT, are not checked.
+
+        A program that passes is returned with a copy of its decoded cells in which every
+        branch target has been turned from a location into a cell, so the unchecked engine
+        does not subtract 100 on each branch.
+
+RETURNS
+
+        Returns the result of the verification.
+*/
+/**/
+VerifiedProgram Verifier::Verify(const std::vector<DecodedInstruction>& a_decoded, int a_entry, int a_memoryWords)
+{
+    VerifiedProgram result;
+    result.entry = a_entry;
+
+    const int size = static_cast<int>(a_decoded.size());
+    if (a_entry < 0 || a_entry >= size) {
+        result.reason = "the entry point is outside the loaded program";
+        return result;
+    }
+
+    std::vector<bool> reached(size, false);
+    std::vector<int> pending;
+    reached[a_entry] = true;
+    pending.push_back(a_entry);
+
+    while (!pending.empty()) {
+        const int cell = pending.back();
+        pending.pop_back();
+        const DecodedInstruction& inst = a_decoded[cell];
+        const std::string where = "the instruction at " + std::to_string(cell + 100);
+
+        if (inst.operand1 < 0 || inst.operand1 >= a_memoryWords || inst.operand2 < 0 || inst.operand2 >= a_memoryWords) {
+            result.reason = where + " addresses a word outside memory";
+            return result;
+        }
+        if (IsStore(inst.opcode) && inst.operand1 < size) {
+            result.reason = where + " stores into the program's code";
+            return result;
+        }
+
+        // Successors: the branch target, and the next cell unless the instruction never falls through.
+        int successors[2];
+        int count = 0;
+        if (IsBranch(inst.opcode)) {
+            const int target = inst.operand1 - 100;
+            if (target < 0 || target >= size) {
+                result.reason = where + " branches outside the loaded program";
+                return result;
+            }
+            successors[count++] = target;
+        }
+        if (inst.opcode != 9 && inst.opcode != 13) {
+            if (cell + 1 >= size) {
+                result.reason = where + " runs off the end of the loaded program";
+                return result;
+            }
+            successors[count++] = cell + 1;
+        }
+        for (int i = 0; i < count; i++) {
+            if (!reached[successors[i]]) {
+                reached[successors[i]] = true;
+                pending.push_back(successors[i]);
+            }
+        }
+    }
+
+    result.verified = true;
+    result.code = a_decoded;
+    for (DecodedInstruction& inst : result.code) {
+        if (IsBranch(inst.opcode)) {
+            inst.operand1 -= 100;
+        }
+    }
+    return result;
+}
+
+// ADD, SUB, MULT, DIV, COPY and READ write the word their first operand addresses.
+bool Verifier::IsStore(int a_opcode)
+{
+    return (a_opcode >= 1 && a_opcode <= 5) || a_opcode == 7;
+}
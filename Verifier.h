@@ -0,0 +1,40 @@
+/*
+The Verifier class checks a loaded program before it runs. It follows every path execution can take from the entry point through the decoded
+image and proves three things: each instruction it reaches only addresses words inside memory, each branch it reaches lands on a decoded cell, and
+no instruction it reaches stores into the decoded cells, so the code cannot change while it runs. A program that passes can be executed with no
+checks at all beyond those the instructions themselves need (division by zero and the end of input); one that fails runs on the checked engine.
+*/
+
+#ifndef _VERIFIER_H      // UNIX way of preventing multiple inclusions.
+#define _VERIFIER_H
+
+#include <string>       // For string objects
+#include <vector>       // Vector is a container that encapsulates dynamic size arrays.
+#include "Emulator.h"   // The decoded instructions that are verified.
+
+// The result of verifying a program.
+struct VerifiedProgram {
+    bool verified = false;                  // True if the program passed.
+    int entry = 0;                          // Cell at which execution starts.
+    std::string reason;                     // Why the program failed, or empty if it passed.
+    std::vector<DecodedInstruction> code;   // The decoded cells with branch targets turned into cells. Only filled in if the program passed.
+};
+
+// Verifier proves that a decoded program stays inside memory and its own code.
+class Verifier {
+
+public:
+
+    // Verifies the program in a_decoded, which is executed from a_entry. a_memoryWords is the size of memory.
+    static VerifiedProgram Verify(const std::vector<DecodedInstruction>& a_decoded, int a_entry, int a_memoryWords);
+
+private:
+
+    // Returns true if a_opcode is an instruction that stores into the word its first operand addresses.
+    static bool IsStore(int a_opcode);
+
+    // Returns true if a_opcode is one of the branch instructions.
+    static bool IsBranch(int a_opcode) { return a_opcode >= 9 && a_opcode <= 12; }
+};
+
+#endif
@@ -1,23 +1,23 @@
-// stdafx.h : include file for standard system include files,
-// or project specific include files that are used frequently, but
-// are changed infrequently
-//
-
-#pragma once
-
-#define WIN32_LEAN_AND_MEAN		// Exclude rarely-used stuff from Windows headers
-#include <stdio.h>
-#include <tchar.h>
-
-// TODO: reference additional headers your program requires here
-// Standard include files.
-#include <stdio.h>
-#include <iostream>
-#include <stdlib.h>
-#include <string>
-#include <windows.h>
-#include <map>
-#include <vector>
-#include <sstream>
-
-using namespace std;
+// stdafx.h : include file for standard system include files,
+// or project specific include files that are used frequently, but
+// are changed infrequently
+//
+
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN		// Exclude rarely-used stuff from Windows headers
+#include <stdio.h>
+#include <tchar.h>
+
+// TODO: reference additional headers your program requires here
+// Standard include files.
+#include <stdio.h>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <windows.h>
+#include <map>
+#include <vector>
+#include <sstream>
+
+using namespace std;